@@ -25,6 +25,7 @@ namespace qtmir {
 // Converts a mir timestamp (in nanoseconds) to and from a timestamp in milliseconds.
 // Qt system events only work with ulong timestamps. On 32bit archs a ulong is 4 bytes long, so the 64 bit nanoseconds
 // will be truncated and skewed. In order to fix this, we truncate the result by using time since "first call"
+// Types at least 64 bits wide, like ulong on 64bit archs, hold the mir timestamp as is instead, with no start time involved.
 template<typename T>
 T compressTimestamp(std::chrono::nanoseconds timestamp);
 
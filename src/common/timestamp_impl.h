@@ -1,6 +1,8 @@
 #include <QCoreApplication>
 #include <QVariant>
 
+#include <type_traits>
+
 extern "C" {
 	void resetStartTime(std::chrono::nanoseconds timestamp);
 	std::chrono::nanoseconds getStartTime(std::chrono::nanoseconds timestamp, bool allowReset = true);
@@ -10,8 +12,21 @@ namespace qtmir {
 
 typedef std::chrono::duration<ulong, std::milli> Timestamp;
 
+namespace detail {
+
+// Whether T holds any mir timestamp as is, so there's no need for a start time to make it relative to.
+// That's the case of qtmir::Timestamp wherever ulong is 64 bits long.
 template<typename T>
-T compressTimestamp(std::chrono::nanoseconds timestamp)
+using HoldsNativeTimestamp = std::integral_constant<bool, sizeof(typename T::rep) >= sizeof(std::chrono::nanoseconds::rep)>;
+
+template<typename T>
+T compressTimestamp(std::chrono::nanoseconds timestamp, std::true_type)
+{
+    return std::chrono::duration_cast<T>(timestamp);
+}
+
+template<typename T>
+T compressTimestamp(std::chrono::nanoseconds timestamp, std::false_type)
 {
     std::chrono::nanoseconds startTime = getStartTime(timestamp);
 
@@ -28,10 +43,30 @@ T compressTimestamp(std::chrono::nanoseconds timestamp)
 }
 
 template<typename T>
-std::chrono::nanoseconds uncompressTimestamp(T timestamp)
+std::chrono::nanoseconds uncompressTimestamp(T timestamp, std::true_type)
+{
+    return std::chrono::nanoseconds(timestamp);
+}
+
+template<typename T>
+std::chrono::nanoseconds uncompressTimestamp(T timestamp, std::false_type)
 {
     auto tsNS = std::chrono::nanoseconds(timestamp);
     return getStartTime(tsNS, false) + std::chrono::nanoseconds(tsNS);
 }
 
-}
\ No newline at end of file
+} // namespace detail
+
+template<typename T>
+T compressTimestamp(std::chrono::nanoseconds timestamp)
+{
+    return detail::compressTimestamp<T>(timestamp, detail::HoldsNativeTimestamp<T>());
+}
+
+template<typename T>
+std::chrono::nanoseconds uncompressTimestamp(T timestamp)
+{
+    return detail::uncompressTimestamp<T>(timestamp, detail::HoldsNativeTimestamp<T>());
+}
+
+}
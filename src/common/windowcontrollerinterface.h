@@ -55,6 +55,11 @@ public:
 
     virtual void setWindowConfinementRegions(const QVector<QRect> &regions) = 0;
     virtual void setWindowMargins(Mir::Type windowType, const QMargins &margins) = 0;
+
+    // Whether touches may go straight to a focused fullscreen window that shell draws one to one. Shell gets a copy
+    // of them, for gestures. Keys always go through shell. Shell must only allow it while it's not showing anything
+    // on top of that window.
+    virtual void setDirectInputAllowed(bool allowed) = 0;
 };
 
 } // namespace qtmir
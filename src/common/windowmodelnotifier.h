@@ -19,6 +19,7 @@
 
 #include <QObject>
 #include <QPoint>
+#include <QRect>
 #include <QSize>
 #include <QMutex>
 
@@ -62,6 +63,10 @@ struct ExtraWindowInfo {
 
     bool allowClientResize{true};
 
+    // Where shell draws the window one to one, in screen coordinates, while it has active focus.
+    // Null otherwise, in which case its input has to go through shell.
+    QRect directInputArea;
+
     QMutex mutex;
 };
 
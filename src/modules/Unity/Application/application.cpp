@@ -19,6 +19,7 @@
 #include "applicationinfo.h"
 #include "application_manager.h"
 #include "mirsurfaceinterface.h"
+#include "qmlcachemanager.h"
 #include "session.h"
 #include "sharedwakelock.h"
 #include "timer.h"
@@ -71,6 +72,8 @@ Application::Application(const QSharedPointer<SharedWakelock>& sharedWakelock,
 
     setStopTimer(new Timer);
 
+    QmlCacheManager::singleton()->markUsed(appId());
+
     connect(&m_surfaceList, &unityapp::MirSurfaceListInterface::countChanged, this, &unityapp::ApplicationInfoInterface::surfaceCountChanged);
 }
 
@@ -114,17 +117,8 @@ Application::~Application()
 
 void Application::wipeQMLCache()
 {
-    QString path(QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QStringLiteral("/QML/Apps/"));
-    QDir dir(path);
-    QStringList apps = dir.entryList();
-    for (int i = 0; i < apps.size(); i++) {
-        if (apps.at(i).contains(appId())) {
-            qCDebug(QTMIR_APPLICATIONS) << "Application appId=" << apps.at(i) << " Wiping QML Cache";
-            dir.cd(apps.at(i));
-            dir.removeRecursively();
-            break;
-        }
-    }
+    // Done asynchronously by QmlCacheManager, which only deletes the cache later on
+    QmlCacheManager::singleton()->invalidate(appId());
 }
 
 bool Application::isValid() const
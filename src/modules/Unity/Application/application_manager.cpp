@@ -89,7 +89,14 @@ ApplicationManager* ApplicationManager::create()
 
     QSharedPointer<TaskController> taskController(new upstart::TaskController());
     QSharedPointer<ProcInfo> procInfo(new ProcInfo());
-    QSharedPointer<SharedWakelock> sharedWakelock(new SharedWakelock);
+    QSharedPointer<SharedWakelock> sharedWakelock;
+    bool holdOffIsSet;
+    const int wakelockHoldOffMs = qEnvironmentVariableIntValue("QTMIR_WAKELOCK_HOLDOFF_MS", &holdOffIsSet);
+    if (holdOffIsSet) {
+        sharedWakelock.reset(new SharedWakelock(QDBusConnection::systemBus(), wakelockHoldOffMs));
+    } else {
+        sharedWakelock.reset(new SharedWakelock);
+    }
     QSharedPointer<Settings> settings(new Settings());
 
     // FIXME: We should use a QSharedPointer to wrap this ApplicationManager object, which requires us
@@ -133,7 +140,7 @@ ApplicationManager::ApplicationManager(
         const QSharedPointer<SettingsInterface>& settings,
         QObject *parent)
     : ApplicationManagerInterface(parent)
-    , m_dbusFocusInfo(new DBusFocusInfo(m_applications))
+    , m_dbusFocusInfo(new DBusFocusInfo(procInfo))
     , m_taskController(taskController)
     , m_procInfo(procInfo)
     , m_sharedWakelock(sharedWakelock)
@@ -798,6 +805,8 @@ void ApplicationManager::onSessionStarting(SessionInterface *qmlSession)
     if (application) {
         application->addSession(qmlSession);
     }
+
+    m_dbusFocusInfo->registerSession(qmlSession);
 }
 
 SessionInterface *ApplicationManager::findSession(const mir::scene::Session* session) const
@@ -17,9 +17,9 @@
 #include "dbusfocusinfo.h"
 
 // local
-#include "cgmanager.h"
 #include "mirsurfacelistmodel.h"
 #include "mirsurfaceinterface.h"
+#include "proc_info.h"
 #include "session_interface.h"
 
 // QPA mirserver
@@ -27,111 +27,307 @@
 #include <shelluuid.h>
 
 #include <QDBusConnection>
+#include <QDBusContext>
+#include <QDBusMessage>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QSet>
+#include <QTimer>
 
-using namespace qtmir;
+// std
+#include <algorithm>
 
-DBusFocusInfo::DBusFocusInfo(const QList<Application*> &applications)
-    : m_applications(applications)
+namespace qtmir {
+
+namespace {
+
+const char focusInfoPath[] = "/com/canonical/Unity/FocusInfo";
+
+// Each client may issue queryBurst queries in a row, and then queryRate queries per second
+const double queryRate = 20;
+const double queryBurst = 40;
+
+// Every negative answer takes that long, which makes brute-forcing valid surface ids or focused pids
+// impractical. Unknown surface ids get the same delay as known but unfocused ones, so the two can't
+// be told apart by timing.
+const int negativeAnswerDelayMs = 200;
+
+// Forget about callers once there are more than that, keeping only the ones with a partly used bucket
+const int maxTrackedCallers = 64;
+
+// If a cgroup has a format like this:
+// /user.slice/user-32011.slice/session-c3.scope/upstart/application-legacy-puritine_gedit_0.0-
+// All PIds in it are associated with a single application.
+QString appCGroupOfPid(ProcInfo &procInfo, pid_t pid)
 {
-    QDBusConnection::sessionBus().registerService("com.canonical.Unity.FocusInfo");
-    QDBusConnection::sessionBus().registerObject("/com/canonical/Unity/FocusInfo", this, QDBusConnection::ExportScriptableSlots);
+    const QString cgroup = procInfo.cgroup(pid, "freezer");
+    return cgroup.split('/').contains(QStringLiteral("upstart")) ? cgroup : QString();
+}
+
+} // namespace
 
-    m_cgManager = new CGManager(this);
+QueryRateLimiter::QueryRateLimiter(double rate, double burst)
+    : m_rate(rate)
+    , m_burst(burst)
+{
 }
 
-bool DBusFocusInfo::isPidFocused(unsigned int pid)
+bool QueryRateLimiter::admit(const QString &caller, qint64 nowMs)
 {
-    if (QCoreApplication::applicationPid() == (qint64)pid) {
-        // Shell itself.
-        // Don't bother checking if it has a QML with activeFocus() which is not a MirSurfaceItem.
-        return true;
+    if (m_buckets.count() > maxTrackedCallers) {
+        // Callers which would have a full bucket by now anyway can be forgotten
+        const qint64 refillTimeMs = m_burst / m_rate * 1000;
+        for (auto it = m_buckets.begin(); it != m_buckets.end();) {
+            if (nowMs - it->lastRefill > refillTimeMs) {
+                it = m_buckets.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    auto it = m_buckets.find(caller);
+    if (it == m_buckets.end()) {
+        it = m_buckets.insert(caller, TokenBucket{m_burst, nowMs});
     } else {
-        auto pidSet = fetchAssociatedPids((pid_t)pid);
-        SessionInterface *session = findSessionWithPid(pidSet);
-        return session ? session->activeFocus() : false;
+        it->tokens = std::min(m_burst, it->tokens + (nowMs - it->lastRefill) * m_rate / 1000);
+        it->lastRefill = nowMs;
+    }
+
+    if (it->tokens < 1) {
+        return false;
     }
+
+    it->tokens -= 1;
+    return true;
 }
 
-QSet<pid_t> DBusFocusInfo::fetchAssociatedPids(pid_t pid)
+/*
+   The object exported on D-Bus. Lives in the DBusFocusInfo thread and only ever looks at the
+   latest snapshot of the focus state.
+ */
+class FocusInfoService : public QObject, protected QDBusContext
 {
-    QString cgroup = m_cgManager->getCGroupOfPid("freezer", pid);
-
-    // If a cgroup has a format like this:
-    // /user.slice/user-32011.slice/session-c3.scope/upstart/application-legacy-puritine_gedit_0.0-
-    // All PIds in it are associated with a single application.
-    if (cgroup.split("/").contains("upstart")) {
-        QSet<pid_t> pidSet = m_cgManager->getTasks("freezer", cgroup);
-        qCDebug(QTMIR_DBUS) << "DBusFocusInfo: pid" << pid << "is in cgroup" << cgroup << "along with:" << pidSet;
-        if (pidSet.isEmpty()) {
-            pidSet << pid;
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "com.canonical.Unity.FocusInfo")
+public:
+    FocusInfoService(const QSharedPointer<ProcInfo> &procInfo)
+        : m_procInfo(procInfo)
+        , m_snapshot(new FocusSnapshot)
+        , m_rateLimiter(queryRate, queryBurst)
+    {
+        m_clock.start();
+    }
+
+    // May be called from any thread
+    void setSnapshot(const QSharedPointer<const FocusSnapshot> &snapshot)
+    {
+        QMutexLocker locker(&m_snapshotMutex);
+        m_snapshot = snapshot;
+    }
+
+public Q_SLOTS:
+
+    /*
+        Returns true if the application with the given PID has input focus
+
+        FIXME: Identifying an app through its PID is deemed racy.
+               isSurfaceFocused() is the preferred method.
+     */
+    Q_SCRIPTABLE bool isPidFocused(unsigned int pid)
+    {
+        if (!admitQuery()) {
+            return false;
         }
-        return pidSet;
-    } else {
-        qCDebug(QTMIR_DBUS) << "DBusFocusInfo: pid" << pid << "is in cgroup" << cgroup << "which is not app-specific";
-        return QSet<pid_t>({pid});
+
+        if (QCoreApplication::applicationPid() == (qint64)pid) {
+            // Shell itself.
+            // Don't bother checking if it has a QML with activeFocus() which is not a MirSurfaceItem.
+            return true;
+        }
+
+        const QSharedPointer<const FocusSnapshot> focus = snapshot();
+        bool result = focus->isPidFocused((pid_t)pid, appCGroupOfPid(*m_procInfo, (pid_t)pid));
+        qCDebug(QTMIR_DBUS).nospace() << "DBusFocusInfo: isPidFocused("<<pid<<") -> " << result;
+        return answer(result);
+    }
+
+    /*
+        Returns true if the surface with the given id has input focus
+     */
+    Q_SCRIPTABLE bool isSurfaceFocused(const QString &serializedId)
+    {
+        if (!admitQuery()) {
+            return false;
+        }
+
+        bool result = false;
+        if (serializedId == ShellUuId::toString()) {
+            result = true;
+        } else {
+            result = snapshot()->focusedSurfaceIds.contains(serializedId);
+        }
+        qCDebug(QTMIR_DBUS).nospace() << "DBusFocusInfo: isSurfaceFocused("<<serializedId<<") -> " << result;
+        return answer(result);
+    }
+
+private:
+    QSharedPointer<const FocusSnapshot> snapshot() const
+    {
+        QMutexLocker locker(&m_snapshotMutex);
+        return m_snapshot;
+    }
+
+    // Charges the query to its caller. If the caller is over its rate, replies with an error instead.
+    bool admitQuery()
+    {
+        if (!calledFromDBus()) {
+            return true;
+        }
+
+        if (!m_rateLimiter.admit(message().service(), m_clock.elapsed())) {
+            qCDebug(QTMIR_DBUS) << "DBusFocusInfo: too many queries from" << message().service();
+            sendErrorReply(QDBusError::LimitsExceeded, QStringLiteral("Too many FocusInfo queries"));
+            return false;
+        }
+        return true;
     }
+
+    // Positive answers go out right away, negative ones after negativeAnswerDelayMs
+    bool answer(bool result)
+    {
+        if (!result && calledFromDBus()) {
+            setDelayedReply(true);
+            const QDBusMessage reply = message().createReply(result);
+            const QDBusConnection connection = this->connection();
+            QTimer::singleShot(negativeAnswerDelayMs, this, [connection, reply]() { connection.send(reply); });
+        }
+        return result;
+    }
+
+    QSharedPointer<ProcInfo> m_procInfo;
+
+    mutable QMutex m_snapshotMutex;
+    QSharedPointer<const FocusSnapshot> m_snapshot;
+
+    QElapsedTimer m_clock;
+    QueryRateLimiter m_rateLimiter; // keyed by the caller's unique bus name
+};
+
+DBusFocusInfo::DBusFocusInfo(const QSharedPointer<ProcInfo> &procInfo)
+    : m_procInfo(procInfo)
+    , m_snapshot(new FocusSnapshot)
+    , m_service(new FocusInfoService(procInfo))
+{
+    m_thread.setObjectName(QStringLiteral("FocusInfo"));
+    m_service->moveToThread(&m_thread);
+    connect(&m_thread, &QThread::finished, m_service, &QObject::deleteLater);
+    m_thread.start();
+
+    QDBusConnection::sessionBus().registerService("com.canonical.Unity.FocusInfo");
+    QDBusConnection::sessionBus().registerObject(focusInfoPath, m_service, QDBusConnection::ExportScriptableSlots);
 }
 
-SessionInterface* DBusFocusInfo::findSessionWithPid(const QSet<pid_t> &pidSet)
+DBusFocusInfo::~DBusFocusInfo()
 {
-    Q_FOREACH (Application* application, m_applications) {
-        QVector<SessionInterface*> sessions = application->sessions();
-        for (auto session : sessions) {
-            if (pidSet.contains(session->pid())) {
-                return session;
-            }
-            SessionInterface *chosenChildSession = nullptr;
-            session->foreachChildSession([&](SessionInterface* childSession) {
-                if (pidSet.contains(childSession->pid())) {
-                    chosenChildSession = childSession;
-                }
+    QDBusConnection::sessionBus().unregisterObject(focusInfoPath);
+    m_thread.quit();
+    m_thread.wait();
+}
+
+void DBusFocusInfo::registerSession(SessionInterface *session)
+{
+    if (m_cgroupOfSession.contains(session)) {
+        return;
+    }
+
+    // The cgroup of a process does not change once it has been launched, so look it up only once
+    m_cgroupOfSession.insert(session, appCGroupOfPid(*m_procInfo, session->pid()));
+
+    MirSurfaceListModel *surfaceList = session->surfaceList();
+    connect(surfaceList, &QAbstractItemModel::rowsInserted, this,
+            [this, session, surfaceList](const QModelIndex &, int first, int last) {
+                addSurfaces(session, surfaceList, first, last);
             });
-            if (chosenChildSession) {
-                return chosenChildSession;
-            }
-        }
+    connect(surfaceList, &QAbstractItemModel::rowsAboutToBeRemoved, this,
+            [this, surfaceList](const QModelIndex &, int first, int last) { removeSurfaces(surfaceList, first, last); });
+
+    // Session emits destroyed() early in its destructor, while its methods can still be accessed
+    connect(session, &QObject::destroyed, this, [this, session]() { unregisterSession(session); });
+
+    addSurfaces(session, surfaceList, 0, surfaceList->count() - 1);
+}
+
+void DBusFocusInfo::unregisterSession(SessionInterface *session)
+{
+    if (!m_cgroupOfSession.contains(session)) {
+        return;
     }
-    return nullptr;
+
+    MirSurfaceListModel *surfaceList = session->surfaceList();
+    surfaceList->disconnect(this);
+    session->disconnect(this);
+    m_cgroupOfSession.remove(session);
+
+    removeSurfaces(surfaceList, 0, surfaceList->count() - 1);
 }
 
-bool DBusFocusInfo::isSurfaceFocused(const QString &serializedId)
+void DBusFocusInfo::addSurfaces(SessionInterface *session, MirSurfaceListModel *surfaceList, int first, int last)
 {
-    // TODO: Implement a penalty for negative queries, such as stalling for some time before answering
-    //       further queries. That's in order to avoid brute-force approaches to find a valid surface id.
-    //       That's particularly important for shell's own surface id as it's always valid.
-    bool result = false;
-    if (serializedId == ShellUuId::toString()) {
-        result = true;
-    } else {
-        MirSurfaceInterface *qmlSurface = findQmlSurface(serializedId);
-        result = qmlSurface ? qmlSurface->activeFocus() : false;
+    if (first > last) {
+        return;
     }
-    qCDebug(QTMIR_DBUS).nospace() << "DBusFocusInfo: isSurfaceFocused("<<serializedId<<") -> " << result;
-    return result;
+
+    for (int i = first; i <= last; ++i) {
+        auto qmlSurface = static_cast<MirSurfaceInterface*>(surfaceList->get(i));
+        m_idOfSurface.insert(qmlSurface, qmlSurface->persistentId());
+        m_sessionOfSurface.insert(qmlSurface, session);
+        connect(qmlSurface, &MirSurfaceInterface::activeFocusChanged, this, &DBusFocusInfo::updateSnapshot);
+    }
+
+    updateSnapshot();
 }
 
-MirSurfaceInterface *DBusFocusInfo::findQmlSurface(const QString &serializedId)
+void DBusFocusInfo::removeSurfaces(MirSurfaceListModel *surfaceList, int first, int last)
 {
-    for (Application* application : m_applications) {
-        for (SessionInterface *session : application->sessions()) {
-            if (session) {
-                auto surfaceList = static_cast<MirSurfaceListModel*>(session->surfaceList());
-                for (int i = 0; i < surfaceList->count(); ++i) {
-                    auto qmlSurface = static_cast<MirSurfaceInterface*>(surfaceList->get(i));
-                    if (qmlSurface->persistentId() == serializedId) {
-                        return qmlSurface;
-                    }
-                }
-
-                surfaceList = static_cast<MirSurfaceListModel*>(session->promptSurfaceList());
-                for (int i = 0; i < surfaceList->count(); ++i) {
-                    auto qmlSurface = static_cast<MirSurfaceInterface*>(surfaceList->get(i));
-                    if (qmlSurface->persistentId() == serializedId) {
-                        return qmlSurface;
-                    }
-                }
+    if (first > last) {
+        return;
+    }
+
+    // The surface may be already partially destroyed, so don't call any of its methods
+    for (int i = first; i <= last; ++i) {
+        auto qmlSurface = static_cast<MirSurfaceInterface*>(surfaceList->get(i));
+        if (m_idOfSurface.remove(qmlSurface)) {
+            m_sessionOfSurface.remove(qmlSurface);
+            QObject::disconnect(qmlSurface, nullptr, this, nullptr);
+        }
+    }
+
+    updateSnapshot();
+}
+
+void DBusFocusInfo::updateSnapshot()
+{
+    QSharedPointer<FocusSnapshot> focus(new FocusSnapshot);
+
+    for (auto it = m_idOfSurface.constBegin(); it != m_idOfSurface.constEnd(); ++it) {
+        focus->knownSurfaceIds.insert(it.value());
+
+        if (it.key()->activeFocus()) {
+            SessionInterface *session = m_sessionOfSurface.value(it.key());
+            focus->focusedSurfaceIds.insert(it.value());
+            focus->focusedPids.insert(session->pid());
+            const QString cgroup = m_cgroupOfSession.value(session);
+            if (!cgroup.isEmpty()) {
+                focus->focusedCGroups.insert(cgroup);
             }
         }
     }
-    return nullptr;
+
+    m_snapshot = focus;
+    m_service->setSnapshot(focus);
 }
+
+} // namespace qtmir
+
+#include "dbusfocusinfo.moc"
@@ -14,51 +14,99 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include <QList>
+#include <QHash>
 #include <QSet>
+#include <QSharedPointer>
+#include <QThread>
 
 #include "application.h"
 
 namespace qtmir {
 
-class CGManager;
+class FocusInfoService;
 class MirSurfaceInterface;
+class MirSurfaceListModel;
+class ProcInfo;
+
+/*
+   Read-only view of the focus state, as of the last change
+ */
+struct FocusSnapshot
+{
+    // appCGroup is the cgroup of the process if it's app-specific, empty otherwise
+    bool isPidFocused(pid_t pid, const QString &appCGroup) const
+    {
+        return focusedPids.contains(pid) || (!appCGroup.isEmpty() && focusedCGroups.contains(appCGroup));
+    }
+
+    QSet<QString> knownSurfaceIds;
+    QSet<QString> focusedSurfaceIds;
+    QSet<pid_t> focusedPids;
+    QSet<QString> focusedCGroups;
+};
+
+/*
+   Per-caller token bucket: each caller may issue burst queries in a row, and then rate queries per second
+ */
+class QueryRateLimiter
+{
+public:
+    QueryRateLimiter(double rate, double burst);
+
+    // Charges a query to the caller, returns false if the caller is over its rate
+    bool admit(const QString &caller, qint64 nowMs);
+
+    int callerCount() const { return m_buckets.count(); }
+
+private:
+    struct TokenBucket {
+        double tokens;
+        qint64 lastRefill;
+    };
+
+    const double m_rate;
+    const double m_burst;
+    QHash<QString, TokenBucket> m_buckets; // caller -> bucket
+};
 
 /*
    Enables other processes to check what is the currently focused application or surface,
    normally for security purposes.
+
+   Sessions and their surfaces are indexed as they register. Whenever any of that or the
+   active focus changes, a read-only snapshot of the focus state is handed over to the
+   FocusInfoService, which answers the D-Bus queries from a thread of its own. So however
+   often clients poll, the shell main thread is not involved.
  */
 class DBusFocusInfo : public QObject
 {
     Q_OBJECT
-    Q_CLASSINFO("D-Bus Interface", "com.canonical.Unity.FocusInfo")
 public:
-    explicit DBusFocusInfo(const QList<Application*> &applications);
-    virtual ~DBusFocusInfo() {}
+    explicit DBusFocusInfo(const QSharedPointer<ProcInfo> &procInfo);
+    virtual ~DBusFocusInfo();
 
-public Q_SLOTS:
+    void registerSession(SessionInterface *session);
 
-    /*
-        Returns true if the application with the given PID has input focus
+    // The focus state last handed over to the D-Bus service. For tests.
+    QSharedPointer<const FocusSnapshot> snapshot() const { return m_snapshot; }
 
-        FIXME: Identifying an app through its PID is deemed racy.
-               isSurfaceFocused() is the preferred method.
-     */
-    Q_SCRIPTABLE bool isPidFocused(unsigned int pid);
+private:
+    void unregisterSession(SessionInterface *session);
+    void addSurfaces(SessionInterface *session, MirSurfaceListModel *surfaceList, int first, int last);
+    void removeSurfaces(MirSurfaceListModel *surfaceList, int first, int last);
+    void updateSnapshot();
 
-    /*
-        Returns true if the surface with the given id has input focus
-     */
-    Q_SCRIPTABLE bool isSurfaceFocused(const QString &surfaceId);
+    QSharedPointer<ProcInfo> m_procInfo;
 
-private:
-    QSet<pid_t> fetchAssociatedPids(pid_t pid);
-    SessionInterface* findSessionWithPid(const QSet<pid_t> &pidSet);
-    MirSurfaceInterface *findQmlSurface(const QString &serializedId);
+    QHash<SessionInterface*, QString> m_cgroupOfSession; // empty if not app-specific
+
+    QHash<MirSurfaceInterface*, QString> m_idOfSurface;
+    QHash<MirSurfaceInterface*, SessionInterface*> m_sessionOfSurface;
 
-    const QList<Application*> &m_applications;
+    QSharedPointer<const FocusSnapshot> m_snapshot;
 
-    CGManager *m_cgManager;
+    QThread m_thread;
+    FocusInfoService *m_service;
 };
 
 } // namespace qtmir
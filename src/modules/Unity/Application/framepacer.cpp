@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "framepacer.h"
+
+#include <QtMath>
+
+namespace qtmir {
+
+namespace {
+
+// Frames come on display refreshes, which don't quite match the cadence. A quarter of a 60Hz refresh.
+const qreal slackMs = 4;
+
+} // namespace
+
+void FramePacer::setMaxFrameRate(qreal frameRate)
+{
+    if (frameRate == m_maxFrameRate) {
+        return;
+    }
+
+    m_maxFrameRate = frameRate > 0 ? frameRate : 0;
+    m_interval = m_maxFrameRate > 0 ? 1000 / m_maxFrameRate : 0;
+    m_nextFrameTime = 0; // the next one is due right away
+}
+
+qint64 FramePacer::timeUntilNextFrame(qint64 now) const
+{
+    if (m_interval == 0 || now >= m_nextFrameTime - slackMs) {
+        return 0;
+    }
+    return qCeil(m_nextFrameTime - now);
+}
+
+void FramePacer::frameTaken(qint64 now)
+{
+    if (m_interval == 0) {
+        return;
+    }
+
+    // Keep the cadence, unless the frame came so late it would let the next ones through in a burst
+    if (now - m_nextFrameTime < m_interval) {
+        m_nextFrameTime += m_interval;
+    } else {
+        m_nextFrameTime = now + m_interval;
+    }
+}
+
+} // namespace qtmir
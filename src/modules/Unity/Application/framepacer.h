@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QTMIR_FRAMEPACER_H
+#define QTMIR_FRAMEPACER_H
+
+#include <QtGlobal>
+
+namespace qtmir {
+
+/*
+    Decides when the next client frame can be taken so as not to exceed a maximum frame rate.
+
+    Frames are due on a steady cadence rather than a fixed interval after the previous one, with
+    some slack, so that capping a client to half the display refresh rate really gets it every
+    other refresh instead of drifting down to a third of it.
+
+    Times are in milliseconds, from any monotonic clock.
+ */
+class FramePacer
+{
+public:
+    // 0 means no limit
+    void setMaxFrameRate(qreal frameRate);
+    qreal maxFrameRate() const { return m_maxFrameRate; }
+
+    bool isFrameDue(qint64 now) const { return timeUntilNextFrame(now) == 0; }
+    qint64 timeUntilNextFrame(qint64 now) const;
+
+    void frameTaken(qint64 now);
+
+private:
+    qreal m_maxFrameRate{0};
+    qreal m_interval{0};
+    qreal m_nextFrameTime{0};
+};
+
+} // namespace qtmir
+
+#endif // QTMIR_FRAMEPACER_H
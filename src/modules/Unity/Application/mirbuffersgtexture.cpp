@@ -21,6 +21,29 @@
 
 namespace mg = mir::geometry;
 
+namespace {
+
+// Mir pixel formats name components from the most significant bits of a little endian word
+QImage::Format toQImageFormat(MirPixelFormat format)
+{
+    switch (format) {
+    case mir_pixel_format_abgr_8888:
+        return QImage::Format_RGBA8888_Premultiplied;
+    case mir_pixel_format_xbgr_8888:
+        return QImage::Format_RGBX8888;
+    case mir_pixel_format_argb_8888:
+        return QImage::Format_ARGB32_Premultiplied;
+    case mir_pixel_format_xrgb_8888:
+        return QImage::Format_RGB32;
+    case mir_pixel_format_rgb_565:
+        return QImage::Format_RGB16;
+    default:
+        return QImage::Format_Invalid;
+    }
+}
+
+} // namespace
+
 MirBufferSGTexture::MirBufferSGTexture()
     : QSGTexture()
     , m_width(0)
@@ -61,6 +84,29 @@ bool MirBufferSGTexture::hasBuffer() const
     return m_mirBuffer;
 }
 
+std::shared_ptr<mir::graphics::Buffer> MirBufferSGTexture::buffer() const
+{
+    return m_mirBuffer.buffer();
+}
+
+QImage MirBufferSGTexture::toImage()
+{
+    if (!hasBuffer()) {
+        return QImage();
+    }
+
+    const QImage::Format format = toQImageFormat(m_mirBuffer.pixel_format());
+    if (format == QImage::Format_Invalid) {
+        return QImage();
+    }
+
+    QImage image;
+    m_mirBuffer.read_pixels([&](const unsigned char *pixels, int stride) {
+        image = QImage(pixels, m_width, m_height, stride, format).copy();
+    });
+    return image;
+}
+
 int MirBufferSGTexture::textureId() const
 {
     return m_textureId;
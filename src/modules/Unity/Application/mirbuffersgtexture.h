@@ -19,6 +19,7 @@
 
 #include "miral/mirbuffer.h"
 
+#include <QImage>
 #include <QSGTexture>
 
 #include <QtGui/qopengl.h>
@@ -33,6 +34,10 @@ public:
     void setBuffer(const std::shared_ptr<mir::graphics::Buffer>& buffer);
     void freeBuffer();
     bool hasBuffer() const;
+    std::shared_ptr<mir::graphics::Buffer> buffer() const;
+
+    // A copy of the buffer contents, if they are in client memory (shm buffers). A null image otherwise.
+    QImage toImage();
 
     int textureId() const override;
     QSize textureSize() const override;
@@ -28,7 +28,10 @@
 #include "mirqtconversion.h"
 
 // mirserver
+#include <cursor.h>
 #include <eventbuilder.h>
+#include <inputlatencystats.h>
+#include <keymapcache.h>
 #include <surfaceobserver.h>
 #include "screen.h"
 
@@ -39,6 +42,9 @@
 #include <mir/version.h>
 #include <mir_toolkit/cursors.h>
 
+// miral
+#include <miral/application.h>
+
 // mirserver
 #include <logging.h>
 
@@ -78,6 +84,17 @@ qint64 msecsSinceReference()
     return elapsedTimer.msecsSinceReference();
 }
 
+// Whether the event was dispatched straight to the client already, sparing the shell. See
+// WindowControllerInterface::setDirectInputAllowed()
+bool deliveredToClient(ulong qtTimestamp)
+{
+    if (qtTimestamp == 0) {
+        return false;
+    }
+    auto eventInfo = EventBuilder::instance()->findInfo(qtTimestamp);
+    return eventInfo && eventInfo->deliveredToClient;
+}
+
 } // namespace {
 
 class MirSurface::SurfaceObserverImpl : public SurfaceObserver, public mir::scene::SurfaceObserver
@@ -195,6 +212,7 @@ MirSurface::MirSurface(NewWindow newWindowInfo,
     , m_shellChrome(toQtShellChrome(newWindowInfo.windowInfo.shell_chrome()))
     , m_parentSurface(parentSurface)
     , m_childSurfaceList(new MirSurfaceListModel(this))
+    , m_pressedKeys(session ? session->pressedKeyTable() : QSharedPointer<PressedKeyTable>())
 {
     INFO_MSG << "("
         << "type=" << mirSurfaceTypeToStr(m_type)
@@ -224,6 +242,7 @@ MirSurface::MirSurface(NewWindow newWindowInfo,
     });
     connect(m_surfaceObserver.get(), &SurfaceObserver::inputBoundsChanged, this, &MirSurface::setInputBounds);
     connect(m_surfaceObserver.get(), &SurfaceObserver::confinesMousePointerChanged, this, &MirSurface::confinesMousePointerChanged);
+    connect(this, &MirSurface::confinesMousePointerChanged, this, &MirSurface::updateRawPointerMotion);
     m_surfaceObserver->setListener(this);
 
     connect(session, &SessionInterface::stateChanged, this, [this]() {
@@ -250,6 +269,9 @@ MirSurface::MirSurface(NewWindow newWindowInfo,
     m_frameDropperTimer.setInterval(200);
     m_frameDropperTimer.setSingleShot(false);
 
+    m_pacedFrameTimer.setSingleShot(true);
+    connect(&m_pacedFrameTimer, &QTimer::timeout, this, &MirSurface::framesPosted);
+
     QQmlEngine::setObjectOwnership(this, QQmlEngine::CppOwnership);
 
     setCloseTimer(new Timer);
@@ -269,6 +291,14 @@ MirSurface::~MirSurface()
 
     delete m_closeTimer;
 
+    if (m_requestsRawPointerMotion) {
+        Cursor::requestRawMotion(false);
+    }
+
+    if (!m_keymap.isEmpty()) {
+        KeymapCache::instance()->cancel(this);
+    }
+
     Q_EMIT destroyed(this); // Early warning, while MirSurface methods can still be accessed.
 }
 
@@ -343,12 +373,20 @@ void MirSurface::dropPendingBuffer()
         return;
     }
 
-    m_textureUpdated = false;
     auto texture = static_cast<MirBufferSGTexture*>(m_texture.data());
 
+    const qint64 now = msecsSinceReference();
+    if (texture && texture->hasBuffer() && !m_framePacer.isFrameDue(now)) {
+        // Not dropped, just held back. See updateTexture()
+        return;
+    }
+
+    m_textureUpdated = false;
+
     auto renderables = m_surface->generate_renderables(userId);
     if (renderables.size() > 0) {
         ++m_currentFrameNumber;
+        m_framePacer.frameTaken(now);
         if (texture) {
             texture->freeBuffer();
             texture->setBuffer(renderables[0]->buffer());
@@ -418,6 +456,16 @@ bool MirSurface::updateTexture()
     }
 
     const void* const userId = (void*)123;
+
+    const qint64 now = msecsSinceReference();
+    if (texture->hasBuffer() && m_surface->buffers_ready_for_compositor(userId) > 0
+            && !m_framePacer.isFrameDue(now)) {
+        // Too early for a new frame, keep showing the current one. Holding on to the client buffers
+        // a bit longer keeps the client from rendering faster than that.
+        schedulePacedFrame(m_framePacer.timeUntilNextFrame(now));
+        return true;
+    }
+
     auto renderables = m_surface->generate_renderables(userId);
 
     if (renderables.size() > 0 &&
@@ -428,6 +476,7 @@ bool MirSurface::updateTexture()
         texture->freeBuffer();
         texture->setBuffer(renderables[0]->buffer());
         ++m_currentFrameNumber;
+        m_framePacer.frameTaken(now);
 
         if (texture->textureSize() != size()) {
             m_size = texture->textureSize();
@@ -447,6 +496,12 @@ bool MirSurface::updateTexture()
     return texture->hasBuffer();
 }
 
+void MirSurface::schedulePacedFrame(qint64 delay)
+{
+    // queued since the timer lives in a different thread
+    QMetaObject::invokeMethod(&m_pacedFrameTimer, "start", Qt::QueuedConnection, Q_ARG(int, int(delay)));
+}
+
 void MirSurface::onCompositorSwappedBuffers()
 {
     QMutexLocker locker(&m_mutex);
@@ -456,6 +511,13 @@ void MirSurface::onCompositorSwappedBuffers()
 bool MirSurface::numBuffersReadyForCompositor()
 {
     QMutexLocker locker(&m_mutex);
+
+    // Frames held back by the frame pacer are not ready yet. framesPosted() is emitted once they are.
+    auto texture = static_cast<MirBufferSGTexture*>(m_texture.data());
+    if (texture && texture->hasBuffer() && !m_framePacer.isFrameDue(msecsSinceReference())) {
+        return false;
+    }
+
     const void* const userId = (void*)123;
     return m_surface->buffers_ready_for_compositor(userId);
 }
@@ -492,6 +554,8 @@ void MirSurface::setFocused(bool value)
 
 void MirSurface::setViewActiveFocus(qintptr viewId, bool value)
 {
+    const bool hadActiveFocus = activeFocus();
+
     if (value && !m_activelyFocusedViews.contains(viewId)) {
         m_activelyFocusedViews.insert(viewId);
         updateActiveFocus();
@@ -499,6 +563,24 @@ void MirSurface::setViewActiveFocus(qintptr viewId, bool value)
         m_activelyFocusedViews.remove(viewId);
         updateActiveFocus();
     }
+
+    updateDirectInputArea();
+
+    if (activeFocus() != hadActiveFocus) {
+        updateRawPointerMotion();
+        Q_EMIT activeFocusChanged(activeFocus());
+    }
+}
+
+void MirSurface::updateRawPointerMotion()
+{
+    // A client that confines the pointer is most likely interested in each and every motion event
+    const bool requestsRawPointerMotion = activeFocus() && confinesMousePointer();
+
+    if (requestsRawPointerMotion != m_requestsRawPointerMotion) {
+        m_requestsRawPointerMotion = requestsRawPointerMotion;
+        Cursor::requestRawMotion(requestsRawPointerMotion);
+    }
 }
 
 bool MirSurface::activeFocus() const
@@ -694,87 +776,150 @@ bool MirSurface::visible() const
 #include <mir_toolkit/event.h>
 void MirSurface::mousePressEvent(QMouseEvent *event)
 {
+    flushPendingPointerMotion();
     auto ev = EventBuilder::instance()->reconstructMirEvent(event);
     auto ev1 = reinterpret_cast<MirPointerEvent const*>(ev.get());
     m_controller->deliverPointerEvent(m_window, ev1);
+    recordDeliveryLatency(event->timestamp());
     event->accept();
 }
 
 void MirSurface::mouseMoveEvent(QMouseEvent *event)
 {
-    auto ev = EventBuilder::instance()->reconstructMirEvent(event);
-    auto ev1 = reinterpret_cast<MirPointerEvent const*>(ev.get());
-    m_controller->deliverPointerEvent(m_window, ev1);
+    if (confinesMousePointer()) {
+        flushPendingPointerMotion();
+        auto ev = EventBuilder::instance()->reconstructMirEvent(event);
+        auto ev1 = reinterpret_cast<MirPointerEvent const*>(ev.get());
+        m_controller->deliverPointerEvent(m_window, ev1);
+        recordDeliveryLatency(event->timestamp());
+    } else {
+        mergePointerMotion(new QMouseEvent(*event));
+    }
     event->accept();
 }
 
 void MirSurface::mouseReleaseEvent(QMouseEvent *event)
 {
+    flushPendingPointerMotion();
     auto ev = EventBuilder::instance()->reconstructMirEvent(event);
     auto ev1 = reinterpret_cast<MirPointerEvent const*>(ev.get());
     m_controller->deliverPointerEvent(m_window, ev1);
+    recordDeliveryLatency(event->timestamp());
     event->accept();
 }
 
 void MirSurface::hoverEnterEvent(QHoverEvent *event)
 {
+    flushPendingPointerMotion();
     auto ev = EventBuilder::instance()->reconstructMirEvent(event);
     auto ev1 = reinterpret_cast<MirPointerEvent const*>(ev.get());
     m_controller->deliverPointerEvent(m_window, ev1);
+    recordDeliveryLatency(event->timestamp());
     event->accept();
 }
 
 void MirSurface::hoverLeaveEvent(QHoverEvent *event)
 {
+    flushPendingPointerMotion();
     auto ev = EventBuilder::instance()->reconstructMirEvent(event);
     auto ev1 = reinterpret_cast<MirPointerEvent const*>(ev.get());
     m_controller->deliverPointerEvent(m_window, ev1);
+    recordDeliveryLatency(event->timestamp());
     event->accept();
 }
 
 void MirSurface::hoverMoveEvent(QHoverEvent *event)
 {
-    auto ev = EventBuilder::instance()->reconstructMirEvent(event);
-    auto ev1 = reinterpret_cast<MirPointerEvent const*>(ev.get());
-    m_controller->deliverPointerEvent(m_window, ev1);
+    if (confinesMousePointer()) {
+        flushPendingPointerMotion();
+        auto ev = EventBuilder::instance()->reconstructMirEvent(event);
+        auto ev1 = reinterpret_cast<MirPointerEvent const*>(ev.get());
+        m_controller->deliverPointerEvent(m_window, ev1);
+        recordDeliveryLatency(event->timestamp());
+    } else {
+        mergePointerMotion(new QHoverEvent(*event));
+    }
     event->accept();
 }
 
 void MirSurface::wheelEvent(QWheelEvent *event)
 {
+    flushPendingPointerMotion();
     auto ev = EventBuilder::instance()->makeMirEvent(event);
     auto ev1 = reinterpret_cast<MirPointerEvent const*>(ev.get());
     m_controller->deliverPointerEvent(m_window, ev1);
+    recordDeliveryLatency(event->timestamp());
     event->accept();
 }
 
+void MirSurface::mergePointerMotion(QInputEvent *event)
+{
+    if (!m_pendingPointerMotion) {
+        // Qt dispatches all pending input events in one go, so by the time this gets called the
+        // client can be sent a single event with the motion of the whole batch.
+        QMetaObject::invokeMethod(this, "flushPendingPointerMotion", Qt::QueuedConnection);
+        m_pendingRelativeMotion = QPointF();
+    }
+
+    QPointF relativeMotion;
+    if (event->timestamp() != 0 && EventBuilder::instance()->relativeMotion(event->timestamp(), &relativeMotion)) {
+        m_pendingRelativeMotion += relativeMotion;
+    }
+
+    m_pendingPointerMotion.reset(event);
+}
+
+void MirSurface::flushPendingPointerMotion()
+{
+    if (!m_pendingPointerMotion) {
+        return;
+    }
+
+    QScopedPointer<QInputEvent> event(m_pendingPointerMotion.take());
+
+    mir::EventUPtr ev;
+    if (event->type() == QEvent::MouseMove) {
+        ev = EventBuilder::instance()->reconstructMirEvent(static_cast<QMouseEvent*>(event.data()), m_pendingRelativeMotion);
+    } else {
+        ev = EventBuilder::instance()->reconstructMirEvent(static_cast<QHoverEvent*>(event.data()), m_pendingRelativeMotion);
+    }
+    auto ev1 = reinterpret_cast<MirPointerEvent const*>(ev.get());
+    m_controller->deliverPointerEvent(m_window, ev1);
+    recordDeliveryLatency(event->timestamp());
+}
+
 void MirSurface::keyPressEvent(QKeyEvent *qtEvent)
 {
     {
         if (!qtEvent->isAutoRepeat()) {
-            Q_ASSERT(!isKeyPressed(qtEvent->nativeVirtualKey()));
-            PressedKey pressedKey(qtEvent, msecsSinceReference());
+            Q_ASSERT(!m_pressedKeys.isPressed(qtEvent->nativeScanCode(), qtEvent->nativeVirtualKey()));
+            PressedKey pressedKey;
+            pressedKey.nativeVirtualKey = qtEvent->nativeVirtualKey();
+            pressedKey.nativeScanCode = qtEvent->nativeScanCode();
+            pressedKey.timestamp = qtEvent->timestamp();
+            pressedKey.msecsSinceReference = msecsSinceReference();
             auto info = EventBuilder::instance()->findInfo(qtEvent->timestamp());
             if (info) {
                 pressedKey.deviceId = info->deviceId;
             }
-            m_pressedKeys.append(std::move(pressedKey));
+            m_pressedKeys.press(pressedKey);
         }
     }
 
     auto ev = EventBuilder::instance()->makeMirEvent(qtEvent);
     auto ev1 = reinterpret_cast<MirKeyboardEvent const*>(ev.get());
     m_controller->deliverKeyboardEvent(m_window, ev1);
+    recordDeliveryLatency(qtEvent->timestamp());
     qtEvent->accept();
 }
 
 void MirSurface::keyReleaseEvent(QKeyEvent *qtEvent)
 {
-    if (isKeyPressed(qtEvent->nativeVirtualKey())) {
-        forgetPressedKey(qtEvent->nativeVirtualKey());
+    if (m_pressedKeys.release(qtEvent->nativeScanCode(), qtEvent->nativeVirtualKey())) {
         auto ev = EventBuilder::instance()->makeMirEvent(qtEvent);
         auto ev1 = reinterpret_cast<MirKeyboardEvent const*>(ev.get());
         m_controller->deliverKeyboardEvent(m_window, ev1);
+        recordDeliveryLatency(qtEvent->timestamp());
     } else {
         // don't send a release event for a key for which we did not send a press in the first place
     }
@@ -785,9 +930,33 @@ void MirSurface::touchEvent(Qt::KeyboardModifiers mods,
                             Qt::TouchPointStates touchPointStates,
                             ulong timestamp)
 {
+    if (deliveredToClient(timestamp)) {
+        return;
+    }
+
     auto ev = EventBuilder::instance()->makeMirEvent(mods, touchPoints, touchPointStates, timestamp);
     auto ev1 = reinterpret_cast<MirTouchEvent const*>(ev.get());
     m_controller->deliverTouchEvent(m_window, ev1);
+    recordDeliveryLatency(timestamp);
+}
+
+// Time from QtEventFeeder dispatching the event until it got handed to the client, see InputLatencyStats.
+// Only events that went through QtEventFeeder and can't be mistaken for another one count.
+void MirSurface::recordDeliveryLatency(ulong qtTimestamp)
+{
+    if (qtTimestamp == 0) {
+        return;
+    }
+
+    auto eventInfo = EventBuilder::instance()->findUniqueInfo(qtTimestamp);
+    if (!eventInfo || eventInfo->dispatchTime.count() == 0) {
+        return;
+    }
+
+    const auto latency = std::chrono::steady_clock::now().time_since_epoch() - eventInfo->dispatchTime;
+    const QString surfaceName = QString::fromStdString(miral::name_of(m_window.application()))
+            + QLatin1Char('/') + name();
+    InputLatencyStats::instance()->recordDelivery(eventInfo->deviceId, surfaceName, latency);
 }
 
 bool MirSurface::clientIsRunning() const
@@ -806,7 +975,7 @@ bool MirSurface::isBeingDisplayed() const
 
 void MirSurface::registerView(qintptr viewId)
 {
-    m_views.insert(viewId, MirSurface::View{false});
+    m_views.insert(viewId, MirSurface::View{false, 0});
     INFO_MSG << "(" << viewId << ")" << " after=" << m_views.count();
     if (m_views.count() == 1) {
         Q_EMIT isBeingDisplayedChanged();
@@ -821,6 +990,7 @@ void MirSurface::unregisterView(qintptr viewId)
         Q_EMIT isBeingDisplayedChanged();
     }
     updateExposure();
+    updateMaxFrameRate();
     setViewActiveFocus(viewId, false);
 }
 
@@ -830,6 +1000,74 @@ void MirSurface::setViewExposure(qintptr viewId, bool exposed)
 
     m_views[viewId].exposed = exposed;
     updateExposure();
+    updateMaxFrameRate();
+}
+
+void MirSurface::setViewMaxFrameRate(qintptr viewId, qreal frameRate)
+{
+    if (!m_views.contains(viewId)) return;
+
+    m_views[viewId].maxFrameRate = frameRate;
+    updateMaxFrameRate();
+}
+
+void MirSurface::setViewInputArea(qintptr viewId, const QRect &area)
+{
+    if (!m_views.contains(viewId) || m_views[viewId].inputArea == area) return;
+
+    m_views[viewId].inputArea = area;
+    updateDirectInputArea();
+}
+
+// Tells WindowManagementPolicy where the input that skips the shell has to land, see setViewInputArea()
+void MirSurface::updateDirectInputArea()
+{
+    QRect area;
+    for (qintptr viewId : m_activelyFocusedViews) {
+        if (m_views.contains(viewId) && m_views[viewId].inputArea.isValid()) {
+            area = m_views[viewId].inputArea;
+            break;
+        }
+    }
+
+    if (area == m_directInputArea) {
+        return;
+    }
+    m_directInputArea = area;
+
+    QMutexLocker locker(&m_extraInfo->mutex);
+    m_extraInfo->directInputArea = area;
+}
+
+void MirSurface::updateMaxFrameRate()
+{
+    // The views nobody can see don't get a say, unless there's no other
+    bool anyExposed = false;
+    for (const View &view : m_views) {
+        anyExposed |= view.exposed;
+    }
+
+    qreal maxFrameRate = -1;
+    for (const View &view : m_views) {
+        if (view.exposed || !anyExposed) {
+            maxFrameRate = (view.maxFrameRate <= 0 || maxFrameRate == 0) ? 0 : qMax(maxFrameRate, view.maxFrameRate);
+        }
+    }
+    maxFrameRate = qMax(maxFrameRate, qreal(0));
+
+    {
+        QMutexLocker locker(&m_mutex);
+        if (maxFrameRate == m_framePacer.maxFrameRate()) {
+            return;
+        }
+        m_framePacer.setMaxFrameRate(maxFrameRate);
+    }
+
+    INFO_MSG << "(" << maxFrameRate << ")";
+
+    // The next frame is due right away, in case one was being held back
+    m_pacedFrameTimer.stop();
+    Q_EMIT framesPosted();
 }
 
 void MirSurface::updateExposure()
@@ -904,28 +1142,20 @@ QString MirSurface::keymap() const
 
 void MirSurface::applyKeymap()
 {
-    QStringList stringList = m_keymap.split('+', QString::SkipEmptyParts);
+    const KeymapNames keymap = KeymapNames::fromLayoutString(m_keymap);
 
-    QString layout = stringList[0];
-    QString variant;
-
-    if (stringList.count() > 1) {
-        variant = stringList[1];
-    }
-
-    if (layout.isEmpty()) {
+    if (keymap.layout.empty()) {
         WARNING_MSG << "Setting keymap with empty layout is not supported";
         return;
     }
 
-    try
-    {
-        m_surface->set_keymap(MirInputDeviceId(), "", layout.toStdString(), variant.toStdString(), "");
-    }
-    catch(std::exception const& e)
-    {
-        WARNING_MSG << "Setting keymap failed:" << e.what();
-    }
+    // Mir compiles the keymap in set_keymap(), which is better kept away from the GUI thread
+    std::weak_ptr<mir::scene::Surface> weakSurface = m_surface;
+    KeymapCache::instance()->apply(this, keymap, [weakSurface](const KeymapNames &names) {
+        if (auto surface = weakSurface.lock()) {
+            surface->set_keymap(MirInputDeviceId(), names.model, names.layout, names.variant, names.options);
+        }
+    });
 }
 
 QCursor MirSurface::cursor() const
@@ -1482,30 +1712,15 @@ void MirSurface::updatePosition()
     setPosition(point);
 }
 
-bool MirSurface::isKeyPressed(quint32 nativeVirtualKey) const
-{
-    for (const auto &pressedKey : m_pressedKeys) {
-        if (pressedKey.nativeVirtualKey == nativeVirtualKey) {
-            return true;
-        }
-    }
-    return false;
-}
-
-void MirSurface::forgetPressedKey(quint32 nativeVirtualKey)
+void MirSurface::releaseAllPressedKeys()
 {
-    for (int i = 0; i < m_pressedKeys.count(); ++i) {
-        if (m_pressedKeys[i].nativeVirtualKey == nativeVirtualKey) {
-            m_pressedKeys.removeAt(i);
-            return;
-        }
+    if (m_pressedKeys.isEmpty()) {
+        return;
     }
-}
 
-void MirSurface::releaseAllPressedKeys()
-{
-    for (auto &pressedKey : m_pressedKeys) {
-        auto deltaMs = (ulong)(msecsSinceReference() - pressedKey.msecsSinceReference);
+    const qint64 now = msecsSinceReference();
+    m_pressedKeys.releaseAll([&](const PressedKey &pressedKey) {
+        auto deltaMs = (ulong)(now - pressedKey.msecsSinceReference);
         ulong timestamp = pressedKey.timestamp + deltaMs;
         std::vector<uint8_t> cookie{};
 
@@ -1516,14 +1731,5 @@ void MirSurface::releaseAllPressedKeys()
 
         auto ev1 = reinterpret_cast<MirKeyboardEvent const*>(ev.get());
         m_controller->deliverKeyboardEvent(m_window, ev1);
-    }
-    m_pressedKeys.clear();
-}
-
-MirSurface::PressedKey::PressedKey(QKeyEvent *qtEvent, qint64 msecsSinceReference)
-    : nativeVirtualKey(qtEvent->nativeVirtualKey())
-    , nativeScanCode(qtEvent->nativeScanCode())
-    , timestamp(qtEvent->timestamp())
-    , msecsSinceReference(msecsSinceReference)
-{
+    });
 }
@@ -17,8 +17,10 @@
 #ifndef QTMIR_MIRSURFACE_H
 #define QTMIR_MIRSURFACE_H
 
+#include "framepacer.h"
 #include "mirsurfaceinterface.h"
 #include "mirsurfacelistmodel.h"
+#include "pressedkeys.h"
 
 // Qt
 #include <QCursor>
@@ -124,6 +126,8 @@ public:
     void registerView(qintptr viewId) override;
     void unregisterView(qintptr viewId) override;
     void setViewExposure(qintptr viewId, bool exposed) override;
+    void setViewMaxFrameRate(qintptr viewId, qreal frameRate) override;
+    void setViewInputArea(qintptr viewId, const QRect &area) override;
 
     // methods called from the rendering (scene graph) thread:
     QSharedPointer<QSGTexture> texture() override;
@@ -198,13 +202,20 @@ private Q_SLOTS:
     void setCursor(const QCursor &cursor);
     void onCloseTimedOut();
     void setInputBounds(const QRect &rect);
+    void flushPendingPointerMotion();
 
 private:
     void syncSurfaceSizeWithItemSize();
     bool clientIsRunning() const;
     void updateExposure();
+    void updateMaxFrameRate();
+    void schedulePacedFrame(qint64 delay); // called with m_mutex locked
     void applyKeymap();
     void updateActiveFocus();
+    void updateDirectInputArea();
+    void recordDeliveryLatency(ulong qtTimestamp);
+    void updateRawPointerMotion();
+    void mergePointerMotion(QInputEvent *event);
     void updateVisible();
     void onNameChanged(const QString &name);
     void onMinimumWidthChanged(int minWidth);
@@ -218,8 +229,6 @@ private:
     void updatePosition();
 
     // Handling of missing key release events from Qt
-    bool isKeyPressed(quint32 nativeVirtualKey) const;
-    void forgetPressedKey(quint32 nativeVirtualKey);
     void releaseAllPressedKeys();
 
     const miral::Window m_window;
@@ -242,22 +251,29 @@ private:
 
     QTimer m_frameDropperTimer;
 
+    // Emits framesPosted() when a client frame held back by m_framePacer is due
+    QTimer m_pacedFrameTimer;
+
     mutable QMutex m_mutex;
 
     // Lives in the rendering (scene graph) thread
     QWeakPointer<QSGTexture> m_texture;
     bool m_textureUpdated;
     unsigned int m_currentFrameNumber;
+    FramePacer m_framePacer;
 
     bool m_ready{false};
     bool m_visible;
     bool m_live;
     struct View {
         bool exposed;
+        qreal maxFrameRate;
+        QRect inputArea;
     };
     QHash<qintptr, View> m_views;
 
     QSet<qintptr> m_activelyFocusedViews;
+    QRect m_directInputArea; // as last published in m_extraInfo
     bool m_neverSetSurfaceFocus{true};
 
     class SurfaceObserverImpl;
@@ -278,6 +294,12 @@ private:
 
     bool m_focused{false};
 
+    // Pointer motion (mouse or hover move) merged until all pending input events got handled.
+    // Only the latest event is kept, along with the sum of the relative motion of all of them.
+    QScopedPointer<QInputEvent> m_pendingPointerMotion;
+    QPointF m_pendingRelativeMotion;
+    bool m_requestsRawPointerMotion{false};
+
     enum ClosingState {
         NotClosing = 0,
         Closing = 1,
@@ -292,16 +314,7 @@ private:
     MirSurfaceListModel *m_childSurfaceList;
 
     // Track all keys that we told our mir window are currently pressed
-    struct PressedKey {
-        PressedKey() {}
-        PressedKey(QKeyEvent *qtEvent, qint64 msecsSinceReference);
-        quint32 nativeVirtualKey{0};
-        quint32 nativeScanCode{0};
-        ulong timestamp{0};
-        MirInputDeviceId deviceId{0};
-        qint64 msecsSinceReference{0};
-    };
-    QVector<PressedKey> m_pressedKeys;
+    PressedKeys m_pressedKeys;
 };
 
 } // namespace qtmir
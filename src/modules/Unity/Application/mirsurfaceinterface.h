@@ -25,6 +25,7 @@
 // Qt
 #include <QCursor>
 #include <QPoint>
+#include <QRect>
 #include <QSharedPointer>
 #include <QTouchEvent>
 
@@ -56,6 +57,18 @@ public:
     virtual void unregisterView(qintptr viewId) = 0;
     virtual void setViewExposure(qintptr viewId, bool exposed) = 0;
 
+    /*
+        Caps the rate at which the view wants new client frames, in frames per second. 0 means no cap.
+        The surface consumes client buffers no faster than its least throttled exposed view asks for.
+     */
+    virtual void setViewMaxFrameRate(qintptr viewId, qreal frameRate) = 0;
+
+    /*
+        Where the view draws the surface one to one on screen, in screen coordinates, or a null rect if it doesn't.
+        While an actively focused view has one, input to the surface can skip the shell.
+     */
+    virtual void setViewInputArea(qintptr viewId, const QRect &area) = 0;
+
     // methods called from the rendering (scene graph) thread:
     virtual QSharedPointer<QSGTexture> texture() = 0;
     virtual QSGTexture *weakTexture() const = 0;
@@ -121,6 +134,7 @@ Q_SIGNALS:
     void framesPosted();
     void isBeingDisplayedChanged();
     void frameDropped();
+    void activeFocusChanged(bool activeFocus);
 };
 
 } // namespace qtmir
@@ -17,13 +17,18 @@
 // local
 #include "application.h"
 #include "session.h"
+#include "mirbuffersgtexture.h"
 #include "mirsurfaceitem.h"
+#include "mirsurfacenode.h"
 #include "logging.h"
+#include "occlusiontracker.h"
 #include "tracepoints.h" // generated from tracepoints.tp
 #include "timestamp.h"
+#include "touchresampler.h"
 
 // common
 #include <debughelpers.h>
+#include <screenwindow.h>
 
 // Qt
 #include <QDebug>
@@ -42,6 +47,10 @@
 
 #include <QRunnable>
 
+// std
+#include <chrono>
+#include <cmath>
+
 namespace qtmir {
 
 namespace {
@@ -49,14 +58,41 @@ namespace {
 class MirSurfaceItemReleaseResourcesJob : public QRunnable
 {
 public:
-    MirSurfaceItemReleaseResourcesJob() : textureProvider(nullptr) {}
+    MirSurfaceItemReleaseResourcesJob() : textureProvider(nullptr), atlasTexture(nullptr) {}
     void run() {
         delete textureProvider;
         textureProvider = nullptr;
+        delete atlasTexture;
+        atlasTexture = nullptr;
     }
     QObject *textureProvider;
+    QSGTexture *atlasTexture;
 };
 
+// How long an item has to stay small before its client is told it's not worth rendering for
+const int lowDetailDelayMs = 500;
+
+bool touchResamplingEnabled()
+{
+    static const bool enabled = qgetenv("QTMIR_TOUCH_RESAMPLING") == "1";
+    return enabled;
+}
+
+bool surfaceAtlasEnabled()
+{
+    static const bool enabled = qgetenv("QTMIR_SURFACE_ATLAS") == "1";
+    return enabled;
+}
+
+// Largest client frame copied into the texture atlas. Beyond that the copy costs more than the draw call it saves.
+const int atlasSizeLimit = 256;
+
+// In the same time base as the timestamps of the input events Qt gets from QtEventFeeder
+ulong currentEventTimestamp()
+{
+    return compressTimestamp<qtmir::Timestamp>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 } // namespace {
 
 class MirTextureProvider : public QSGTextureProvider
@@ -90,6 +126,8 @@ MirSurfaceItem::MirSurfaceItem(QQuickItem *parent)
     , m_window(nullptr)
     , m_textureProvider(nullptr)
     , m_lastTouchEvent(nullptr)
+    , m_touchResampler(touchResamplingEnabled() ? new TouchResampler : nullptr)
+    , m_lastFrameSwapTime(0)
     , m_lastFrameNumberRendered(nullptr)
     , m_surfaceWidth(0)
     , m_surfaceHeight(0)
@@ -106,6 +144,10 @@ MirSurfaceItem::MirSurfaceItem(QQuickItem *parent)
     m_updateMirSurfaceSizeTimer.setInterval(1);
     connect(&m_updateMirSurfaceSizeTimer, &QTimer::timeout, this, &MirSurfaceItem::updateMirSurfaceSize);
 
+    m_lowDetailTimer.setSingleShot(true);
+    m_lowDetailTimer.setInterval(lowDetailDelayMs);
+    connect(&m_lowDetailTimer, &QTimer::timeout, this, &MirSurfaceItem::enterLowDetail);
+
     connect(this, &QQuickItem::activeFocusChanged, this, &MirSurfaceItem::updateMirSurfaceActiveFocus);
     connect(this, &QQuickItem::visibleChanged, this, &MirSurfaceItem::updateMirSurfaceExposure);
     connect(this, &QQuickItem::windowChanged, this, &MirSurfaceItem::onWindowChanged);
@@ -117,7 +159,12 @@ MirSurfaceItem::~MirSurfaceItem()
 
     setSurface(nullptr);
 
+    if (m_occlusionTracker) {
+        m_occlusionTracker->removeItem(this);
+    }
+
     delete m_lastTouchEvent;
+    delete m_touchResampler;
     delete m_lastFrameNumberRendered;
     delete m_orientationAngle;
 
@@ -220,13 +267,23 @@ QSGNode *MirSurfaceItem::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *
         if (m_textureProvider) {
             m_textureProvider->releaseTexture();
         }
+        releaseAtlasTexture();
+        m_opaqueContents = false;
         delete oldNode;
         return 0;
     }
 
+    if (m_occluded && oldNode && m_textureProvider && m_surface->weakTexture()
+            && m_textureProvider->texture() == m_surface->weakTexture()) {
+        // Nobody can see it. Leave the client frames where they are until it gets uncovered.
+        return oldNode;
+    }
+
     ensureTextureProvider();
 
     if (!m_textureProvider->texture() || !m_surface->updateTexture()) {
+        releaseAtlasTexture();
+        m_opaqueContents = false;
         delete oldNode;
         return 0;
     }
@@ -235,9 +292,76 @@ QSGNode *MirSurfaceItem::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *
         QTimer::singleShot(0, this, &MirSurfaceItem::update);
     }
 
+    // On scanout the display shows the client buffer as is and the scene doesn't get rendered. The node is kept
+    // up to date still, for the frames that get composed. Each new client frame gets offered, as it updates the item.
+    scanout();
+
     m_textureProvider->smooth = smooth();
-    QSGDefaultInternalImageNode *node = static_cast<QSGDefaultInternalImageNode*>(oldNode);
+    m_opaqueContents = m_fillMode == Stretch && !m_textureProvider->texture()->hasAlphaChannel();
+
+    QSGTexture *texture = atlasTexture();
+    if (!texture) {
+        texture = m_textureProvider->texture();
+    }
+
+    const bool newFrame = !m_lastFrameNumberRendered || *m_lastFrameNumberRendered != m_surface->currentFrameNumber();
+
+    QRectF targetRect(0, 0, width(), height());
+    QRectF sourceRect(0, 0, 1, 1);
+    if (m_fillMode == PadOrCrop) {
+        const QSize &textureSize = texture->textureSize();
+
+        targetRect.setWidth(qMin(width(), static_cast<qreal>(textureSize.width())));
+        targetRect.setHeight(qMin(height(), static_cast<qreal>(textureSize.height())));
+
+        sourceRect.setWidth(targetRect.width() / textureSize.width());
+        sourceRect.setHeight(targetRect.height() / textureSize.height());
+    }
+
+    QSGNode *node;
+    if (antialiasing()) {
+        node = updateImageNode(oldNode, texture, newFrame, targetRect, sourceRect);
+    } else {
+        node = updateSurfaceNode(oldNode, texture, newFrame, targetRect, sourceRect);
+    }
+
+    if (!m_lastFrameNumberRendered) {
+        m_lastFrameNumberRendered = new unsigned int;
+    }
+    *m_lastFrameNumberRendered = m_surface->currentFrameNumber();
+
+    return node;
+}
+
+// Called by render thread
+QSGNode *MirSurfaceItem::updateSurfaceNode(QSGNode *oldNode, QSGTexture *texture, bool newFrame,
+                                           const QRectF &targetRect, const QRectF &sourceRect)
+{
+    MirSurfaceNode *node = dynamic_cast<MirSurfaceNode*>(oldNode);
+    if (!node) {
+        delete oldNode;
+        node = new MirSurfaceNode;
+    }
+
+    if (texture != node->texture()) {
+        node->setTexture(texture);
+    } else if (newFrame) {
+        node->textureContentsChanged();
+    }
+    node->setRect(targetRect, sourceRect);
+    node->setFiltering(smooth() ? QSGTexture::Linear : QSGTexture::Nearest);
+
+    return node;
+}
+
+// Called by render thread
+// The generic image node, which can antialias the edges of the surface
+QSGNode *MirSurfaceItem::updateImageNode(QSGNode *oldNode, QSGTexture *texture, bool newFrame,
+                                         const QRectF &targetRect, const QRectF &sourceRect)
+{
+    QSGDefaultInternalImageNode *node = dynamic_cast<QSGDefaultInternalImageNode*>(oldNode);
     if (!node) {
+        delete oldNode;
 #if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
         QSGRenderContext *rc = QQuickWindowPrivate::get(window())->context;
         node = new QSGDefaultInternalImageNode(static_cast<QSGDefaultRenderContext *>(rc));
@@ -247,44 +371,83 @@ QSGNode *MirSurfaceItem::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *
         node->setMipmapFiltering(QSGTexture::None);
         node->setHorizontalWrapMode(QSGTexture::ClampToEdge);
         node->setVerticalWrapMode(QSGTexture::ClampToEdge);
-    } else {
-        if (!m_lastFrameNumberRendered  || (*m_lastFrameNumberRendered != m_surface->currentFrameNumber())) {
-            node->markDirty(QSGNode::DirtyMaterial);
-        }
+    } else if (newFrame) {
+        node->markDirty(QSGNode::DirtyMaterial);
     }
-    node->setTexture(m_textureProvider->texture());
+    node->setTexture(texture);
 
-    if (m_fillMode == PadOrCrop) {
-        const QSize &textureSize = m_textureProvider->texture()->textureSize();
+    node->setSubSourceRect(sourceRect);
+    node->setTargetRect(targetRect);
+    node->setInnerTargetRect(targetRect);
 
-        QRectF targetRect;
-        targetRect.setWidth(qMin(width(), static_cast<qreal>(textureSize.width())));
-        targetRect.setHeight(qMin(height(), static_cast<qreal>(textureSize.height())));
+    node->setFiltering(smooth() ? QSGTexture::Linear : QSGTexture::Nearest);
+    node->setAntialiasing(true);
 
-        qreal u = targetRect.width() / textureSize.width();
-        qreal v = targetRect.height() / textureSize.height();
-        node->setSubSourceRect(QRectF(0, 0, u, v));
+    node->update();
 
-        node->setTargetRect(targetRect);
-        node->setInnerTargetRect(targetRect);
-    } else {
-        // Stretch
-        node->setSubSourceRect(QRectF(0, 0, 1, 1));
-        node->setTargetRect(QRectF(0, 0, width(), height()));
-        node->setInnerTargetRect(QRectF(0, 0, width(), height()));
+    return node;
+}
+
+// Called by render thread
+void MirSurfaceItem::scanout()
+{
+    static const bool mirserverPlatform = qGuiApp->platformName() == QLatin1String("mirserver");
+    if (!mirserverPlatform || !window() || !window()->handle()) {
+        return;
     }
 
-    node->setFiltering(smooth() ? QSGTexture::Linear : QSGTexture::Nearest);
-    node->setAntialiasing(antialiasing());
+    auto texture = qobject_cast<MirBufferSGTexture*>(m_textureProvider->texture());
+    if (!texture || !texture->hasBuffer()) {
+        return;
+    }
 
-    node->update();
+    static_cast<ScreenWindow*>(window()->handle())->scanout(this, texture->buffer());
+}
 
-    if (!m_lastFrameNumberRendered) {
-        m_lastFrameNumberRendered = new unsigned int;
+// Called by render thread
+// A copy of the current client frame in the scene graph texture atlas, for the small transient surfaces (menus,
+// tooltips...) to get batched with the rest of the scene instead of costing a draw call each.
+QSGTexture *MirSurfaceItem::atlasTexture()
+{
+    auto texture = qobject_cast<MirBufferSGTexture*>(m_textureProvider->texture());
+    if (!surfaceAtlasEnabled() || !texture || !texture->hasBuffer() || !fitsInAtlas(texture->textureSize())) {
+        releaseAtlasTexture();
+        return nullptr;
     }
-    *m_lastFrameNumberRendered = m_surface->currentFrameNumber();
 
-    return node;
+    const unsigned int frameNumber = m_surface->currentFrameNumber();
+    if (m_atlasTexture && m_atlasFrameNumber == frameNumber) {
+        return m_atlasTexture;
+    }
+
+    releaseAtlasTexture();
+
+    // Only client frames in shm buffers can be copied
+    const QImage image = texture->toImage();
+    if (!image.isNull()) {
+        m_atlasTexture = window()->createTextureFromImage(image, QQuickWindow::TextureCanUseAtlas);
+        m_atlasFrameNumber = frameNumber;
+    }
+    return m_atlasTexture;
+}
+
+bool MirSurfaceItem::fitsInAtlas(const QSize &size) const
+{
+    switch (m_surface->type()) {
+    case Mir::MenuType:
+    case Mir::TipType:
+    case Mir::SatelliteType:
+        return size.width() <= atlasSizeLimit && size.height() <= atlasSizeLimit;
+    default:
+        return false;
+    }
+}
+
+// Called by render thread
+void MirSurfaceItem::releaseAtlasTexture()
+{
+    delete m_atlasTexture;
+    m_atlasTexture = nullptr;
 }
 
 void MirSurfaceItem::mousePressEvent(QMouseEvent *event)
@@ -413,6 +576,10 @@ void MirSurfaceItem::endCurrentTouchSequence(ulong timestamp)
 
         touchEvent.touchPoints.removeAt(0);
     }
+
+    if (m_touchResampler) {
+        m_touchResampler->reset();
+    }
 }
 
 void MirSurfaceItem::validateAndDeliverTouchEvent(int eventType,
@@ -421,6 +588,20 @@ void MirSurfaceItem::validateAndDeliverTouchEvent(int eventType,
             const QList<QTouchEvent::TouchPoint> &touchPoints,
             Qt::TouchPointStates touchPointStates)
 {
+    if (m_touchResampler) {
+        if (eventType == QEvent::TouchUpdate && TouchResampler::isMotion(touchPoints)
+                && m_lastTouchEvent && m_lastTouchEvent->type != QEvent::TouchEnd) {
+            // The client gets it on the next frame, moved to where the touch should be by then
+            m_touchResampler->queue({timestamp, mods, touchPoints, touchPointStates});
+            if (m_window) {
+                m_window->update();
+            }
+            tracepoint(qtmir, touchEventConsume_end, uncompressTimestamp<qtmir::Timestamp>(qtmir::Timestamp(timestamp)).count());
+            return;
+        }
+        flushQueuedTouchMotion();
+    }
+
     if (eventType == QEvent::TouchBegin && m_lastTouchEvent && m_lastTouchEvent->type != QEvent::TouchEnd) {
         qCWarning(QTMIR_SURFACES) << qPrintable(QStringLiteral("MirSurfaceItem(%1) - Got a QEvent::TouchBegin while "
             "there's still an active/unfinished touch sequence.").arg(appId()));
@@ -428,6 +609,25 @@ void MirSurfaceItem::validateAndDeliverTouchEvent(int eventType,
         endCurrentTouchSequence(timestamp);
     }
 
+    deliverTouchEvent(eventType, timestamp, mods, touchPoints, touchPointStates);
+
+    if (m_touchResampler) {
+        if (eventType == QEvent::TouchEnd) {
+            m_touchResampler->reset();
+        } else {
+            m_touchResampler->delivered({timestamp, mods, touchPoints, touchPointStates});
+        }
+    }
+
+    tracepoint(qtmir, touchEventConsume_end, uncompressTimestamp<qtmir::Timestamp>(qtmir::Timestamp(timestamp)).count());
+}
+
+void MirSurfaceItem::deliverTouchEvent(int eventType,
+            ulong timestamp,
+            Qt::KeyboardModifiers mods,
+            const QList<QTouchEvent::TouchPoint> &touchPoints,
+            Qt::TouchPointStates touchPointStates)
+{
     m_surface->touchEvent(mods, touchPoints, touchPointStates, timestamp);
 
     if (!m_lastTouchEvent) {
@@ -437,13 +637,58 @@ void MirSurfaceItem::validateAndDeliverTouchEvent(int eventType,
     m_lastTouchEvent->timestamp = timestamp;
     m_lastTouchEvent->touchPoints = touchPoints;
     m_lastTouchEvent->touchPointStates = touchPointStates;
+}
 
-    tracepoint(qtmir, touchEventConsume_end, uncompressTimestamp<ulong>(timestamp).count());
+void MirSurfaceItem::flushQueuedTouchMotion()
+{
+    if (!m_touchResampler->hasQueuedSamples()) {
+        return;
+    }
+
+    // Something else has to reach the client now, so the queued motion can't wait for the next frame
+    auto sample = m_touchResampler->takeLatest();
+    deliverTouchEvent(QEvent::TouchUpdate, sample.timestamp, sample.modifiers,
+                      sample.touchPoints, sample.touchPointStates);
+}
+
+void MirSurfaceItem::deliverResampledTouchEvent()
+{
+    if (!m_touchResampler || !m_touchResampler->hasQueuedSamples()) {
+        return;
+    }
+
+    if (!m_surface || !m_surface->live()) {
+        m_touchResampler->reset();
+        return;
+    }
+
+    auto sample = m_touchResampler->resample(nextVsyncTime());
+    deliverTouchEvent(QEvent::TouchUpdate, sample.timestamp, sample.modifiers,
+                      sample.touchPoints, sample.touchPointStates);
+}
+
+ulong MirSurfaceItem::nextVsyncTime() const
+{
+    qreal refreshRate = (m_window && m_window->screen()) ? m_window->screen()->refreshRate() : 0;
+    if (refreshRate <= 0) {
+        refreshRate = 60;
+    }
+    const qreal period = 1000 / refreshRate;
+
+    const ulong now = currentEventTimestamp();
+    const ulong lastSwap = m_lastFrameSwapTime;
+    if (lastSwap == 0 || lastSwap > now) {
+        return now + qRound(period);
+    }
+
+    // Frames follow each other one vsync period apart, starting from the last one swapped
+    const qreal framesSinceSwap = std::floor((now - lastSwap) / period) + 1;
+    return lastSwap + qRound64(framesSinceSwap * period);
 }
 
 void MirSurfaceItem::touchEvent(QTouchEvent *event)
 {
-    tracepoint(qtmir, touchEventConsume_start, uncompressTimestamp<ulong>(event->timestamp()).count());
+    tracepoint(qtmir, touchEventConsume_start, uncompressTimestamp<qtmir::Timestamp>(qtmir::Timestamp(event->timestamp())).count());
 
     bool accepted = processTouchEvent(event->type(),
             event->timestamp(),
@@ -520,20 +765,69 @@ void MirSurfaceItem::updateMirSurfaceExposure()
         return;
     }
 
-    m_surface->setViewExposure((qintptr)this, isVisible());
+    m_surface->setViewExposure((qintptr)this, isVisible() && !m_occluded && !m_lowDetail);
+}
+
+void MirSurfaceItem::setOccluded(bool occluded)
+{
+    if (occluded == m_occluded) {
+        return;
+    }
+
+    qCDebug(QTMIR_SURFACES).nospace() << "MirSurfaceItem::setOccluded(" << occluded << ") this=" << this;
+    m_occluded = occluded;
+    updateMirSurfaceExposure();
+
+    if (!m_occluded) {
+        update(); // catch up with the client frames it skipped
+    }
 }
 
 void MirSurfaceItem::updateMirSurfaceActiveFocus()
 {
     if (m_surface && m_surface->live()) {
         m_surface->setViewActiveFocus(qintptr(this), m_consumesInput && hasActiveFocus());
+        updateMirSurfaceInputArea();
     }
 }
 
+// Called before each frame of the window gets synchronized, as the item might have moved
+void MirSurfaceItem::updateMirSurfaceInputArea()
+{
+    if (m_surface) {
+        m_surface->setViewInputArea(qintptr(this), directInputArea());
+    }
+}
+
+// Where the item shows its surface one to one on screen, in screen coordinates. Null if it doesn't, as then
+// the surface can't make sense of input without the item mapping it.
+QRect MirSurfaceItem::directInputArea() const
+{
+    if (!m_window || !m_consumesInput || !hasActiveFocus() || !isVisible()
+            || orientationAngle() != Mir::Angle0 || m_window->effectiveDevicePixelRatio() != 1) {
+        return QRect();
+    }
+
+    const QSize surfaceSize = m_surface->size();
+    if (surfaceSize.isEmpty() || QSizeF(width(), height()) != QSizeF(surfaceSize)) {
+        return QRect();
+    }
+
+    bool ok = false;
+    const QTransform transform = itemTransform(nullptr, &ok);
+    if (!ok || transform.type() > QTransform::TxTranslate) {
+        return QRect();
+    }
+
+    const QPointF topLeft = transform.map(QPointF(0, 0)) + m_window->position();
+    return QRect(topLeft.toPoint(), surfaceSize);
+}
+
 void MirSurfaceItem::invalidateSceneGraph()
 {
     delete m_textureProvider;
     m_textureProvider = nullptr;
+    releaseAtlasTexture();
 }
 
 void MirSurfaceItem::TouchEvent::updateTouchPointStatesAndType()
@@ -596,6 +890,10 @@ void MirSurfaceItem::setSurface(unity::shell::application::MirSurfaceInterface *
         return;
     }
 
+    if (m_touchResampler) {
+        m_touchResampler->reset();
+    }
+
     if (m_surface) {
         disconnect(m_surface, nullptr, this, nullptr);
         m_surface->unregisterView((qintptr)this);
@@ -624,6 +922,7 @@ void MirSurfaceItem::setSurface(unity::shell::application::MirSurfaceInterface *
         updateMirSurfaceSize();
         setImplicitSize(m_surface->size().width(), m_surface->size().height());
         updateMirSurfaceExposure();
+        m_surface->setViewMaxFrameRate((qintptr)this, m_maxFrameRate);
 
         // Qt::ArrowCursor is the default when no cursor has been explicitly set, so no point forwarding it.
         if (m_surface->cursor().shape() != Qt::ArrowCursor) {
@@ -643,6 +942,7 @@ void MirSurfaceItem::setSurface(unity::shell::application::MirSurfaceInterface *
         updateMirSurfaceActiveFocus();
     }
 
+    updateDetailLevel();
     update();
 
     Q_EMIT surfaceChanged(m_surface);
@@ -653,6 +953,11 @@ void MirSurfaceItem::onCompositorSwappedBuffers()
     if (Q_LIKELY(m_surface)) {
         m_surface->onCompositorSwappedBuffers();
     }
+
+    if (m_touchResampler) {
+        m_lastFrameSwapTime = currentEventTimestamp();
+        QMetaObject::invokeMethod(this, "deliverResampledTouchEvent", Qt::QueuedConnection);
+    }
 }
 
 void MirSurfaceItem::onWindowChanged(QQuickWindow *window)
@@ -664,17 +969,31 @@ void MirSurfaceItem::onWindowChanged(QQuickWindow *window)
     if (m_window) {
         connect(m_window, &QQuickWindow::frameSwapped, this, &MirSurfaceItem::onCompositorSwappedBuffers,
                 Qt::DirectConnection);
+        connect(m_window, &QQuickWindow::afterAnimating, this, &MirSurfaceItem::updateDetailLevel);
+        connect(m_window, &QQuickWindow::afterAnimating, this, &MirSurfaceItem::updateMirSurfaceInputArea);
+    }
+
+    if (m_occlusionTracker) {
+        m_occlusionTracker->removeItem(this);
+        m_occlusionTracker = nullptr;
+    }
+    setOccluded(false);
+    if (m_window && OcclusionTracker::enabled()) {
+        m_occlusionTracker = OcclusionTracker::forWindow(m_window);
+        m_occlusionTracker->addItem(this);
     }
 }
 
 void MirSurfaceItem::releaseResources()
 {
-    if (m_textureProvider) {
+    if (m_textureProvider || m_atlasTexture) {
         Q_ASSERT(window());
 
         MirSurfaceItemReleaseResourcesJob *job = new MirSurfaceItemReleaseResourcesJob;
         job->textureProvider = m_textureProvider;
         m_textureProvider = nullptr;
+        job->atlasTexture = m_atlasTexture;
+        m_atlasTexture = nullptr;
         window()->scheduleRenderJob(job, QQuickWindow::AfterSynchronizingStage);
     }
 }
@@ -725,6 +1044,76 @@ void MirSurfaceItem::setFillMode(FillMode value)
     }
 }
 
+void MirSurfaceItem::setLowDetailThreshold(qreal threshold)
+{
+    if (threshold != m_lowDetailThreshold) {
+        m_lowDetailThreshold = threshold;
+        updateDetailLevel();
+        Q_EMIT lowDetailThresholdChanged(threshold);
+    }
+}
+
+void MirSurfaceItem::setMaxFrameRate(qreal frameRate)
+{
+    frameRate = qMax(frameRate, qreal(0));
+    if (frameRate != m_maxFrameRate) {
+        m_maxFrameRate = frameRate;
+        if (m_surface) {
+            m_surface->setViewMaxFrameRate((qintptr)this, m_maxFrameRate);
+        }
+        Q_EMIT maxFrameRateChanged(m_maxFrameRate);
+    }
+}
+
+// How big the item is drawn on screen relative to the size of its surface, along its smaller side
+qreal MirSurfaceItem::renderedScale() const
+{
+    const QSize surfaceSize = m_surface->size();
+    if (surfaceSize.isEmpty()) {
+        return 1;
+    }
+
+    const qreal devicePixelRatio = m_window ? m_window->effectiveDevicePixelRatio() : 1;
+    const QSizeF renderedSize = mapRectToScene(QRectF(0, 0, width(), height())).size() * devicePixelRatio;
+    return qMin(renderedSize.width() / surfaceSize.width(), renderedSize.height() / surfaceSize.height());
+}
+
+bool MirSurfaceItem::isDrawnSmall() const
+{
+    return m_lowDetailThreshold > 0 && m_surface && isVisible() && renderedScale() < m_lowDetailThreshold;
+}
+
+// Called before each frame of the window gets synchronized
+void MirSurfaceItem::updateDetailLevel()
+{
+    if (!isDrawnSmall()) {
+        m_lowDetailTimer.stop();
+        setLowDetail(false);
+    } else if (!m_lowDetail && !m_lowDetailTimer.isActive()) {
+        m_lowDetailTimer.start();
+    }
+}
+
+void MirSurfaceItem::enterLowDetail()
+{
+    // Unless it grew in the meantime without a frame being rendered
+    if (isDrawnSmall()) {
+        setLowDetail(true);
+    }
+}
+
+void MirSurfaceItem::setLowDetail(bool lowDetail)
+{
+    if (lowDetail == m_lowDetail) {
+        return;
+    }
+
+    qCDebug(QTMIR_SURFACES).nospace() << "MirSurfaceItem::setLowDetail(" << lowDetail << ") this=" << this;
+    m_lowDetail = lowDetail;
+    updateMirSurfaceExposure();
+    Q_EMIT lowDetailChanged(lowDetail);
+}
+
 } // namespace qtmir
 
 #include "mirsurfaceitem.moc"
@@ -17,10 +17,12 @@
 #ifndef MIRSURFACEITEM_H
 #define MIRSURFACEITEM_H
 
+#include <atomic>
 #include <memory>
 
 // Qt
 #include <QMutex>
+#include <QPointer>
 #include <QTimer>
 
 // Unity API
@@ -31,13 +33,31 @@
 
 namespace qtmir {
 
-class QSGMirSurfaceNode;
 class MirTextureProvider;
+class OcclusionTracker;
+class TouchResampler;
 
 class MirSurfaceItem : public unity::shell::application::MirSurfaceItemInterface
 {
     Q_OBJECT
 
+    /*
+        Fraction of the surface size below which the item is considered to show it as a thumbnail.
+        Once drawn that small for a while, its view is no longer reported as exposed, so that the client
+        can stop rendering frames nobody can make out. It's reported exposed again as soon as it grows.
+        0 (the default) disables it.
+     */
+    Q_PROPERTY(qreal lowDetailThreshold READ lowDetailThreshold WRITE setLowDetailThreshold
+               NOTIFY lowDetailThresholdChanged)
+    Q_PROPERTY(bool lowDetail READ lowDetail NOTIFY lowDetailChanged)
+
+    /*
+        Most frames per second the client should get to show through this item, eg. fewer for unfocused
+        windows or thumbnails. 0 (the default) means no limit. The surface takes new frames from its client
+        no faster than the least limited of the items exposing it allows.
+     */
+    Q_PROPERTY(qreal maxFrameRate READ maxFrameRate WRITE setMaxFrameRate NOTIFY maxFrameRateChanged)
+
 public:
     explicit MirSurfaceItem(QQuickItem *parent = 0);
     virtual ~MirSurfaceItem();
@@ -86,6 +106,25 @@ public:
             const QList<QTouchEvent::TouchPoint> &touchPoints,
             Qt::TouchPointStates touchPointStates);
 
+    // Whether it's hidden behind opaque content. See OcclusionTracker
+    bool isOccluded() const { return m_occluded; }
+    void setOccluded(bool occluded);
+
+    // Whether the last client frame drawn was opaque and covered the whole item
+    bool hasOpaqueContents() const { return m_opaqueContents; }
+
+    qreal lowDetailThreshold() const { return m_lowDetailThreshold; }
+    void setLowDetailThreshold(qreal threshold);
+
+    bool lowDetail() const { return m_lowDetail; }
+
+    qreal maxFrameRate() const { return m_maxFrameRate; }
+    void setMaxFrameRate(qreal frameRate);
+
+Q_SIGNALS:
+    void lowDetailThresholdChanged(qreal threshold);
+    void lowDetailChanged(bool lowDetail);
+    void maxFrameRateChanged(qreal frameRate);
 
 public Q_SLOTS:
     // Called by QQuickWindow from the rendering thread
@@ -115,14 +154,32 @@ private Q_SLOTS:
 
     void updateMirSurfaceActiveFocus();
     void updateMirSurfaceExposure();
+    void updateMirSurfaceInputArea();
 
     void onActualSurfaceSizeChanged(QSize size);
     void onCompositorSwappedBuffers();
 
     void onWindowChanged(QQuickWindow *window);
 
+    void updateDetailLevel();
+    void enterLowDetail();
+
+    void deliverResampledTouchEvent();
+
 private:
     void ensureTextureProvider();
+    void scanout();
+    QSGNode *updateSurfaceNode(QSGNode *oldNode, QSGTexture *texture, bool newFrame,
+                               const QRectF &targetRect, const QRectF &sourceRect);
+    QSGNode *updateImageNode(QSGNode *oldNode, QSGTexture *texture, bool newFrame,
+                             const QRectF &targetRect, const QRectF &sourceRect);
+    QSGTexture *atlasTexture();
+    bool fitsInAtlas(const QSize &size) const;
+    void releaseAtlasTexture();
+    qreal renderedScale() const;
+    bool isDrawnSmall() const;
+    QRect directInputArea() const;
+    void setLowDetail(bool lowDetail);
 
     bool hasTouchInsideInputRegion(const QList<QTouchEvent::TouchPoint> &touchPoints);
 
@@ -133,6 +190,13 @@ private:
             Qt::KeyboardModifiers modifiers,
             const QList<QTouchEvent::TouchPoint> &touchPoints,
             Qt::TouchPointStates touchPointStates);
+    void deliverTouchEvent(int eventType,
+            ulong timestamp,
+            Qt::KeyboardModifiers modifiers,
+            const QList<QTouchEvent::TouchPoint> &touchPoints,
+            Qt::TouchPointStates touchPointStates);
+    void flushQueuedTouchMotion();
+    ulong nextVsyncTime() const;
 
     MirSurfaceInterface* m_surface;
     QQuickWindow* m_window;
@@ -140,6 +204,10 @@ private:
     QMutex m_mutex;
     MirTextureProvider *m_textureProvider;
 
+    // Lives in the rendering (scene graph) thread
+    QSGTexture *m_atlasTexture{nullptr};
+    unsigned int m_atlasFrameNumber{0};
+
     QTimer m_updateMirSurfaceSizeTimer;
 
     class TouchEvent {
@@ -162,6 +230,11 @@ private:
         Qt::TouchPointStates touchPointStates;
     } *m_lastTouchEvent;
 
+    // Only when touch resampling is enabled
+    TouchResampler *m_touchResampler;
+    // Qt timestamp of the last frame swapped by m_window. Written from the scene graph thread.
+    std::atomic<ulong> m_lastFrameSwapTime;
+
     unsigned int *m_lastFrameNumberRendered;
 
     int m_surfaceWidth;
@@ -171,6 +244,17 @@ private:
     bool m_consumesInput;
 
     FillMode m_fillMode;
+
+    QPointer<OcclusionTracker> m_occlusionTracker;
+    bool m_occluded{false};
+    // Written from the scene graph thread
+    std::atomic<bool> m_opaqueContents{false};
+
+    qreal m_lowDetailThreshold{0};
+    bool m_lowDetail{false};
+    QTimer m_lowDetailTimer;
+
+    qreal m_maxFrameRate{0};
 };
 
 } // namespace qtmir
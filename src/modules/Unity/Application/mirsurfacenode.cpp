@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mirsurfacenode.h"
+
+namespace qtmir {
+
+MirSurfaceNode::MirSurfaceNode()
+    : m_geometry(QSGGeometry::defaultAttributes_TexturedPoint2D(), 4)
+    , m_textureSubRect(0, 0, 1, 1)
+{
+    setGeometry(&m_geometry);
+    setMaterial(&m_material);
+    setOpaqueMaterial(&m_opaqueMaterial);
+
+    m_opaqueMaterial.setHorizontalWrapMode(QSGTexture::ClampToEdge);
+    m_opaqueMaterial.setVerticalWrapMode(QSGTexture::ClampToEdge);
+    m_material.setHorizontalWrapMode(QSGTexture::ClampToEdge);
+    m_material.setVerticalWrapMode(QSGTexture::ClampToEdge);
+
+    updateGeometry();
+}
+
+void MirSurfaceNode::setTexture(QSGTexture *texture)
+{
+    if (texture == m_material.texture()) {
+        return;
+    }
+
+    m_opaqueMaterial.setTexture(texture);
+    m_material.setTexture(texture);
+    textureContentsChanged();
+}
+
+void MirSurfaceNode::textureContentsChanged()
+{
+    QSGTexture *texture = m_material.texture();
+    if (!texture) {
+        return;
+    }
+
+    // Clients can switch between buffers with and without alpha
+    m_opaqueMaterial.setFlag(QSGMaterial::Blending, texture->hasAlphaChannel());
+    markDirty(DirtyMaterial);
+
+    const QRectF subRect = texture->normalizedTextureSubRect();
+    if (subRect != m_textureSubRect) {
+        m_textureSubRect = subRect;
+        updateGeometry();
+    }
+}
+
+void MirSurfaceNode::setRect(const QRectF &targetRect, const QRectF &sourceRect)
+{
+    if (targetRect != m_targetRect || sourceRect != m_sourceRect) {
+        m_targetRect = targetRect;
+        m_sourceRect = sourceRect;
+        updateGeometry();
+    }
+}
+
+void MirSurfaceNode::setFiltering(QSGTexture::Filtering filtering)
+{
+    if (filtering != m_material.filtering()) {
+        m_opaqueMaterial.setFiltering(filtering);
+        m_material.setFiltering(filtering);
+        markDirty(DirtyMaterial);
+    }
+}
+
+void MirSurfaceNode::updateGeometry()
+{
+    const QRectF textureRect(m_textureSubRect.x() + m_sourceRect.x() * m_textureSubRect.width(),
+                             m_textureSubRect.y() + m_sourceRect.y() * m_textureSubRect.height(),
+                             m_sourceRect.width() * m_textureSubRect.width(),
+                             m_sourceRect.height() * m_textureSubRect.height());
+
+    QSGGeometry::updateTexturedRectGeometry(&m_geometry, m_targetRect, textureRect);
+    markDirty(DirtyGeometry);
+}
+
+} // namespace qtmir
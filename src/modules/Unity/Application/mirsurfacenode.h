@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QTMIR_MIRSURFACENODE_H
+#define QTMIR_MIRSURFACENODE_H
+
+#include <QSGGeometry>
+#include <QSGGeometryNode>
+#include <QSGTextureMaterial>
+
+namespace qtmir {
+
+/*
+    Draws part of a texture, typically a client frame, into a rectangle
+
+    Unlike the generic image nodes, its geometry is only touched when the rectangles change or the texture
+    moves around in an atlas, so a new client frame costs nothing more than binding its texture. Its plain
+    texture materials batch with any other node drawing the same texture.
+
+    Doesn't antialias its edges.
+ */
+class MirSurfaceNode : public QSGGeometryNode
+{
+public:
+    MirSurfaceNode();
+
+    // Not owned
+    void setTexture(QSGTexture *texture);
+    QSGTexture *texture() const { return m_material.texture(); }
+
+    // The texture got a new frame to show
+    void textureContentsChanged();
+
+    // sourceRect is in normalized texture coordinates
+    void setRect(const QRectF &targetRect, const QRectF &sourceRect);
+
+    void setFiltering(QSGTexture::Filtering filtering);
+
+private:
+    void updateGeometry();
+
+    QSGGeometry m_geometry;
+    QSGOpaqueTextureMaterial m_opaqueMaterial;
+    QSGTextureMaterial m_material;
+
+    QRectF m_targetRect;
+    QRectF m_sourceRect;
+    QRectF m_textureSubRect; // part of the texture's GL texture it occupies, in an atlas
+};
+
+} // namespace qtmir
+
+#endif // QTMIR_MIRSURFACENODE_H
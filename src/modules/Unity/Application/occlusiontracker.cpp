@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "occlusiontracker.h"
+
+#include "mirsurfaceitem.h"
+
+// Qt
+#include <QQuickItem>
+#include <QQuickWindow>
+#include <QtMath>
+#include <QtQuick/private/qquickitem_p.h>
+
+// std
+#include <cmath>
+
+namespace qtmir {
+
+namespace {
+
+QRectF sceneRectOf(QQuickItem *item)
+{
+    return item->mapRectToScene(QRectF(0, 0, item->width(), item->height()));
+}
+
+// The pixels fully inside rect
+QRect innerRect(const QRectF &rect)
+{
+    return QRect(QPoint(qCeil(rect.left()), qCeil(rect.top())),
+                 QPoint(qFloor(rect.right()) - 1, qFloor(rect.bottom()) - 1));
+}
+
+} // namespace
+
+OcclusionCuller::OcclusionCuller(const OpaqueFunction &isOpaque)
+    : m_isOpaque(isOpaque)
+{
+}
+
+QSet<const QQuickItem*> OcclusionCuller::occludedItems(QQuickItem *root, const QSet<const QQuickItem*> &items)
+{
+    m_items = items;
+    m_occluded.clear();
+    m_covered = QRegion();
+
+    if (root) {
+        visit(root, 1.0, true, sceneRectOf(root));
+    }
+
+    m_items.clear();
+    m_covered = QRegion();
+    return std::move(m_occluded);
+}
+
+// Visits the item subtree from front to back, ie. in the reverse order it gets painted in
+void OcclusionCuller::visit(QQuickItem *item, qreal opacity, bool axisAligned, const QRectF &clipRect)
+{
+    if (m_items.isEmpty() || !item->isVisible()) {
+        return;
+    }
+
+    opacity *= item->opacity();
+    if (qFuzzyIsNull(opacity)) {
+        return; // draws nothing, hides nothing
+    }
+
+    axisAligned = axisAligned && std::fmod(item->rotation(), 90) == 0
+            && QQuickItemPrivate::get(item)->transforms.isEmpty();
+
+    const QRectF sceneRect = sceneRectOf(item) & clipRect;
+    const QRectF childClipRect = item->clip() ? sceneRect : clipRect;
+
+    // Children with a negative z get painted before their parent, the others after it
+    const QList<QQuickItem*> children = QQuickItemPrivate::get(item)->paintOrderChildItems();
+    int i = children.count() - 1;
+    for (; i >= 0 && children.at(i)->z() >= 0; --i) {
+        visit(children.at(i), opacity, axisAligned, childClipRect);
+    }
+
+    visitContents(item, axisAligned && qFuzzyCompare(opacity, 1.0) && m_isOpaque(item), sceneRect);
+
+    for (; i >= 0; --i) {
+        visit(children.at(i), opacity, axisAligned, childClipRect);
+    }
+}
+
+void OcclusionCuller::visitContents(QQuickItem *item, bool opaque, const QRectF &sceneRect)
+{
+    if (m_items.remove(item) && !sceneRect.isEmpty()
+            && QRegion(sceneRect.toAlignedRect()).subtracted(m_covered).isEmpty()) {
+        m_occluded.insert(item);
+    }
+
+    if (opaque) {
+        const QRect rect = innerRect(sceneRect);
+        if (rect.isValid()) {
+            m_covered += rect;
+        }
+    }
+}
+
+bool OcclusionTracker::enabled()
+{
+    static const bool enabled = qgetenv("QTMIR_OCCLUSION_CULLING") == "1";
+    return enabled;
+}
+
+OcclusionTracker *OcclusionTracker::forWindow(QQuickWindow *window)
+{
+    auto tracker = window->findChild<OcclusionTracker*>(QString(), Qt::FindDirectChildrenOnly);
+    if (!tracker) {
+        tracker = new OcclusionTracker(window);
+    }
+    return tracker;
+}
+
+OcclusionTracker::OcclusionTracker(QQuickWindow *window)
+    : QObject(window)
+    , m_window(window)
+    , m_culler([](const QQuickItem *item) {
+        auto surfaceItem = qobject_cast<const MirSurfaceItem*>(item);
+        return surfaceItem && surfaceItem->hasOpaqueContents();
+    })
+{
+    connect(window, &QQuickWindow::afterAnimating, this, &OcclusionTracker::update);
+}
+
+void OcclusionTracker::addItem(MirSurfaceItem *item)
+{
+    m_items.insert(item);
+    m_window->update();
+}
+
+void OcclusionTracker::removeItem(MirSurfaceItem *item)
+{
+    m_items.remove(item);
+}
+
+void OcclusionTracker::update()
+{
+    if (m_items.isEmpty()) {
+        return;
+    }
+
+    QSet<const QQuickItem*> items;
+    items.reserve(m_items.count());
+    for (MirSurfaceItem *item : m_items) {
+        items.insert(item);
+    }
+
+    const QSet<const QQuickItem*> occluded = m_culler.occludedItems(m_window->contentItem(), items);
+
+    for (MirSurfaceItem *item : m_items) {
+        item->setOccluded(occluded.contains(item));
+    }
+}
+
+} // namespace qtmir
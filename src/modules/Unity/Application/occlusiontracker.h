@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QTMIR_OCCLUSIONTRACKER_H
+#define QTMIR_OCCLUSIONTRACKER_H
+
+#include <QObject>
+#include <QRectF>
+#include <QRegion>
+#include <QSet>
+
+#include <functional>
+
+class QQuickItem;
+class QQuickWindow;
+
+namespace qtmir {
+
+class MirSurfaceItem;
+
+/*
+    Finds out which items of an item tree are fully covered by opaque items drawn on top of them
+
+    Opaque items only count as such when they end up axis aligned and fully opaque on screen,
+    as the bounds of rotated items or of translucent ones don't hide what's under them.
+ */
+class OcclusionCuller
+{
+public:
+    // Whether the item paints its whole bounds with opaque content
+    using OpaqueFunction = std::function<bool(const QQuickItem*)>;
+
+    explicit OcclusionCuller(const OpaqueFunction &isOpaque);
+
+    // Those of the given items under root that can't be seen
+    QSet<const QQuickItem*> occludedItems(QQuickItem *root, const QSet<const QQuickItem*> &items);
+
+private:
+    void visit(QQuickItem *item, qreal opacity, bool axisAligned, const QRectF &clipRect);
+    void visitContents(QQuickItem *item, bool opaque, const QRectF &sceneRect);
+
+    const OpaqueFunction m_isOpaque;
+
+    // State of the current walk, from the front of the scene to its back
+    QSet<const QQuickItem*> m_items;
+    QSet<const QQuickItem*> m_occluded;
+    QRegion m_covered;
+};
+
+/*
+    Tells the MirSurfaceItems of a QQuickWindow whether they are hidden behind opaque content,
+    enabled with QTMIR_OCCLUSION_CULLING=1
+
+    Occluded items have their MirSurface view reported as not exposed, so that clients can throttle
+    their rendering, and stop consuming client buffers until they get uncovered.
+
+    Only MirSurfaceItems showing opaque client buffers stretched over their whole bounds count as
+    occluders. Items rendered somewhere else as well (eg. through a ShaderEffectSource or a layer)
+    might show stale contents there while occluded, so it shouldn't be used with a shell doing so.
+ */
+class OcclusionTracker : public QObject
+{
+    Q_OBJECT
+public:
+    static bool enabled();
+
+    // The tracker of that window, created as needed
+    static OcclusionTracker *forWindow(QQuickWindow *window);
+
+    void addItem(MirSurfaceItem *item);
+    void removeItem(MirSurfaceItem *item);
+
+private Q_SLOTS:
+    void update(); // GUI thread, before each frame gets synchronized
+
+private:
+    explicit OcclusionTracker(QQuickWindow *window);
+
+    QQuickWindow *const m_window;
+    QSet<MirSurfaceItem*> m_items;
+    OcclusionCuller m_culler;
+};
+
+} // namespace qtmir
+
+#endif // QTMIR_OCCLUSIONTRACKER_H
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pressedkeys.h"
+
+#include <QtAlgorithms>
+
+namespace qtmir {
+
+void PressedKeyTable::store(const PressedKey &key)
+{
+    Q_ASSERT(covers(key.nativeScanCode));
+
+    auto &page = m_pages[key.nativeScanCode / pageSize];
+    if (!page) {
+        page.reset(new Page);
+    }
+    (*page)[key.nativeScanCode % pageSize] = key;
+}
+
+const PressedKey &PressedKeyTable::at(quint32 nativeScanCode) const
+{
+    Q_ASSERT(covers(nativeScanCode) && m_pages[nativeScanCode / pageSize]);
+    return (*m_pages[nativeScanCode / pageSize])[nativeScanCode % pageSize];
+}
+
+PressedKeys::PressedKeys(const QSharedPointer<PressedKeyTable> &table)
+    : m_table(table ? table : QSharedPointer<PressedKeyTable>::create())
+{
+}
+
+void PressedKeys::press(const PressedKey &key)
+{
+    if (!PressedKeyTable::covers(key.nativeScanCode)) {
+        m_unscanned.append(key);
+        return;
+    }
+
+    Word &word = m_bits[key.nativeScanCode / wordBits];
+    const Word bit = Word(1) << (key.nativeScanCode % wordBits);
+    if (!(word & bit)) {
+        word |= bit;
+        ++m_count;
+    }
+    m_virtualKeys.insert(key.nativeScanCode, key.nativeVirtualKey);
+    m_table->store(key);
+}
+
+bool PressedKeys::isPressed(quint32 nativeScanCode, quint32 nativeVirtualKey) const
+{
+    if (!PressedKeyTable::covers(nativeScanCode)) {
+        for (const auto &key : m_unscanned) {
+            if (key.nativeVirtualKey == nativeVirtualKey) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    return m_bits[nativeScanCode / wordBits] & (Word(1) << (nativeScanCode % wordBits));
+}
+
+bool PressedKeys::release(quint32 nativeScanCode, quint32 nativeVirtualKey)
+{
+    if (!PressedKeyTable::covers(nativeScanCode)) {
+        for (int i = 0; i < m_unscanned.count(); ++i) {
+            if (m_unscanned[i].nativeVirtualKey == nativeVirtualKey) {
+                m_unscanned.removeAt(i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    Word &word = m_bits[nativeScanCode / wordBits];
+    const Word bit = Word(1) << (nativeScanCode % wordBits);
+    if (!(word & bit)) {
+        return false;
+    }
+    word &= ~bit;
+    --m_count;
+    m_virtualKeys.remove(nativeScanCode);
+    return true;
+}
+
+void PressedKeys::releaseAll(const std::function<void(const PressedKey &)> &releaseFunction)
+{
+    for (int i = 0; m_count > 0 && i < int(m_bits.size()); ++i) {
+        for (Word word = m_bits[i]; word != 0; word &= word - 1) {
+            PressedKey key = m_table->at(i * wordBits + qCountTrailingZeroBits(word));
+            key.nativeVirtualKey = m_virtualKeys.value(key.nativeScanCode);
+            releaseFunction(key);
+            --m_count;
+        }
+        m_bits[i] = 0;
+    }
+    m_virtualKeys.clear();
+
+    for (const auto &key : m_unscanned) {
+        releaseFunction(key);
+    }
+    m_unscanned.clear();
+}
+
+} // namespace qtmir
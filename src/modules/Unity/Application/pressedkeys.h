@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QTMIR_PRESSEDKEYS_H
+#define QTMIR_PRESSEDKEYS_H
+
+#include <mir_toolkit/event.h>
+
+#include <QHash>
+#include <QSharedPointer>
+#include <QVector>
+
+#include <array>
+#include <functional>
+#include <memory>
+
+namespace qtmir {
+
+struct PressedKey {
+    quint32 nativeVirtualKey{0};
+    quint32 nativeScanCode{0};
+    ulong timestamp{0};
+    MirInputDeviceId deviceId{0};
+    qint64 msecsSinceReference{0};
+};
+
+/*
+    The latest press of each key, indexed by scan code.
+
+    Shared by the surfaces of a session: a key can only be held down once, whichever of them
+    got the press, so its timestamp and device are the same for all. Not its virtual key though,
+    which is up to the keymap, see PressedKeys. Entries are allocated in pages of 64 keys as they
+    get written, since only a few ranges of scan codes ever get used.
+ */
+class PressedKeyTable
+{
+public:
+    static const int keyCount = 768; // evdev scan codes (KEY_CNT)
+
+    // Whether the key is tracked here. Keys without a scan code (eg. synthesized ones) are not.
+    static bool covers(quint32 nativeScanCode) { return nativeScanCode > 0 && nativeScanCode < keyCount; }
+
+    void store(const PressedKey &key);
+    const PressedKey &at(quint32 nativeScanCode) const; // must have been stored
+
+private:
+    static const int pageSize = 64;
+    using Page = std::array<PressedKey, pageSize>;
+    std::array<std::unique_ptr<Page>, keyCount / pageSize> m_pages;
+};
+
+/*
+    The keys a surface told its client are pressed.
+
+    A bit per scan code, with the details in its session's PressedKeyTable. So pressing, releasing
+    and checking a key take constant time, and releasing them all only visits the keys that are down.
+    The virtual key each got pressed as stays with the surface, as another surface of the session
+    might have pressed the same scan code as another key since.
+    The odd key without a scan code is kept in a list of its own, matched by virtual key.
+ */
+class PressedKeys
+{
+public:
+    explicit PressedKeys(const QSharedPointer<PressedKeyTable> &table);
+
+    void press(const PressedKey &key);
+    bool isPressed(quint32 nativeScanCode, quint32 nativeVirtualKey) const;
+
+    // Returns whether the key was pressed
+    bool release(quint32 nativeScanCode, quint32 nativeVirtualKey);
+
+    // Calls releaseFunction with each pressed key, in no particular order, and forgets them all
+    void releaseAll(const std::function<void(const PressedKey &)> &releaseFunction);
+
+    bool isEmpty() const { return m_count == 0 && m_unscanned.isEmpty(); }
+
+private:
+    using Word = quint64;
+    static const int wordBits = 64;
+
+    QSharedPointer<PressedKeyTable> m_table;
+    std::array<Word, PressedKeyTable::keyCount / wordBits> m_bits{};
+    int m_count{0};
+    QHash<quint32, quint32> m_virtualKeys; // by scan code, of the keys down
+    QVector<PressedKey> m_unscanned;
+};
+
+} // namespace qtmir
+
+#endif // QTMIR_PRESSEDKEYS_H
@@ -90,4 +90,39 @@ QString ProcInfo::Environment::getParameter(const char* name) const
     return QString(regExpMatch.captured(1));
 }
 
+QString ProcInfo::cgroup(pid_t pid, const char* controller)
+{
+    QFile cgroups(QStringLiteral("/proc/%1/cgroup").arg(pid));
+    if (!cgroups.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return QString();
+    }
+
+    return cgroupFromProcFile(cgroups.readAll(), controller);
+}
+
+QString ProcInfo::cgroupFromProcFile(const QByteArray &contents, const char* controller)
+{
+    QString unifiedPath;
+
+    // Each line is "hierarchy-ID:controller-list:cgroup-path". The cgroup v2 hierarchy is "0::cgroup-path".
+    for (const QByteArray &rawLine : contents.split('\n')) {
+        const QByteArray line = rawLine.trimmed();
+        const int controllersStart = line.indexOf(':') + 1;
+        const int pathStart = line.indexOf(':', controllersStart) + 1;
+        if (controllersStart == 0 || pathStart == 0) {
+            continue;
+        }
+
+        const QByteArray controllerList = line.mid(controllersStart, pathStart - controllersStart - 1);
+        if (controllerList.isEmpty()) {
+            if (line.startsWith("0:")) {
+                unifiedPath = QString::fromLocal8Bit(line.mid(pathStart));
+            }
+        } else if (controllerList.split(',').contains(controller)) {
+            return QString::fromLocal8Bit(line.mid(pathStart));
+        }
+    }
+    return unifiedPath;
+}
+
 } // namespace qtmir
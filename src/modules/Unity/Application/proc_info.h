@@ -52,7 +52,13 @@ public:
 
     virtual std::unique_ptr<CommandLine> commandLine(pid_t pid);
     virtual std::unique_ptr<Environment> environment(pid_t pid);
+    // Path of the cgroup the process belongs to in the hierarchy of the given controller
+    virtual QString cgroup(pid_t pid, const char* controller);
     virtual ~ProcInfo() = default;
+
+    // Picks that path out of the contents of /proc/<pid>/cgroup. Falls back to the cgroup v2 unified
+    // hierarchy, which holds all controllers not bound to a v1 hierarchy.
+    static QString cgroupFromProcFile(const QByteArray &contents, const char* controller);
 };
 
 } // namespace qtmir
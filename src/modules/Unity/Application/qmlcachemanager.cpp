@@ -0,0 +1,291 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "qmlcachemanager.h"
+
+// QPA mirserver
+#include "logging.h"
+
+// Qt
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QHash>
+#include <QStandardPaths>
+#include <QTimer>
+
+// std
+#include <algorithm>
+
+namespace qtmir {
+
+namespace {
+
+const char invalidPrefix[] = ".invalid-";
+
+// Delay before purging, so that several applications going away in a row cause a single pass
+const int purgeDelayMs = 10000;
+
+const qint64 defaultBudgetBytes = 64 * 1024 * 1024;
+
+qint64 budgetFromEnvironment()
+{
+    bool ok;
+    qint64 megabytes = qgetenv("QTMIR_QML_CACHE_BUDGET_MB").toLongLong(&ok);
+    return ok ? megabytes * 1024 * 1024 : defaultBudgetBytes;
+}
+
+qint64 directorySize(const QString &path)
+{
+    qint64 size = 0;
+    QDirIterator it(path, QDir::Files | QDir::Hidden | QDir::NoSymLinks, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+        size += it.fileInfo().size();
+    }
+    return size;
+}
+
+} // namespace
+
+/*
+   Lives in the QmlCacheManager thread. Keeps an index of the cache directories found under
+   the cache root, so that finding the cache of an application does not require listing the
+   directory on each request.
+ */
+class QmlCacheWorker : public QObject
+{
+    Q_OBJECT
+public:
+    QmlCacheWorker(const QString &cacheRoot, qint64 budgetBytes)
+        : m_root(cacheRoot)
+        , m_budgetBytes(budgetBytes)
+        , m_purgeTimer(new QTimer(this))
+    {
+        m_purgeTimer->setSingleShot(true);
+        m_purgeTimer->setInterval(purgeDelayMs);
+        connect(m_purgeTimer, &QTimer::timeout, this, &QmlCacheWorker::purge);
+    }
+
+public Q_SLOTS:
+    void markUsed(const QString &appId)
+    {
+        // keep use times strictly increasing, so that the LRU order is well defined
+        const qint64 now = std::max(QDateTime::currentMSecsSinceEpoch(), m_latestUse + 1);
+        m_latestUse = now;
+        m_lastUsed[appId] = now;
+
+        for (const QString &dirName : findCacheDirs(appId)) {
+            m_index[dirName].lastUsed = now;
+        }
+
+        m_purgeTimer->start();
+    }
+
+    void invalidate(const QString &appId)
+    {
+        const QStringList dirNames = findCacheDirs(appId);
+        if (dirNames.isEmpty()) {
+            return;
+        }
+
+        // A rename is cheap and atomic, and gets the cache out of the way of the next instance
+        // of the application. The actual deletion is left for the next purge.
+        for (const QString &dirName : dirNames) {
+            const QString invalidName = QLatin1String(invalidPrefix) + dirName + QLatin1Char('-')
+                    + QString::number(QDateTime::currentMSecsSinceEpoch());
+            if (m_root.rename(dirName, invalidName)) {
+                qCDebug(QTMIR_APPLICATIONS) << "QmlCacheManager: invalidated QML cache" << dirName << "of appId=" << appId;
+            } else {
+                qCWarning(QTMIR_APPLICATIONS) << "QmlCacheManager: failed to invalidate QML cache" << dirName
+                                              << "of appId=" << appId << "deleting it now";
+                QDir(m_root.filePath(dirName)).removeRecursively();
+            }
+            m_index.remove(dirName);
+        }
+
+        m_purgeTimer->start();
+    }
+
+    void purge()
+    {
+        m_purgeTimer->stop();
+
+        const QStringList invalidDirs = m_root.entryList(QStringList() << QString(QLatin1String(invalidPrefix) + QLatin1Char('*')),
+                                                         QDir::Dirs | QDir::Hidden | QDir::NoDotAndDotDot);
+        for (const QString &dirName : invalidDirs) {
+            QDir(m_root.filePath(dirName)).removeRecursively();
+        }
+
+        refreshIndex();
+
+        qint64 totalBytes = 0;
+        for (auto it = m_index.begin(); it != m_index.end(); ++it) {
+            // A cache only grows while its application runs, so only measure it again if it got used since
+            if (it->size < 0 || it->lastUsed > it->measuredAt) {
+                it->size = directorySize(m_root.filePath(it.key()));
+                it->measuredAt = QDateTime::currentMSecsSinceEpoch();
+            }
+            totalBytes += it->size;
+        }
+
+        if (m_budgetBytes > 0 && totalBytes > m_budgetBytes) {
+            QStringList byAge = m_index.keys();
+            std::sort(byAge.begin(), byAge.end(), [this](const QString &a, const QString &b) {
+                return m_index[a].lastUsed < m_index[b].lastUsed;
+            });
+
+            for (const QString &dirName : byAge) {
+                if (totalBytes <= m_budgetBytes) {
+                    break;
+                }
+                qCDebug(QTMIR_APPLICATIONS) << "QmlCacheManager: evicting least recently used QML cache" << dirName;
+                QDir(m_root.filePath(dirName)).removeRecursively();
+                totalBytes -= m_index.take(dirName).size;
+            }
+        }
+
+        Q_EMIT purged(totalBytes);
+    }
+
+Q_SIGNALS:
+    void purged(qint64 totalBytes);
+
+private:
+    struct Entry {
+        qint64 size{-1};
+        qint64 measuredAt{0};
+        qint64 lastUsed{0};
+    };
+
+    void refreshIndex()
+    {
+        const QStringList dirNames = m_root.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+
+        for (auto it = m_index.begin(); it != m_index.end();) {
+            if (dirNames.contains(it.key())) {
+                ++it;
+            } else {
+                it = m_index.erase(it);
+            }
+        }
+
+        for (const QString &dirName : dirNames) {
+            if (m_index.contains(dirName)) {
+                continue;
+            }
+            Entry entry;
+            entry.lastUsed = QFileInfo(m_root.filePath(dirName)).lastModified().toMSecsSinceEpoch();
+            for (auto it = m_lastUsed.constBegin(); it != m_lastUsed.constEnd(); ++it) {
+                if (isCacheDirOf(dirName, it.key())) {
+                    entry.lastUsed = std::max(entry.lastUsed, it.value());
+                }
+            }
+            m_index.insert(dirName, entry);
+        }
+
+        m_indexed = true;
+    }
+
+    QStringList findCacheDirs(const QString &appId)
+    {
+        if (!m_indexed) {
+            refreshIndex();
+        }
+
+        QStringList dirNames = matchCacheDirs(appId);
+        if (dirNames.isEmpty()) {
+            // the application may have created its cache after the last refresh
+            refreshIndex();
+            dirNames = matchCacheDirs(appId);
+        }
+        return dirNames;
+    }
+
+    QStringList matchCacheDirs(const QString &appId) const
+    {
+        QStringList dirNames;
+        for (auto it = m_index.constBegin(); it != m_index.constEnd(); ++it) {
+            if (isCacheDirOf(it.key(), appId)) {
+                dirNames << it.key();
+            }
+        }
+        return dirNames;
+    }
+
+    // Applications keep their cache in a directory named after their appId, or their versioned appId
+    // ("foo_1.0"). Nothing looser will do, as appIds can be substrings of one another ("foo" and "foo-bar").
+    static bool isCacheDirOf(const QString &dirName, const QString &appId)
+    {
+        return dirName == appId || dirName.startsWith(appId + QLatin1Char('_'));
+    }
+
+    QDir m_root;
+    const qint64 m_budgetBytes;
+    bool m_indexed{false};
+    QHash<QString, Entry> m_index; // cache directory name -> entry
+    QHash<QString, qint64> m_lastUsed; // appId -> msecs since epoch
+    qint64 m_latestUse{0};
+    QTimer *m_purgeTimer;
+};
+
+#include "qmlcachemanager.moc"
+
+QmlCacheManager::QmlCacheManager(const QString &cacheRoot, qint64 budgetBytes, QObject *parent)
+    : QObject(parent)
+    , m_worker(new QmlCacheWorker(cacheRoot, budgetBytes))
+{
+    m_thread.setObjectName(QStringLiteral("QmlCacheManager"));
+    m_worker->moveToThread(&m_thread);
+    connect(&m_thread, &QThread::finished, m_worker, &QObject::deleteLater);
+    connect(m_worker, &QmlCacheWorker::purged, this, &QmlCacheManager::purged);
+    m_thread.start(QThread::LowestPriority);
+}
+
+QmlCacheManager::~QmlCacheManager()
+{
+    m_thread.quit();
+    m_thread.wait();
+}
+
+QmlCacheManager* QmlCacheManager::singleton()
+{
+    static QmlCacheManager* instance;
+    if (!instance) {
+        instance = new QmlCacheManager(
+                QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QStringLiteral("/QML/Apps/"),
+                budgetFromEnvironment());
+    }
+    return instance;
+}
+
+void QmlCacheManager::markUsed(const QString &appId)
+{
+    QMetaObject::invokeMethod(m_worker, "markUsed", Qt::QueuedConnection, Q_ARG(QString, appId));
+}
+
+void QmlCacheManager::invalidate(const QString &appId)
+{
+    QMetaObject::invokeMethod(m_worker, "invalidate", Qt::QueuedConnection, Q_ARG(QString, appId));
+}
+
+void QmlCacheManager::purge()
+{
+    QMetaObject::invokeMethod(m_worker, "purge", Qt::QueuedConnection);
+}
+
+} // namespace qtmir
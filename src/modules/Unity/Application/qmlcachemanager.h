@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QTMIR_QMLCACHEMANAGER_H
+#define QTMIR_QMLCACHEMANAGER_H
+
+#include <QObject>
+#include <QThread>
+
+namespace qtmir {
+
+class QmlCacheWorker;
+
+/*
+   Manages the QML compile caches that applications leave in ~/.cache/QML/Apps/
+
+   All filesystem work happens on a low priority background thread, so that an application
+   going away never stalls the shell on slow storage. Caches of applications that may have
+   crashed are invalidated (moved out of the application's way) and only deleted later, when
+   the worker evicts the least recently used caches to keep the total size under a budget.
+ */
+class QmlCacheManager : public QObject
+{
+    Q_OBJECT
+public:
+    // budgetBytes <= 0 disables eviction of valid caches
+    explicit QmlCacheManager(const QString &cacheRoot, qint64 budgetBytes, QObject *parent = nullptr);
+    virtual ~QmlCacheManager();
+
+    static QmlCacheManager* singleton();
+
+    // Records that the application is in use, so its cache is the last one to be evicted
+    void markUsed(const QString &appId);
+
+    // Makes sure the application will not reuse its current cache, which gets deleted later on
+    void invalidate(const QString &appId);
+
+    // Deletes invalidated caches and evicts least recently used ones until under budget
+    void purge();
+
+Q_SIGNALS:
+    // Emitted from the worker thread once a purge has finished. For tests.
+    void purged(qint64 totalBytes);
+
+private:
+    QThread m_thread;
+    QmlCacheWorker *m_worker;
+
+    Q_DISABLE_COPY(QmlCacheManager)
+};
+
+} // namespace qtmir
+
+#endif // QTMIR_QMLCACHEMANAGER_H
@@ -20,6 +20,7 @@
 #include "session.h"
 #include "mirsurfaceinterface.h"
 #include "mirsurfaceitem.h"
+#include "pressedkeys.h"
 #include "promptsession.h"
 
 // mirserver
@@ -74,6 +75,7 @@ Session::Session(const std::shared_ptr<ms::Session>& session,
     , m_state(State::Starting)
     , m_live(true)
     , m_promptSessionManager(promptSessionManager)
+    , m_pressedKeyTable(QSharedPointer<PressedKeyTable>::create())
 {
     DEBUG_MSG << "()";
 
@@ -142,6 +144,11 @@ MirSurfaceListModel* Session::promptSurfaceList()
     return &m_promptSurfaceList;
 }
 
+QSharedPointer<PressedKeyTable> Session::pressedKeyTable() const
+{
+    return m_pressedKeyTable;
+}
+
 Session::State Session::state() const
 {
     return m_state;
@@ -57,6 +57,7 @@ public:
     void setApplication(unity::shell::application::ApplicationInfoInterface* item) override;
 
     void registerSurface(MirSurfaceInterface* surface) override;
+    QSharedPointer<PressedKeyTable> pressedKeyTable() const override;
 
     void suspend() override;
     void resume() override;
@@ -122,6 +123,7 @@ protected:
     std::shared_ptr<PromptSessionManager> const m_promptSessionManager;
     QList<MirSurfaceInterface*> m_closingSurfaces;
     bool m_hadSurface{false};
+    QSharedPointer<PressedKeyTable> m_pressedKeyTable;
 };
 
 } // namespace qtmir
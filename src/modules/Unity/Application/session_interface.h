@@ -29,6 +29,7 @@
 
 // Qt
 #include <QQmlListProperty>
+#include <QSharedPointer>
 
 namespace mir {
     namespace scene {
@@ -40,6 +41,7 @@ namespace qtmir {
 
 class MirSurfaceInterface;
 class MirSurfaceListModel;
+class PressedKeyTable;
 class PromptSession;
 
 class SessionInterface : public QObject {
@@ -83,6 +85,9 @@ public:
 
     virtual void registerSurface(MirSurfaceInterface* surface) = 0;
 
+    // Details of the keys its surfaces got pressed, shared by all of them. See PressedKeys
+    virtual QSharedPointer<PressedKeyTable> pressedKeyTable() const = 0;
+
     // For Application use
 
     virtual void setApplication(unity::shell::application::ApplicationInfoInterface* item) = 0;
@@ -22,6 +22,7 @@
 #include <QDBusPendingCallWatcher>
 #include <QDBusPendingReply>
 #include <QFile>
+#include <QTimer>
 
 namespace qtmir {
 
@@ -31,31 +32,46 @@ const char cookieFile[] = "/tmp/qtmir_powerd_cookie";
 /**
  * @brief The Wakelock class - wraps a single system wakelock
  * Should the PowerD service vanish from the bus, the wakelock will be re-acquired when it re-joins the bus.
+ *
+ * Only releases are debounced: an acquire is sent right away whenever the wakelock isn't held, as the
+ * device could suspend in the meantime. A release is applied once a hold-off window expires, and only if
+ * the wakelock is still unwanted by then. So a storm of acquire/release calls results in at most one
+ * acquisition and one release per window, and a release immediately followed by an acquire in none.
  */
 class Wakelock : public AbstractDBusServiceMonitor
 {
     Q_OBJECT
 public:
-    Wakelock(const QDBusConnection &connection) noexcept
+    Wakelock(const QDBusConnection &connection, int holdOffMs) noexcept
         : AbstractDBusServiceMonitor(QStringLiteral("com.canonical.powerd"), QStringLiteral("/com/canonical/powerd"), QStringLiteral("com.canonical.powerd"), connection)
         , m_wakelockEnabled(false)
+        , m_wakelockWanted(false)
     {
         // (re-)acquire wake lock when powerd (re-)appears on the bus
         QObject::connect(this, &Wakelock::serviceAvailableChanged,
                          this, &Wakelock::onServiceAvailableChanged);
 
+        m_holdOffTimer.setSingleShot(true);
+        m_holdOffTimer.setInterval(holdOffMs);
+        QObject::connect(&m_holdOffTimer, &QTimer::timeout,
+                         this, &Wakelock::onHoldOffTimeout);
+
         // WORKAROUND: if shell crashed while it held a wakelock, due to bug lp:1409722 powerd will not have released
         // the wakelock for it. As workaround, we save the cookie to file and restore it if possible.
         QFile cookieCache(cookieFile);
         if (cookieCache.exists() && cookieCache.open(QFile::ReadOnly | QFile::Text)) {
             m_wakelockEnabled = true;
+            m_wakelockWanted = true;
             m_cookie = cookieCache.readAll();
+            m_savedCookie = m_cookie;
         }
     }
 
     virtual ~Wakelock() noexcept
     {
-        release();
+        m_holdOffTimer.stop();
+        m_wakelockWanted = false;
+        releaseWakelock();
     }
 
     Q_SIGNAL void enabledChanged(bool);
@@ -66,37 +82,32 @@ public:
 
     void acquire()
     {
-        if (m_wakelockEnabled) { // wakelock already requested/set
-            return;
-        }
-        m_wakelockEnabled = true;
+        m_wakelockWanted = true;
 
-        acquireWakelock();
+        // Never wait to acquire, a pending release is simply cancelled
+        if (!m_wakelockEnabled) {
+            acquireWakelock();
+        }
     }
 
     void release()
     {
-        QFile::remove(cookieFile);
-
-        if (!m_wakelockEnabled) { // no wakelock already requested/set
-            return;
-        }
-        m_wakelockEnabled = false;
-        Q_EMIT enabledChanged(false);
+        m_wakelockWanted = false;
 
-        if (!serviceAvailable()) {
-            qWarning() << "com.canonical.powerd DBus interface not available, presuming no wakelocks held";
-            return;
+        // Releasing is never urgent, wait for the window to expire in case the wakelock gets acquired again
+        if (!m_holdOffTimer.isActive()) {
+            m_holdOffTimer.start();
         }
+    }
 
-        if (!m_cookie.isEmpty()) {
-            dbusInterface()->asyncCall(QStringLiteral("clearSysState"), QString(m_cookie));
-            qCDebug(QTMIR_SESSIONS) << "Wakelock released" << m_cookie;
-            m_cookie.clear();
+private Q_SLOTS:
+    void onHoldOffTimeout()
+    {
+        if (!m_wakelockWanted && m_wakelockEnabled) {
+            releaseWakelock();
         }
     }
 
-private Q_SLOTS:
     void onServiceAvailableChanged(bool available)
     {
         // Assumption is if service vanishes & reappears on the bus, it has lost its wakelock state and
@@ -106,10 +117,10 @@ private Q_SLOTS:
         }
 
         if (available) {
-            acquireWakelock();
+            requestSysState();
         } else {
             m_cookie.clear();
-            QFile::remove(cookieFile);
+            saveCookie();
         }
     }
 
@@ -137,11 +148,7 @@ private Q_SLOTS:
         }
 
         m_cookie = cookie;
-
-        // see WORKAROUND above for why we save cookie to disk
-        QFile cookieCache(cookieFile);
-        cookieCache.open(QFile::WriteOnly | QFile::Text);
-        cookieCache.write(m_cookie);
+        saveCookie();
 
         qCDebug(QTMIR_SESSIONS) << "Wakelock acquired" << m_cookie;
         Q_EMIT enabledChanged(true);
@@ -149,6 +156,35 @@ private Q_SLOTS:
 
 private:
     void acquireWakelock()
+    {
+        m_wakelockEnabled = true;
+        requestSysState();
+    }
+
+    void releaseWakelock()
+    {
+        const QByteArray cookie = m_cookie;
+        m_cookie.clear();
+        saveCookie();
+
+        if (!m_wakelockEnabled) { // no wakelock already requested/set
+            return;
+        }
+        m_wakelockEnabled = false;
+        Q_EMIT enabledChanged(false);
+
+        if (!serviceAvailable()) {
+            qWarning() << "com.canonical.powerd DBus interface not available, presuming no wakelocks held";
+            return;
+        }
+
+        if (!cookie.isEmpty()) {
+            dbusInterface()->asyncCall(QStringLiteral("clearSysState"), QString(cookie));
+            qCDebug(QTMIR_SESSIONS) << "Wakelock released" << cookie;
+        }
+    }
+
+    void requestSysState()
     {
         if (!serviceAvailable()) {
             qWarning() << "com.canonical.powerd DBus interface not available, waiting for it";
@@ -162,8 +198,28 @@ private:
                          this, &Wakelock::onWakeLockAcquired);
     }
 
+    // See WORKAROUND above for why we save cookie to disk. Only touch the file when its content changes.
+    void saveCookie()
+    {
+        if (m_cookie == m_savedCookie) {
+            return;
+        }
+
+        if (m_cookie.isEmpty()) {
+            QFile::remove(cookieFile);
+        } else {
+            QFile cookieCache(cookieFile);
+            cookieCache.open(QFile::WriteOnly | QFile::Text);
+            cookieCache.write(m_cookie);
+        }
+        m_savedCookie = m_cookie;
+    }
+
     QByteArray m_cookie;
+    QByteArray m_savedCookie;
     bool m_wakelockEnabled;
+    bool m_wakelockWanted;
+    QTimer m_holdOffTimer;
 
     Q_DISABLE_COPY(Wakelock)
 };
@@ -183,8 +239,8 @@ private:
  * Note a caller cannot have multiple shares of the wakelock. Multiple calls to acquire are ignored.
  */
 
-SharedWakelock::SharedWakelock(const QDBusConnection &connection)
-    : m_wakelock(new Wakelock(connection))
+SharedWakelock::SharedWakelock(const QDBusConnection &connection, int holdOffMs)
+    : m_wakelock(new Wakelock(connection, holdOffMs))
 {
     connect(m_wakelock.data(), &Wakelock::enabledChanged,
             this, &SharedWakelock::enabledChanged);
@@ -31,7 +31,8 @@ class SharedWakelock : public QObject
     Q_OBJECT
     Q_PROPERTY(bool enabled READ enabled NOTIFY enabledChanged)
 public:
-    SharedWakelock(const QDBusConnection& connection = QDBusConnection::systemBus());
+    // Releases of the system wakelock are held back for holdOffMs, in case it gets acquired again. Acquires are immediate.
+    SharedWakelock(const QDBusConnection& connection = QDBusConnection::systemBus(), int holdOffMs = 500);
     virtual ~SharedWakelock();
 
     virtual bool enabled() const;
@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "touchresampler.h"
+
+// std
+#include <algorithm>
+
+namespace qtmir {
+
+namespace {
+
+// Samples closer than that are too noisy to tell the velocity from
+const ulong minPredictionIntervalMs = 2;
+
+// Samples further apart than that tell nothing about where the touch is going now
+const ulong maxPredictionIntervalMs = 20;
+
+// Mispredictions show up as jitter, so never guess further than that
+const ulong maxPredictionMs = 8;
+
+const int historySize = 2;
+
+const QTouchEvent::TouchPoint *findTouchPoint(const TouchResampler::Sample &sample, int id)
+{
+    for (const auto &touchPoint : sample.touchPoints) {
+        if (touchPoint.id() == id) {
+            return &touchPoint;
+        }
+    }
+    return nullptr;
+}
+
+// Moves the points of result to where they were at a + (b - a) * alpha
+void blend(TouchResampler::Sample &result,
+           const TouchResampler::Sample &a, const TouchResampler::Sample &b, qreal alpha)
+{
+    for (auto &touchPoint : result.touchPoints) {
+        const QTouchEvent::TouchPoint *pointA = findTouchPoint(a, touchPoint.id());
+        const QTouchEvent::TouchPoint *pointB = findTouchPoint(b, touchPoint.id());
+        if (!pointA || !pointB) {
+            continue;
+        }
+
+        const QPointF pos = pointA->pos() + (pointB->pos() - pointA->pos()) * alpha;
+        const QPointF offset = pos - touchPoint.pos();
+        touchPoint.setPos(pos);
+        touchPoint.setScenePos(touchPoint.scenePos() + offset);
+        touchPoint.setScreenPos(touchPoint.screenPos() + offset);
+    }
+}
+
+} // namespace
+
+bool TouchResampler::isMotion(const QList<QTouchEvent::TouchPoint> &touchPoints)
+{
+    for (const auto &touchPoint : touchPoints) {
+        if (touchPoint.state() != Qt::TouchPointMoved && touchPoint.state() != Qt::TouchPointStationary) {
+            return false;
+        }
+    }
+    return !touchPoints.isEmpty();
+}
+
+void TouchResampler::delivered(const Sample &sample)
+{
+    m_queued.clear();
+    remember(sample);
+}
+
+void TouchResampler::queue(const Sample &sample)
+{
+    m_queued.append(sample);
+}
+
+TouchResampler::Sample TouchResampler::takeLatest()
+{
+    Q_ASSERT(!m_queued.isEmpty());
+
+    Sample latest = m_queued.last();
+    for (const auto &sample : m_queued) {
+        latest.touchPointStates |= sample.touchPointStates;
+    }
+    delivered(latest);
+    return latest;
+}
+
+TouchResampler::Sample TouchResampler::resample(ulong frameTime)
+{
+    Q_ASSERT(!m_queued.isEmpty());
+
+    QVector<Sample> samples = m_history + m_queued;
+    const Sample &latest = m_queued.last();
+    Sample result = latest;
+
+    if (samples.count() < 2) {
+        // Nothing to go by
+    } else if (frameTime <= latest.timestamp) {
+        // Never go back past what the client already got
+        const int first = std::max(0, m_history.count() - 1);
+        frameTime = std::max(frameTime, samples[first].timestamp);
+
+        int i = samples.count() - 2;
+        while (i > first && samples[i].timestamp > frameTime) {
+            --i;
+        }
+        const Sample &a = samples[i];
+        const Sample &b = samples[i + 1];
+        if (b.timestamp > a.timestamp) {
+            blend(result, a, b, qreal(frameTime - a.timestamp) / (b.timestamp - a.timestamp));
+        } else {
+            blend(result, a, b, 1.0);
+        }
+    } else {
+        const Sample &previous = samples[samples.count() - 2];
+        const ulong interval = latest.timestamp - previous.timestamp;
+        if (latest.timestamp > previous.timestamp
+                && interval >= minPredictionIntervalMs && interval <= maxPredictionIntervalMs) {
+            const ulong prediction = std::min({frameTime - latest.timestamp, interval / 2, maxPredictionMs});
+            blend(result, previous, latest, 1.0 + qreal(prediction) / interval);
+        }
+    }
+
+    // Whatever moved since the last sample the client got is reported as such, even if the
+    // latest queued sample has it stationary.
+    result.touchPointStates = 0;
+    for (auto &touchPoint : result.touchPoints) {
+        if (touchPoint.state() == Qt::TouchPointStationary && !m_history.isEmpty()) {
+            const QTouchEvent::TouchPoint *last = findTouchPoint(m_history.last(), touchPoint.id());
+            if (!last || last->pos() != touchPoint.pos()) {
+                touchPoint.setState(Qt::TouchPointMoved);
+            }
+        }
+        result.touchPointStates |= touchPoint.state();
+    }
+
+    // Keep the actual samples, not the resampled one, as those are what the next prediction is based on
+    for (const auto &sample : m_queued) {
+        remember(sample);
+    }
+    m_queued.clear();
+
+    return result;
+}
+
+void TouchResampler::reset()
+{
+    m_history.clear();
+    m_queued.clear();
+}
+
+void TouchResampler::remember(const Sample &sample)
+{
+    m_history.append(sample);
+    while (m_history.count() > historySize) {
+        m_history.removeFirst();
+    }
+}
+
+} // namespace qtmir
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QTMIR_TOUCHRESAMPLER_H
+#define QTMIR_TOUCHRESAMPLER_H
+
+#include <QList>
+#include <QTouchEvent>
+#include <QVector>
+
+namespace qtmir {
+
+/*
+    Turns the touch motion received between two frames into a single sample positioned at the time
+    of the frame the client will draw next.
+
+    Touch positions are interpolated between the samples around the frame time or, if the frame
+    comes after the latest sample, extrapolated from the last two samples by a bounded amount.
+
+    Only motion goes through it. Presses and releases must be handed to the client as they come,
+    after whatever motion is still queued here (see takeLatest()).
+ */
+class TouchResampler
+{
+public:
+    struct Sample {
+        ulong timestamp{0};
+        Qt::KeyboardModifiers modifiers{Qt::NoModifier};
+        QList<QTouchEvent::TouchPoint> touchPoints;
+        Qt::TouchPointStates touchPointStates{0};
+    };
+
+    // Whether the given touch points are just motion, which can be queued
+    static bool isMotion(const QList<QTouchEvent::TouchPoint> &touchPoints);
+
+    // A sample that was handed straight to the client. It's where resampling starts from.
+    void delivered(const Sample &sample);
+
+    // Motion to be handed to the client on the next frame
+    void queue(const Sample &sample);
+
+    bool hasQueuedSamples() const { return !m_queued.isEmpty(); }
+
+    // Takes the latest queued sample as is, for when something else must reach the client right away
+    Sample takeLatest();
+
+    // Takes the queued samples, positioned at frameTime (in the same time base as the sample timestamps)
+    // The result keeps the timestamp of the latest queued sample, so that it can still be matched to the
+    // Mir event it came from.
+    Sample resample(ulong frameTime);
+
+    void reset();
+
+private:
+    void remember(const Sample &sample);
+
+    QVector<Sample> m_history; // last samples handed to the client, oldest first
+    QVector<Sample> m_queued; // oldest first
+};
+
+} // namespace qtmir
+
+#endif // QTMIR_TOUCHRESAMPLER_H
@@ -15,10 +15,10 @@
  */
 
 #include "clipboard.h"
+#include "logging.h"
 #include "shelluuid.h"
 
 #include <QDBusPendingCallWatcher>
-#include <QSignalBlocker>
 
 // content-hub
 #include <com/ubuntu/content/hub.h>
@@ -33,14 +33,9 @@ Clipboard::Clipboard()
     , m_mimeData(new QMimeData)
     , m_contentHub(Hub::Client::instance())
 {
-    connect(m_contentHub, &Hub::pasteboardChanged, this, [this]() {
-        if (m_clipboardState == Clipboard::SyncedClipboard) {
-            m_clipboardState = Clipboard::OutdatedClipboard;
-            requestMimeData();
-        }
-    });
+    connect(m_contentHub, &Hub::pasteboardChanged, this, &Clipboard::requestPaste);
 
-    requestMimeData();
+    requestPaste();
 }
 
 Clipboard::~Clipboard()
@@ -68,8 +63,10 @@ void Clipboard::setMimeData(QMimeData* mimeData, QClipboard::Mode mode)
         connect(watcher, &QDBusPendingCallWatcher::finished,
                 watcher, &QObject::deleteLater);
 
+        // A paste still on its way is the one we're replacing
+        dropPasteRequest();
+
         m_mimeData.reset(mimeData);
-        m_clipboardState = SyncedClipboard;
         emitChanged(QClipboard::Clipboard);
     }
 }
@@ -85,25 +82,35 @@ bool Clipboard::ownsMode(QClipboard::Mode mode) const
     return false;
 }
 
-void Clipboard::updateMimeData()
+void Clipboard::requestPaste()
 {
-    m_mimeData.reset(m_contentHub->latestPaste(ShellUuId::toString()));
-    m_clipboardState = SyncedClipboard;
-    emitChanged(QClipboard::Clipboard);
-}
+    dropPasteRequest();
 
-void Clipboard::requestMimeData()
-{
     QDBusPendingCall reply = m_contentHub->requestLatestPaste(ShellUuId::toString());
-    m_clipboardState = SyncingClipboard;
 
     m_pasteReply = new QDBusPendingCallWatcher(reply, this);
     connect(m_pasteReply, &QDBusPendingCallWatcher::finished,
-            this, [this]() {
-        m_mimeData.reset(m_contentHub->paste(*m_pasteReply));
-        m_clipboardState = SyncedClipboard;
+            this, [this](QDBusPendingCallWatcher *watcher) {
+        if (watcher != m_pasteReply) { // outdated
+            return;
+        }
         m_pasteReply->deleteLater();
         m_pasteReply = nullptr;
+
+        QMimeData *paste = m_contentHub->paste(*watcher);
+        if (!paste) {
+            qCWarning(QTMIR_CLIPBOARD) << "Clipboard: failed to get the latest paste";
+            return;
+        }
+        m_mimeData.reset(paste);
         emitChanged(QClipboard::Clipboard);
     });
 }
+
+void Clipboard::dropPasteRequest()
+{
+    if (m_pasteReply) {
+        m_pasteReply->deleteLater();
+        m_pasteReply = nullptr;
+    }
+}
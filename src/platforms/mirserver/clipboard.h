@@ -34,6 +34,15 @@ class QDBusPendingCallWatcher;
 
 namespace qtmir {
 
+/*
+   Clipboard backed by content-hub.
+
+   The latest paste is fetched as soon as the pasteboard changes, so that it's there by the time
+   anyone pastes. Nothing here ever waits for content-hub: until a fetch completes, the clipboard
+   holds what it held before, and it's announced as changed once the new paste is in.
+   A fetch still on its way when the pasteboard changes again, or when shell copies something
+   itself, is dropped.
+ */
 class Clipboard : public QObject, public QPlatformClipboard
 {
     Q_OBJECT
@@ -48,20 +57,14 @@ public:
     bool ownsMode(QClipboard::Mode mode) const override;
 
 private:
-    void updateMimeData();
-    void requestMimeData();
+    void requestPaste();
+    void dropPasteRequest();
 
     QScopedPointer<QMimeData> m_mimeData;
 
-    enum {
-        OutdatedClipboard, // Our mimeData is outdated, need to fetch latest from ContentHub
-        SyncingClipboard, // Our mimeData is outdated and we are waiting for ContentHub to reply with the latest paste
-        SyncedClipboard // Our mimeData is in sync with what ContentHub has
-    } m_clipboardState{OutdatedClipboard};
-
     com::ubuntu::content::Hub *m_contentHub;
 
-    QDBusPendingCallWatcher *m_pasteReply{nullptr};
+    QDBusPendingCallWatcher *m_pasteReply{nullptr}; // fetch of the latest paste on its way, if any
 };
 
 } // namespace qtmir
@@ -16,16 +16,31 @@
  */
 
 #include "cursor.h"
+#include "eventbuilder.h"
+#include "hardwarecursor.h"
 #include "logging.h"
 
 #include "mirsingleton.h"
 
+// Qt
+#include <QGuiApplication>
+#include <qpa/qplatformnativeinterface.h>
+
 // Unity API
 #include <unity/shell/application/MirMousePointerInterface.h>
 
 using namespace qtmir;
 
+namespace {
+
+const qreal motionUnitsPerPixel = 256;
+
+std::atomic<int> rawMotionRequests{0};
+
+} // anonymous namespace
+
 Cursor::Cursor()
+    : m_hardwareCursorEnabled(HardwareCursor::isEnabled())
 {
     m_shapeToCursorName[Qt::ArrowCursor] = QStringLiteral("left_ptr");
     m_shapeToCursorName[Qt::UpArrowCursor] = QStringLiteral("up_arrow");
@@ -51,10 +66,19 @@ Cursor::Cursor()
     m_shapeToCursorName[Qt::DragLinkCursor] = QStringLiteral("dnd-link");
 
     connect(Mir::instance(), &Mir::cursorNameChanged, this, &Cursor::setMirCursorName);
+
+    // The Mir input thread queues calls on this object, which must then run in the GUI thread
+    // no matter which thread created it
+    moveToThread(QCoreApplication::instance()->thread());
 }
 
 void Cursor::changeCursor(QCursor *windowCursor, QWindow * /*window*/)
 {
+    if (m_hardwareCursorEnabled) {
+        changeHardwareCursor(windowCursor);
+        return;
+    }
+
     if (m_mousePointer.isNull()) {
         return;
     }
@@ -83,68 +107,166 @@ void Cursor::changeCursor(QCursor *windowCursor, QWindow * /*window*/)
 void Cursor::setMirCursorName(const QString &mirCursorName)
 {
     m_mirCursorName = mirCursorName;
-    updateMousePointerCursorName();
+    if (m_hardwareCursorEnabled) {
+        updateHardwareCursorImage();
+    } else {
+        updateMousePointerCursorName();
+    }
 }
 
 void Cursor::setMousePointer(MirMousePointerInterface *mousePointer)
 {
-    QMutexLocker locker(&m_mutex);
-
     if (mousePointer && !m_mousePointer.isNull()) {
         qFatal("QPA mirserver: Only one MousePointer per screen is allowed!");
     }
 
+    if (m_mousePointer) {
+        disconnect(m_mousePointer, nullptr, this, nullptr);
+    }
+
     m_mousePointer = mousePointer;
+
+    if (mousePointer) {
+        connect(mousePointer, &QQuickItem::visibleChanged, this, &Cursor::updateMousePointerAcceptsEvents);
+        connect(mousePointer, &QObject::destroyed, this, &Cursor::updateMousePointerAcceptsEvents);
+    }
+
+    updateMousePointerAcceptsEvents();
     updateMousePointerCursorName();
 }
 
+void Cursor::updateMousePointerAcceptsEvents()
+{
+    m_mousePointerAcceptsEvents = m_mousePointer && m_mousePointer->isVisible();
+}
+
+void Cursor::requestRawMotion(bool requested)
+{
+    if (requested) {
+        ++rawMotionRequests;
+    } else {
+        --rawMotionRequests;
+    }
+}
+
 bool Cursor::handleMouseEvent(ulong timestamp, QPointF movement, Qt::MouseButtons buttons,
         Qt::KeyboardModifiers modifiers)
 {
-    QMutexLocker locker(&m_mutex);
+    // Mir moves the hardware cursor by itself, the event goes straight to the focused window
+    if (m_hardwareCursorEnabled || !m_mousePointerAcceptsEvents) {
+        return false;
+    }
+
+    if (buttons != m_lastButtons || rawMotionRequests > 0) {
+        // Never merged. The motion accumulated so far goes along, so that it doesn't get delivered after this event
+        m_lastButtons = buttons;
+        postMouseEvent(timestamp, movement + takeAccumulatedMotion(), buttons, modifiers);
+        return true;
+    }
+
+    m_accumulatedX += qRound64(movement.x() * motionUnitsPerPixel);
+    m_accumulatedY += qRound64(movement.y() * motionUnitsPerPixel);
+    m_accumulatedTimestamp = timestamp;
+    m_accumulatedButtons = static_cast<int>(buttons);
+    m_accumulatedModifiers = static_cast<int>(modifiers);
+
+    // The GUI thread is busy syncing with the render thread once per frame, so in practice a single
+    // flush is done per frame with all the motion that came in meanwhile
+    if (!m_flushPending.exchange(true)) {
+        QMetaObject::invokeMethod(this, "flushMotion", Qt::QueuedConnection,
+            Q_ARG(quint32, m_motionGeneration.load()));
+    }
+
+    return true;
+}
 
-    if (!m_mousePointer || !m_mousePointer->isVisible()) {
+bool Cursor::handleWheelEvent(ulong timestamp, QPoint angleDelta, Qt::KeyboardModifiers modifiers)
+{
+    if (m_hardwareCursorEnabled || !m_mousePointerAcceptsEvents) {
         return false;
     }
 
+    const QPointF movement = takeAccumulatedMotion();
+    if (!movement.isNull()) {
+        postMouseEvent(timestamp, movement, m_lastButtons, modifiers);
+    }
+
     // Must not be called directly as we're most likely not in Qt's GUI (main) thread.
-    bool ok = QMetaObject::invokeMethod(m_mousePointer, "handleMouseEvent", Qt::AutoConnection,
+    bool ok = QMetaObject::invokeMethod(this, "deliverWheelEvent", Qt::QueuedConnection,
         Q_ARG(ulong, timestamp),
-        Q_ARG(QPointF, movement),
-        Q_ARG(Qt::MouseButtons, buttons),
+        Q_ARG(QPoint, angleDelta),
         Q_ARG(Qt::KeyboardModifiers, modifiers));
 
     if (!ok) {
-        qCWarning(QTMIR_MIR_INPUT) << "Failed to invoke MousePointer::handleMouseEvent";
+        qCWarning(QTMIR_MIR_INPUT) << "Failed to invoke Cursor::deliverWheelEvent";
     }
 
     return ok;
 }
 
-bool Cursor::handleWheelEvent(ulong timestamp, QPoint angleDelta, Qt::KeyboardModifiers modifiers)
+QPointF Cursor::takeAccumulatedMotion()
 {
-    QMutexLocker locker(&m_mutex);
-
-    if (!m_mousePointer || !m_mousePointer->isVisible()) {
-        return false;
-    }
+    ++m_motionGeneration;
+    m_flushPending = false;
+    return QPointF(m_accumulatedX.exchange(0), m_accumulatedY.exchange(0)) / motionUnitsPerPixel;
+}
 
+void Cursor::postMouseEvent(ulong timestamp, QPointF movement, Qt::MouseButtons buttons,
+        Qt::KeyboardModifiers modifiers)
+{
     // Must not be called directly as we're most likely not in Qt's GUI (main) thread.
-    bool ok = QMetaObject::invokeMethod(m_mousePointer, "handleWheelEvent", Qt::AutoConnection,
+    bool ok = QMetaObject::invokeMethod(this, "deliverMouseEvent", Qt::QueuedConnection,
         Q_ARG(ulong, timestamp),
-        Q_ARG(QPoint, angleDelta),
+        Q_ARG(QPointF, movement),
+        Q_ARG(Qt::MouseButtons, buttons),
         Q_ARG(Qt::KeyboardModifiers, modifiers));
 
     if (!ok) {
-        qCWarning(QTMIR_MIR_INPUT) << "Failed to invoke MousePointer::handleMouseEvent";
+        qCWarning(QTMIR_MIR_INPUT) << "Failed to invoke Cursor::deliverMouseEvent";
     }
+}
 
-    return ok;
+void Cursor::flushMotion(quint32 generation)
+{
+    if (generation != m_motionGeneration) {
+        // the input thread handed over this motion along with a later event already
+        return;
+    }
+    m_flushPending = false;
+
+    const QPointF movement = QPointF(m_accumulatedX.exchange(0), m_accumulatedY.exchange(0)) / motionUnitsPerPixel;
+    if (movement.isNull()) {
+        return;
+    }
+
+    deliverMouseEvent(m_accumulatedTimestamp, movement, Qt::MouseButtons(m_accumulatedButtons.load()),
+                      Qt::KeyboardModifiers(m_accumulatedModifiers.load()));
+}
+
+void Cursor::deliverMouseEvent(ulong timestamp, QPointF movement, Qt::MouseButtons buttons,
+        Qt::KeyboardModifiers modifiers)
+{
+    // Clients get Mir events rebuilt from the Qt ones. Make them carry the whole merged motion
+    // and not just the one of the latest Mir event.
+    if (timestamp != 0) {
+        EventBuilder::instance()->storeMergedMotion(timestamp, movement);
+    }
+
+    if (m_mousePointer) {
+        m_mousePointer->handleMouseEvent(timestamp, movement, buttons, modifiers);
+    }
+}
+
+void Cursor::deliverWheelEvent(ulong timestamp, QPoint angleDelta, Qt::KeyboardModifiers modifiers)
+{
+    if (m_mousePointer) {
+        m_mousePointer->handleWheelEvent(timestamp, angleDelta, modifiers);
+    }
 }
 
 void Cursor::setPos(const QPoint &pos)
 {
-    if (!m_mousePointer) {
+    if (!m_mousePointer || m_hardwareCursorEnabled) {
         QPlatformCursor::setPos(pos);
         return;
     }
@@ -160,7 +282,7 @@ void Cursor::setPos(const QPoint &pos)
 
 QPoint Cursor::pos() const
 {
-    if (m_mousePointer) {
+    if (m_mousePointer && !m_hardwareCursorEnabled) {
         return m_mousePointer->mapToItem(nullptr, QPointF(0, 0)).toPoint();
     } else {
         return QPlatformCursor::pos();
@@ -169,7 +291,7 @@ QPoint Cursor::pos() const
 
 void Cursor::updateMousePointerCursorName()
 {
-    if (!m_mousePointer) {
+    if (!m_mousePointer || m_hardwareCursorEnabled) {
         return;
     }
 
@@ -183,3 +305,74 @@ void Cursor::updateMousePointerCursorName()
         m_mousePointer->setCursorName(m_mirCursorName);
     }
 }
+
+void Cursor::changeHardwareCursor(QCursor *windowCursor)
+{
+    if (windowCursor && !windowCursor->pixmap().isNull()) {
+        m_qtCursorName.clear();
+        m_customCursorImage = std::make_shared<ImageCursor>(windowCursor->pixmap().toImage(), windowCursor->hotSpot());
+    } else {
+        m_customCursorImage.reset();
+        if (windowCursor) {
+            m_qtCursorName = m_shapeToCursorName.value(windowCursor->shape(), QStringLiteral("left_ptr"));
+        } else {
+            m_qtCursorName.clear();
+        }
+    }
+
+    updateHardwareCursorImage();
+}
+
+HardwareCursor *Cursor::hardwareCursor()
+{
+    // Mir makes its cursor as it starts, which may well be after this Cursor got created
+    if (!m_hardwareCursor) {
+        if (auto nativeInterface = QGuiApplication::platformNativeInterface()) {
+            m_hardwareCursor = static_cast<HardwareCursor*>(nativeInterface->nativeResourceForIntegration("HardwareCursor"));
+        }
+    }
+    return m_hardwareCursor;
+}
+
+void Cursor::updateHardwareCursorImage()
+{
+    HardwareCursor *cursor = hardwareCursor();
+    if (!cursor) {
+        // Not there yet. It will get the current image on the next change.
+        return;
+    }
+
+    if (!m_mirCursorName.isEmpty()) {
+        cursor->setImage(namedCursorImage(m_mirCursorName));
+    } else if (m_customCursorImage) {
+        cursor->setImage(m_customCursorImage);
+    } else if (m_qtCursorName.isEmpty()) {
+        cursor->setImage(namedCursorImage(QStringLiteral("left_ptr")));
+    } else {
+        cursor->setImage(namedCursorImage(m_qtCursorName));
+    }
+}
+
+std::shared_ptr<mir::graphics::CursorImage> Cursor::namedCursorImage(const QString &name)
+{
+    if (name == QLatin1String("blank")) {
+        return nullptr;
+    }
+
+    auto it = m_namedCursorImages.constFind(name);
+    if (it != m_namedCursorImages.constEnd()) {
+        return it.value();
+    }
+
+    const QByteArray themeName = qEnvironmentVariableIsSet("XCURSOR_THEME") ? qgetenv("XCURSOR_THEME") : QByteArrayLiteral("default");
+    const int size = qEnvironmentVariableIsSet("XCURSOR_SIZE") ? qEnvironmentVariableIntValue("XCURSOR_SIZE") : 24;
+
+    auto image = loadThemeCursorImage(name, themeName, size);
+    if (!image && name != QLatin1String("left_ptr")) {
+        qCWarning(QTMIR_MIR_INPUT) << "Cursor: no image for cursor" << name << "in theme" << themeName;
+        image = namedCursorImage(QStringLiteral("left_ptr"));
+    }
+
+    m_namedCursorImages.insert(name, image);
+    return image;
+}
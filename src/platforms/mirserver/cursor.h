@@ -18,14 +18,21 @@
 #ifndef QTMIR_CURSOR_H
 #define QTMIR_CURSOR_H
 
-#include <QMutex>
+#include <QHash>
 #include <QPointer>
 
+#include <atomic>
+#include <memory>
+
 // Unity API
 #include <unity/shell/application/MirPlatformCursor.h>
 
+namespace mir { namespace graphics { class CursorImage; } }
+
 namespace qtmir {
 
+class HardwareCursor;
+
 class Cursor : public MirPlatformCursor
 {
     Q_OBJECT
@@ -37,6 +44,10 @@ public:
             Qt::KeyboardModifiers modifiers);
     bool handleWheelEvent(ulong timestamp, QPoint angleDelta, Qt::KeyboardModifiers mods);
 
+    // Pointer motion is merged and handed over to the MousePointer once per frame, unless some client
+    // wants every single motion event (eg. a game that confines the pointer). Requests are counted.
+    static void requestRawMotion(bool requested);
+
     ////
     // MirPlatformCursor
 
@@ -53,11 +64,46 @@ public:
 
 private Q_SLOTS:
     void setMirCursorName(const QString &mirCursorName);
+    void updateMousePointerAcceptsEvents();
+
+    // Called from Qt's GUI thread, queued from the Mir input thread
+    void flushMotion(quint32 generation);
+    void deliverMouseEvent(ulong timestamp, QPointF movement, Qt::MouseButtons buttons,
+            Qt::KeyboardModifiers modifiers);
+    void deliverWheelEvent(ulong timestamp, QPoint angleDelta, Qt::KeyboardModifiers modifiers);
 
 private:
+    QPointF takeAccumulatedMotion();
+    void postMouseEvent(ulong timestamp, QPointF movement, Qt::MouseButtons buttons,
+            Qt::KeyboardModifiers modifiers);
     void updateMousePointerCursorName();
-    QMutex m_mutex;
+    HardwareCursor *hardwareCursor();
+    void changeHardwareCursor(QCursor *windowCursor);
+    void updateHardwareCursorImage();
+    std::shared_ptr<mir::graphics::CursorImage> namedCursorImage(const QString &name);
+
+    // When set, Mir draws the mouse pointer and the MousePointer item is left alone
+    const bool m_hardwareCursorEnabled;
+    HardwareCursor *m_hardwareCursor{nullptr}; // looked up on first use, see hardwareCursor()
+    QHash<QString, std::shared_ptr<mir::graphics::CursorImage>> m_namedCursorImages;
+    std::shared_ptr<mir::graphics::CursorImage> m_customCursorImage;
+
     QPointer<MirMousePointerInterface> m_mousePointer;
+    std::atomic<bool> m_mousePointerAcceptsEvents{false};
+
+    // Motion accumulated by the Mir input thread until the GUI thread collects it. In 1/256th of a pixel,
+    // so that it can be summed up with plain atomic integer operations.
+    std::atomic<qint64> m_accumulatedX{0};
+    std::atomic<qint64> m_accumulatedY{0};
+    std::atomic<ulong> m_accumulatedTimestamp{0};
+    std::atomic<int> m_accumulatedButtons{0};
+    std::atomic<int> m_accumulatedModifiers{0};
+    std::atomic<bool> m_flushPending{false};
+    // Bumped whenever the input thread hands over the accumulated motion by itself, which outdates
+    // any flush still queued
+    std::atomic<quint32> m_motionGeneration{0};
+    Qt::MouseButtons m_lastButtons{Qt::NoButton}; // Mir input thread only
+
     QMap<int,QString> m_shapeToCursorName;
     QString m_qtCursorName;
     QString m_mirCursorName;
@@ -0,0 +1,286 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "damagetracker.h"
+
+#include "logging.h"
+
+// Qt
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include <QQuickItem>
+#include <QQuickWindow>
+#include <QSGClipNode>
+#include <QSGGeometry>
+#include <QtQuick/private/qquickitem_p.h>
+#include <QtQuick/private/qquickwindow_p.h>
+#include <QtQuick/private/qsgrenderer_p.h>
+
+// EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#ifndef EGL_BUFFER_AGE_EXT
+#define EGL_BUFFER_AGE_EXT 0x313D
+#endif
+
+namespace qtmir {
+
+namespace {
+
+typedef EGLBoolean (*SetDamageRegion)(EGLDisplay, EGLSurface, EGLint *, EGLint);
+
+// Antialiased edges and such may spill a bit out of item bounds
+const int damageMargin = 2;
+
+// Beyond that, start over instead of keeping track of items long gone
+const int maxTrackedItems = 4096;
+
+bool hasEglExtension(EGLDisplay display, const char *name)
+{
+    const QByteArray extensions(eglQueryString(display, EGL_EXTENSIONS));
+    return extensions.split(' ').contains(name);
+}
+
+} // namespace
+
+DamageHistory::DamageHistory(int maxAge)
+    : m_maxAge(maxAge)
+{
+}
+
+void DamageHistory::setFrameSize(const QSize &size)
+{
+    if (size != m_frameSize) {
+        m_frameSize = size;
+        reset();
+    }
+}
+
+void DamageHistory::addDamage(const QRect &rect)
+{
+    m_current |= rect & QRect(QPoint(0, 0), m_frameSize);
+}
+
+void DamageHistory::addFullDamage()
+{
+    m_current = QRect(QPoint(0, 0), m_frameSize);
+}
+
+QRect DamageHistory::repaintRect(int bufferAge) const
+{
+    if (bufferAge <= 0 || bufferAge > m_maxAge || bufferAge - 1 > m_history.count()) {
+        return QRect(QPoint(0, 0), m_frameSize);
+    }
+
+    QRect rect = m_current;
+    for (int i = 0; i < bufferAge - 1; ++i) {
+        rect |= m_history.at(i);
+    }
+    return rect;
+}
+
+void DamageHistory::frameSwapped()
+{
+    m_history.prepend(m_current);
+    if (m_history.count() > m_maxAge - 1) {
+        m_history.resize(m_maxAge - 1);
+    }
+    m_current = QRect();
+}
+
+void DamageHistory::reset()
+{
+    m_history.clear();
+    addFullDamage();
+}
+
+DamageTracker::DamageTracker(QQuickWindow *window)
+    : m_window(window)
+{
+    // The color buffer gets cleared here instead, just where it's going to be redrawn
+    m_window->setClearBeforeRendering(false);
+
+    connect(window, &QQuickWindow::beforeSynchronizing, this, &DamageTracker::collectDamage, Qt::DirectConnection);
+    connect(window, &QQuickWindow::afterSynchronizing, this, &DamageTracker::installClipNode, Qt::DirectConnection);
+    connect(window, &QQuickWindow::beforeRendering, this, &DamageTracker::beginFrame, Qt::DirectConnection);
+    connect(window, &QQuickWindow::afterRendering, this, &DamageTracker::endFrame, Qt::DirectConnection);
+    connect(window, &QQuickWindow::sceneGraphInvalidated, this, &DamageTracker::releaseNodes, Qt::DirectConnection);
+}
+
+DamageTracker::~DamageTracker()
+{
+    m_window->setClearBeforeRendering(true);
+}
+
+void DamageTracker::frameSwapped(bool presented)
+{
+    if (presented) {
+        m_history.frameSwapped();
+    } else {
+        m_history.reset();
+    }
+}
+
+void DamageTracker::collectDamage()
+{
+    m_history.setFrameSize(m_window->size() * m_window->effectiveDevicePixelRatio());
+
+    if (m_itemRects.isEmpty() || m_itemRects.count() > maxTrackedItems) {
+        // Start over from the whole scene
+        m_itemRects.clear();
+        damageItem(m_window->contentItem());
+        m_history.addFullDamage();
+        return;
+    }
+
+    auto windowPrivate = QQuickWindowPrivate::get(m_window);
+    for (QQuickItem *item = windowPrivate->dirtyItemList; item; item = QQuickItemPrivate::get(item)->nextDirtyItem) {
+        damageItem(item);
+    }
+}
+
+// Damages the area the item subtree covered last time and the area it covers now, and records the latter
+void DamageTracker::damageItem(QQuickItem *item)
+{
+    const QRect oldRect = m_itemRects.value(item);
+    const QRect newRect = recordSubtree(item, m_window->effectiveDevicePixelRatio());
+    m_history.addDamage(oldRect | newRect);
+
+    // So that they still cover the whole subtree if they change later on
+    for (QQuickItem *ancestor = item->parentItem(); ancestor; ancestor = ancestor->parentItem()) {
+        QRect &ancestorRect = m_itemRects[ancestor];
+        if (ancestorRect.contains(newRect)) {
+            break;
+        }
+        ancestorRect |= newRect;
+    }
+}
+
+QRect DamageTracker::recordSubtree(QQuickItem *item, qreal devicePixelRatio)
+{
+    QRect rect;
+    if (item->isVisible()) {
+        const QRectF sceneRect = item->mapRectToScene(QRectF(0, 0, item->width(), item->height()));
+        if (!sceneRect.isEmpty()) {
+            rect = QRectF(sceneRect.topLeft() * devicePixelRatio, sceneRect.size() * devicePixelRatio).toAlignedRect()
+                    .adjusted(-damageMargin, -damageMargin, damageMargin, damageMargin);
+        }
+        for (QQuickItem *child : item->childItems()) {
+            rect |= recordSubtree(child, devicePixelRatio);
+        }
+    }
+    m_itemRects[item] = rect;
+    return rect;
+}
+
+void DamageTracker::installClipNode()
+{
+    auto windowPrivate = QQuickWindowPrivate::get(m_window);
+    QSGNode *rootNode = windowPrivate->renderer ? windowPrivate->renderer->rootNode() : nullptr;
+    if (!rootNode || rootNode == m_rootNode) {
+        return;
+    }
+
+    // Everything gets drawn through a clip node covering just what has to be repainted
+    m_rootNode = rootNode;
+    m_clipNode = new QSGClipNode;
+    m_clipGeometry = new QSGGeometry(QSGGeometry::defaultAttributes_Point2D(), 4);
+    m_clipNode->setGeometry(m_clipGeometry);
+    m_clipNode->setFlag(QSGNode::OwnsGeometry);
+    m_clipNode->setIsRectangular(true);
+    m_clipRect = QRect();
+
+    while (QSGNode *child = m_rootNode->firstChild()) {
+        m_rootNode->removeChildNode(child);
+        m_clipNode->appendChildNode(child);
+    }
+    m_rootNode->appendChildNode(m_clipNode);
+
+    qCDebug(QTMIR_SCREENS) << "DamageTracker: clipping the scene of" << m_window;
+}
+
+void DamageTracker::beginFrame()
+{
+    EGLDisplay display = eglGetCurrentDisplay();
+    EGLSurface surface = eglGetCurrentSurface(EGL_DRAW);
+
+    if (!m_eglChecked && display != EGL_NO_DISPLAY) {
+        m_eglChecked = true;
+        const bool hasPartialUpdate = hasEglExtension(display, "EGL_KHR_partial_update");
+        m_hasBufferAge = hasPartialUpdate || hasEglExtension(display, "EGL_EXT_buffer_age");
+        if (hasPartialUpdate) {
+            m_setDamageRegion = reinterpret_cast<void*>(eglGetProcAddress("eglSetDamageRegionKHR"));
+        }
+        qCDebug(QTMIR_SCREENS) << "DamageTracker: EGL buffer age"
+                               << (m_hasBufferAge ? "supported" : "not supported, every frame gets redrawn in full");
+    }
+
+    EGLint bufferAge = 0;
+    if (m_hasBufferAge && surface != EGL_NO_SURFACE) {
+        eglQuerySurface(display, surface, EGL_BUFFER_AGE_EXT, &bufferAge);
+    }
+
+    const QRect fullRect(QPoint(0, 0), m_history.frameSize());
+    const QRect repaintRect = m_history.repaintRect(bufferAge);
+
+    // GL has its origin at the bottom left
+    const QRect glRect(repaintRect.x(), fullRect.height() - repaintRect.y() - repaintRect.height(),
+                       repaintRect.width(), repaintRect.height());
+
+    if (m_setDamageRegion && !repaintRect.isEmpty()) {
+        EGLint rect[4] = {glRect.x(), glRect.y(), glRect.width(), glRect.height()};
+        reinterpret_cast<SetDamageRegion>(m_setDamageRegion)(display, surface, rect, 1);
+    }
+
+    if (m_clipNode && repaintRect != m_clipRect) {
+        m_clipRect = repaintRect;
+        const qreal ratio = m_window->effectiveDevicePixelRatio();
+        const QRectF sceneRect(QPointF(repaintRect.topLeft()) / ratio, QSizeF(repaintRect.size()) / ratio);
+        m_clipNode->setClipRect(sceneRect);
+        QSGGeometry::updateRectGeometry(m_clipGeometry, sceneRect);
+        m_clipNode->markDirty(QSGNode::DirtyGeometry);
+    }
+
+    auto gl = QOpenGLContext::currentContext()->functions();
+    if (repaintRect != fullRect) {
+        gl->glEnable(GL_SCISSOR_TEST);
+        gl->glScissor(glRect.x(), glRect.y(), glRect.width(), glRect.height());
+        m_scissoring = true;
+    }
+    const QColor color = m_window->color();
+    gl->glClearColor(color.redF(), color.greenF(), color.blueF(), color.alphaF());
+    gl->glClear(GL_COLOR_BUFFER_BIT);
+}
+
+void DamageTracker::endFrame()
+{
+    if (m_scissoring) {
+        QOpenGLContext::currentContext()->functions()->glDisable(GL_SCISSOR_TEST);
+        m_scissoring = false;
+    }
+}
+
+void DamageTracker::releaseNodes()
+{
+    // They went away with the rest of the scene graph
+    m_rootNode = nullptr;
+    m_clipNode = nullptr;
+    m_clipGeometry = nullptr;
+    m_history.reset();
+}
+
+} // namespace qtmir
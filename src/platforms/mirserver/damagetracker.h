@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QTMIR_DAMAGETRACKER_H
+#define QTMIR_DAMAGETRACKER_H
+
+#include <QHash>
+#include <QObject>
+#include <QRect>
+#include <QVector>
+
+class QQuickItem;
+class QQuickWindow;
+class QSGClipNode;
+class QSGGeometry;
+class QSGNode;
+
+namespace qtmir {
+
+/*
+    Damaged area of the frame being rendered and of the few frames before it
+ */
+class DamageHistory
+{
+public:
+    explicit DamageHistory(int maxAge = 4);
+
+    // A new size damages everything
+    void setFrameSize(const QSize &size);
+    QSize frameSize() const { return m_frameSize; }
+
+    // Damage of the frame being rendered
+    void addDamage(const QRect &rect);
+    void addFullDamage();
+    QRect currentDamage() const { return m_current; }
+
+    /*
+        What has to be repainted on a back buffer holding the frame from bufferAge frames ago,
+        as given by EGL_EXT_buffer_age: the current damage plus that of the frames in between.
+        It's the whole frame if the age is 0 (unknown contents) or older than the history.
+     */
+    QRect repaintRect(int bufferAge) const;
+
+    // The frame being rendered was presented. A new one begins.
+    void frameSwapped();
+
+    // The contents of the back buffers can't be relied on anymore
+    void reset();
+
+private:
+    const int m_maxAge;
+    QSize m_frameSize;
+    QRect m_current;
+    QVector<QRect> m_history; // most recent first, no longer than m_maxAge - 1
+};
+
+/*
+    Partial updates of a QQuickWindow, enabled with QTMIR_PARTIAL_UPDATES=1
+
+    The damage of each frame is the area covered, before and after the change, by the items that
+    got changed since the previous frame, MirSurfaceItems getting a new client frame included.
+    With EGL_EXT_buffer_age (or EGL_KHR_partial_update), only the area damaged since the back buffer
+    was last presented gets redrawn: the whole scene gets clipped to it.
+
+    Without buffer age the back buffer contents are unknown, so every frame gets redrawn in full.
+
+    Items animated in the render thread (Animator types) don't show up as changed, so it shouldn't
+    be used with a shell relying on them.
+ */
+class DamageTracker : public QObject
+{
+    Q_OBJECT
+public:
+    explicit DamageTracker(QQuickWindow *window);
+    ~DamageTracker();
+
+    // Called after the window swapped buffers. presented is false if the frame wasn't shown (eg. on scanout).
+    void frameSwapped(bool presented);
+
+private:
+    // All called from the render thread
+    void collectDamage(); // GUI thread blocked
+    void installClipNode(); // GUI thread blocked
+    void beginFrame();
+    void endFrame();
+    void releaseNodes();
+
+    void damageItem(QQuickItem *item);
+    QRect recordSubtree(QQuickItem *item, qreal devicePixelRatio);
+
+    QQuickWindow *const m_window;
+    DamageHistory m_history;
+
+    // Scene area covered by each item subtree, as of the last time it changed
+    QHash<const QQuickItem*, QRect> m_itemRects;
+
+    QSGNode *m_rootNode{nullptr};
+    QSGClipNode *m_clipNode{nullptr};
+    QSGGeometry *m_clipGeometry{nullptr};
+    QRect m_clipRect;
+    bool m_scissoring{false};
+
+    bool m_eglChecked{false};
+    bool m_hasBufferAge{false};
+    void *m_setDamageRegion{nullptr}; // eglSetDamageRegionKHR, if available
+};
+
+} // namespace qtmir
+
+#endif // QTMIR_DAMAGETRACKER_H
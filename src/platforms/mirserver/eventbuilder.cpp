@@ -105,10 +105,10 @@ EventBuilder::~EventBuilder()
     m_instance = nullptr;
 }
 
-void EventBuilder::store(const MirInputEvent *mirInputEvent, ulong qtTimestamp)
+void EventBuilder::store(const MirInputEvent *mirInputEvent, ulong qtTimestamp, bool deliveredToClient)
 {
     EventInfo &eventInfo = m_eventInfoVector[m_nextIndex];
-    eventInfo.store(mirInputEvent, qtTimestamp);
+    eventInfo.store(mirInputEvent, qtTimestamp, deliveredToClient);
 
     m_nextIndex = (m_nextIndex + 1) % m_eventInfoVector.size();
 
@@ -128,7 +128,19 @@ mir::EventUPtr EventBuilder::reconstructMirEvent(QHoverEvent *qtEvent)
     return makeMirEvent(qtEvent, qtEvent->pos().x(), qtEvent->pos().y(), 0 /*buttons*/);
 }
 
-mir::EventUPtr EventBuilder::makeMirEvent(QInputEvent *qtEvent, int x, int y, MirPointerButtons buttons)
+mir::EventUPtr EventBuilder::reconstructMirEvent(QMouseEvent *qtEvent, QPointF relativeMotion)
+{
+    auto buttons = getMirButtonsFromQt(qtEvent->buttons());
+    return makeMirEvent(qtEvent, qtEvent->x(), qtEvent->y(), buttons, &relativeMotion);
+}
+
+mir::EventUPtr EventBuilder::reconstructMirEvent(QHoverEvent *qtEvent, QPointF relativeMotion)
+{
+    return makeMirEvent(qtEvent, qtEvent->pos().x(), qtEvent->pos().y(), 0 /*buttons*/, &relativeMotion);
+}
+
+mir::EventUPtr EventBuilder::makeMirEvent(QInputEvent *qtEvent, int x, int y, MirPointerButtons buttons,
+                                          const QPointF *relativeMotion)
 {
     MirPointerAction action = mirPointerActionFromMouseEventType(qtEvent->type());
 
@@ -145,13 +157,22 @@ mir::EventUPtr EventBuilder::makeMirEvent(QInputEvent *qtEvent, int x, int y, Mi
     if (qtEvent->timestamp() != 0) {
         auto eventInfo = findInfo(qtEvent->timestamp());
         if (eventInfo) {
-            relativeX = eventInfo->relativeX;
-            relativeY = eventInfo->relativeY;
             deviceId = eventInfo->deviceId;
             cookie = eventInfo->cookie;
         } else {
             qCWarning(QTMIR_MIR_INPUT) << "EventBuilder::makeMirEvent didn't find EventInfo with timestamp" << qtEvent->timestamp();
         }
+
+        QPointF motion;
+        if (!relativeMotion && this->relativeMotion(qtEvent->timestamp(), &motion)) {
+            relativeX = motion.x();
+            relativeY = motion.y();
+        }
+    }
+
+    if (relativeMotion) {
+        relativeX = relativeMotion->x();
+        relativeY = relativeMotion->y();
     }
 
     return mir::events::make_event(deviceId, timestamp, cookie, modifiers, action,
@@ -283,9 +304,49 @@ EventBuilder::EventInfo *EventBuilder::findInfo(ulong qtTimestamp)
     return nullptr;
 }
 
-void EventBuilder::EventInfo::store(const MirInputEvent *iev, ulong qtTimestamp)
+EventBuilder::EventInfo *EventBuilder::findUniqueInfo(ulong qtTimestamp)
+{
+    EventInfo *found = nullptr;
+    for (int i = 0; i < m_count; ++i) {
+        if (m_eventInfoVector[i].qtTimestamp == qtTimestamp) {
+            if (found) {
+                return nullptr;
+            }
+            found = &m_eventInfoVector[i];
+        }
+    }
+    return found;
+}
+
+void EventBuilder::storeMergedMotion(ulong qtTimestamp, QPointF relativeMotion)
+{
+    const int count = sizeof(m_mergedMotions) / sizeof(m_mergedMotions[0]);
+    m_mergedMotions[m_nextMergedMotion] = MergedMotion{qtTimestamp, relativeMotion};
+    m_nextMergedMotion = (m_nextMergedMotion + 1) % count;
+}
+
+bool EventBuilder::relativeMotion(ulong qtTimestamp, QPointF *relativeMotion)
+{
+    for (const MergedMotion &merged : m_mergedMotions) {
+        if (merged.qtTimestamp != 0 && merged.qtTimestamp == qtTimestamp) {
+            *relativeMotion = merged.relativeMotion;
+            return true;
+        }
+    }
+
+    auto eventInfo = findInfo(qtTimestamp);
+    if (!eventInfo) {
+        return false;
+    }
+    *relativeMotion = QPointF(eventInfo->relativeX, eventInfo->relativeY);
+    return true;
+}
+
+void EventBuilder::EventInfo::store(const MirInputEvent *iev, ulong qtTimestamp, bool deliveredToClient)
 {
     this->qtTimestamp = qtTimestamp;
+    this->deliveredToClient = deliveredToClient;
+    dispatchTime = std::chrono::steady_clock::now().time_since_epoch();
     deviceId = mir_input_event_get_device_id(iev);
     if (mir_input_event_has_cookie(iev))
     {
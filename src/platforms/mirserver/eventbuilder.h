@@ -27,6 +27,8 @@
 
 #include <mir/events/event_builders.h>
 
+#include <chrono>
+
 class MirPointerEvent;
 
 namespace qtmir {
@@ -45,8 +47,10 @@ public:
     virtual ~EventBuilder();
 
     /* Stores information that cannot be carried by QInputEvents so that it can be fully
-       reconstructed later given the same qtTimestamp */
-    void store(const MirInputEvent *mirInputEvent, ulong qtTimestamp);
+       reconstructed later given the same qtTimestamp.
+       deliveredToClient tells that the event reached its client already, by-passing the shell,
+       so that the QInputEvent is just a copy for the shell to look at. */
+    void store(const MirInputEvent *mirInputEvent, ulong qtTimestamp, bool deliveredToClient = false);
 
     /*
         Builds a MirEvent version of the given QInputEvent using also extra data from the
@@ -57,6 +61,13 @@ public:
     mir::EventUPtr reconstructMirEvent(QMouseEvent *event);
     mir::EventUPtr reconstructMirEvent(QHoverEvent *qtEvent);
 
+    /*
+        Same as above, but with the given relative motion instead of the one of the MirPointerEvent
+        that caused it. For motion events merged together.
+     */
+    mir::EventUPtr reconstructMirEvent(QMouseEvent *event, QPointF relativeMotion);
+    mir::EventUPtr reconstructMirEvent(QHoverEvent *qtEvent, QPointF relativeMotion);
+
     /*
         Makes a MirEvent version of the given QInputEvent using also extra data from the
         MirInputEvent that caused it.
@@ -71,18 +82,37 @@ public:
                                 ulong qtTimestamp);
     class EventInfo {
     public:
-        void store(const MirInputEvent *mirInputEvent, ulong qtTimestamp);
+        void store(const MirInputEvent *mirInputEvent, ulong qtTimestamp, bool deliveredToClient);
         ulong qtTimestamp;
         MirInputDeviceId deviceId;
         std::vector<uint8_t> cookie;
         float relativeX{0};
         float relativeY{0};
+        bool deliveredToClient{false};
+        std::chrono::nanoseconds dispatchTime{0}; // steady clock time of the store() call
     };
 
     EventInfo *findInfo(ulong qtTimestamp);
 
+    // Like findInfo(), but gives nothing if more than one stored event has that qtTimestamp
+    EventInfo *findUniqueInfo(ulong qtTimestamp);
+
+    /*
+        Pointer motion merged by qtmir::Cursor goes along with the Qt event it hands over to the
+        MousePointer, whose timestamp is the one of the latest Mir event merged. This records that
+        the Qt event with the given timestamp carries the given relative motion instead of the one
+        of its Mir event.
+
+        Kept apart from the EventInfo ring buffer, which the Mir input thread writes to, so GUI thread only.
+     */
+    void storeMergedMotion(ulong qtTimestamp, QPointF relativeMotion);
+
+    // Relative motion carried by the pointer event with the given timestamp. False if not known.
+    bool relativeMotion(ulong qtTimestamp, QPointF *relativeMotion);
+
 private:
-    mir::EventUPtr makeMirEvent(QInputEvent *qtEvent, int x, int y, MirPointerButtons buttons);
+    mir::EventUPtr makeMirEvent(QInputEvent *qtEvent, int x, int y, MirPointerButtons buttons,
+                                const QPointF *relativeMotion = nullptr);
 
 
     /*
@@ -100,6 +130,13 @@ private:
     int m_nextIndex{0};
     int m_count{0};
 
+    struct MergedMotion {
+        ulong qtTimestamp{0};
+        QPointF relativeMotion;
+    };
+    MergedMotion m_mergedMotions[8]; // GUI thread only, most recent ones
+    int m_nextMergedMotion{0};
+
     static EventBuilder *m_instance;
 };
 
@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "framebufferpool.h"
+
+#include <QMutexLocker>
+#include <QOpenGLFramebufferObject>
+
+namespace qtmir {
+
+FramebufferPool::FramebufferPool(qint64 budgetBytes)
+    : FramebufferPool(budgetBytes,
+                      [](const QSize &size) { return new QOpenGLFramebufferObject(size); },
+                      [](QOpenGLFramebufferObject *buffer) { delete buffer; })
+{
+}
+
+FramebufferPool::FramebufferPool(qint64 budgetBytes, const CreateFunction &create, const DestroyFunction &destroy)
+    : m_budgetBytes(budgetBytes)
+    , m_create(create)
+    , m_destroy(destroy)
+{
+}
+
+FramebufferPool::~FramebufferPool()
+{
+    // Buffers still in use belong to their surfaces now. The context is going away along with its pool, and
+    // QOpenGLFramebufferObject defers freeing its GL objects when it isn't current.
+    for (const Entry &entry : m_free) {
+        m_destroy(entry.buffer);
+    }
+}
+
+QOpenGLFramebufferObject *FramebufferPool::acquire(const QSize &size)
+{
+    QMutexLocker lock(&m_mutex);
+
+    for (int i = m_free.count() - 1; i >= 0; --i) {
+        if (m_free[i].size == size) {
+            const Entry entry = m_free.takeAt(i);
+            m_used.append(entry);
+            evictOverBudget();
+            return entry.buffer;
+        }
+    }
+
+    Entry entry{m_create(size), size};
+    m_used.append(entry);
+    m_allocatedBytes += bytesFor(size);
+
+    evictOverBudget();
+
+    return entry.buffer;
+}
+
+void FramebufferPool::release(QOpenGLFramebufferObject *buffer)
+{
+    QMutexLocker lock(&m_mutex);
+
+    for (int i = 0; i < m_used.count(); ++i) {
+        if (m_used[i].buffer == buffer) {
+            m_free.append(m_used.takeAt(i));
+            return;
+        }
+    }
+
+    qWarning("FramebufferPool::release - buffer didn't come from this pool");
+}
+
+void FramebufferPool::trim()
+{
+    QMutexLocker lock(&m_mutex);
+    evictOverBudget();
+}
+
+bool FramebufferPool::fits(QOpenGLFramebufferObject *buffer, const QSize &size) const
+{
+    QMutexLocker lock(&m_mutex);
+
+    for (const Entry &entry : m_used) {
+        if (entry.buffer == buffer) {
+            return entry.size == size;
+        }
+    }
+    return false;
+}
+
+qint64 FramebufferPool::bytesFor(const QSize &size)
+{
+    return qint64(size.width()) * size.height() * 4; // RGBA8, no attachments
+}
+
+qint64 FramebufferPool::allocatedBytes() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_allocatedBytes;
+}
+
+int FramebufferPool::freeCount() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_free.count();
+}
+
+void FramebufferPool::evictOverBudget()
+{
+    while (m_allocatedBytes > m_budgetBytes && !m_free.isEmpty()) {
+        const Entry entry = m_free.takeFirst();
+        m_allocatedBytes -= bytesFor(entry.size);
+        m_destroy(entry.buffer);
+    }
+}
+
+} // namespace qtmir
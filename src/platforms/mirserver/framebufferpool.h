@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QTMIR_FRAMEBUFFERPOOL_H
+#define QTMIR_FRAMEBUFFERPOOL_H
+
+#include <QList>
+#include <QMutex>
+#include <QSize>
+
+#include <functional>
+
+class QOpenGLFramebufferObject;
+
+namespace qtmir {
+
+/*
+    Keeps the framebuffer objects offscreen surfaces render into around for reuse, instead of
+    allocating a new one for each short-lived offscreen surface.
+
+    Buffers are allocated at the exact size asked for and only handed out again for that size. Released
+    buffers are kept until the buffers the pool has handed out or kept go over its memory budget, at which
+    point trim() deletes the least recently released ones. Buffers in use are never taken away.
+
+    FBOs can't be shared between GL contexts, so there is one pool per context. Buffers only get created
+    or deleted with that context current: surfaces may release their buffers from any thread, but the
+    deleting waits for the next acquire() or trim().
+ */
+class FramebufferPool
+{
+public:
+    using CreateFunction = std::function<QOpenGLFramebufferObject*(const QSize &)>;
+    using DestroyFunction = std::function<void(QOpenGLFramebufferObject*)>;
+
+    explicit FramebufferPool(qint64 budgetBytes);
+    FramebufferPool(qint64 budgetBytes, const CreateFunction &create, const DestroyFunction &destroy);
+    ~FramebufferPool();
+
+    // A buffer of the given size. Give it back with release() when done with it.
+    // Only with the pool's context current, as it may create and delete buffers.
+    QOpenGLFramebufferObject *acquire(const QSize &size);
+    // From any thread, with any context current
+    void release(QOpenGLFramebufferObject *buffer);
+
+    // Deletes the least recently released buffers while over budget. Only with the pool's context current.
+    void trim();
+
+    // Whether buffer, handed out by acquire(), is what acquire() would give for a surface of that size
+    bool fits(QOpenGLFramebufferObject *buffer, const QSize &size) const;
+
+    static qint64 bytesFor(const QSize &size);
+
+    qint64 allocatedBytes() const;
+    int freeCount() const;
+
+private:
+    struct Entry {
+        QOpenGLFramebufferObject *buffer;
+        QSize size;
+    };
+
+    void evictOverBudget(); // with m_mutex locked
+
+    const qint64 m_budgetBytes;
+    const CreateFunction m_create;
+    const DestroyFunction m_destroy;
+
+    mutable QMutex m_mutex;
+    QList<Entry> m_used;
+    QList<Entry> m_free; // least recently released first
+    qint64 m_allocatedBytes{0};
+};
+
+} // namespace qtmir
+
+#endif // QTMIR_FRAMEBUFFERPOOL_H
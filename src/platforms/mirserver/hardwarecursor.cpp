@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "hardwarecursor.h"
+
+// Xcursor. Kept out of cursor.cpp as X11 headers define a Cursor type of their own.
+#include <X11/Xcursor/Xcursor.h>
+
+namespace mg = mir::graphics;
+
+bool qtmir::HardwareCursor::isEnabled()
+{
+    return qgetenv("QTMIR_HARDWARE_CURSOR") == "1";
+}
+
+qtmir::HardwareCursorWrapper::HardwareCursorWrapper(std::shared_ptr<mg::Cursor> const& wrapped)
+    : m_wrapped(wrapped)
+{
+    m_wrapped->hide();
+}
+
+void qtmir::HardwareCursorWrapper::show()
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_visible = true;
+    apply();
+}
+
+void qtmir::HardwareCursorWrapper::show(mg::CursorImage const&)
+{
+    show();
+}
+
+void qtmir::HardwareCursorWrapper::hide()
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_visible = false;
+    apply();
+}
+
+void qtmir::HardwareCursorWrapper::move_to(mir::geometry::Point position)
+{
+    m_wrapped->move_to(position);
+}
+
+void qtmir::HardwareCursorWrapper::setImage(std::shared_ptr<mg::CursorImage> const& image)
+{
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_image = image;
+    apply();
+}
+
+void qtmir::HardwareCursorWrapper::apply()
+{
+    if (m_visible && m_image) {
+        m_wrapped->show(*m_image);
+    } else {
+        m_wrapped->hide();
+    }
+}
+
+std::shared_ptr<mir::graphics::CursorImage> qtmir::loadThemeCursorImage(const QString &name, const QByteArray &themeName,
+                                                                        int size)
+{
+    XcursorImage *xcursorImage = XcursorLibraryLoadImage(name.toLatin1().constData(), themeName.constData(), size);
+    if (!xcursorImage) {
+        return nullptr;
+    }
+
+    // ImageCursor must not keep pointing to the Xcursor pixels
+    const QImage pixels(reinterpret_cast<const uchar*>(xcursorImage->pixels), xcursorImage->width,
+                        xcursorImage->height, QImage::Format_ARGB32_Premultiplied);
+    auto image = std::make_shared<ImageCursor>(pixels.copy(), QPoint(xcursorImage->xhot, xcursorImage->yhot));
+
+    XcursorImageDestroy(xcursorImage);
+    return image;
+}
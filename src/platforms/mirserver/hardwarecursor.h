@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QTMIR_HARDWARECURSOR_H
+#define QTMIR_HARDWARECURSOR_H
+
+#include <mir/geometry/displacement.h>
+#include <mir/geometry/size.h>
+#include <mir/graphics/cursor.h>
+#include <mir/graphics/cursor_image.h>
+
+#include <QImage>
+
+#include <memory>
+#include <mutex>
+
+namespace qtmir {
+
+/*
+    Mir's cursor, when the shell lets Mir draw the mouse pointer (usually on a hardware cursor plane)
+    instead of drawing it as a QML item.
+
+    Mir moves it on its own as the pointer moves. It's up to qtmir::Cursor to tell which image to show,
+    as the images Mir knows about are just NamedCursors.
+*/
+class HardwareCursor
+{
+public:
+    virtual ~HardwareCursor() = default;
+
+    // Whether the shell asked for it, with QTMIR_HARDWARE_CURSOR=1
+    static bool isEnabled();
+
+    // A null image hides the cursor
+    virtual void setImage(std::shared_ptr<mir::graphics::CursorImage> const& image) = 0;
+};
+
+/*
+    Wraps Mir's cursor. Mir only ever shows NamedCursors (see MirCursorImages), which have no pixels.
+    So Mir just tells whether there should be a cursor at all, while the image comes from setImage().
+*/
+class HardwareCursorWrapper : public mir::graphics::Cursor, public HardwareCursor
+{
+public:
+    HardwareCursorWrapper(std::shared_ptr<mir::graphics::Cursor> const& wrapped);
+
+    // mir::graphics::Cursor, called from Mir threads
+    void show() override;
+    void show(mir::graphics::CursorImage const&) override;
+    void hide() override;
+    void move_to(mir::geometry::Point position) override;
+
+    // HardwareCursor
+    void setImage(std::shared_ptr<mir::graphics::CursorImage> const& image) override;
+
+private:
+    void apply();
+
+    std::shared_ptr<mir::graphics::Cursor> const m_wrapped;
+    std::mutex m_mutex;
+    bool m_visible{false};
+    std::shared_ptr<mir::graphics::CursorImage> m_image;
+};
+
+/*
+    A CursorImage holding actual pixels
+*/
+class ImageCursor : public mir::graphics::CursorImage
+{
+public:
+    ImageCursor(const QImage &image, const QPoint &hotspot)
+        : m_image(image.convertToFormat(QImage::Format_ARGB32_Premultiplied))
+        , m_hotspot(hotspot) {}
+
+    const void *as_argb_8888() const override { return m_image.constBits(); }
+    mir::geometry::Size size() const override { return {m_image.width(), m_image.height()}; }
+    mir::geometry::Displacement hotspot() const override { return {m_hotspot.x(), m_hotspot.y()}; }
+
+private:
+    const QImage m_image;
+    const QPoint m_hotspot;
+};
+
+// Loads a cursor from an Xcursor theme. Returns null if the theme has no such cursor.
+std::shared_ptr<mir::graphics::CursorImage> loadThemeCursorImage(const QString &name, const QByteArray &themeName, int size);
+
+} // namespace qtmir
+
+#endif // QTMIR_HARDWARECURSOR_H
@@ -21,6 +21,7 @@
 #include <QTimer>
 
 #include "inputdeviceobserver.h"
+#include "keymapcache.h"
 #include "mirsingleton.h"
 #include "logging.h"
 
@@ -36,6 +37,11 @@ MirInputDeviceObserver::MirInputDeviceObserver(QObject *parent):
     connect(Mir::instance(), &Mir::currentKeymapChanged, this, &MirInputDeviceObserver::setKeymap, Qt::DirectConnection);
 }
 
+MirInputDeviceObserver::~MirInputDeviceObserver()
+{
+    KeymapCache::instance()->cancel(this);
+}
+
 void MirInputDeviceObserver::setKeymap(const QString &keymap)
 {
     QMutexLocker locker(&m_mutex); // lock so that Qt and Mir don't apply the keymap at the same time
@@ -43,7 +49,12 @@ void MirInputDeviceObserver::setKeymap(const QString &keymap)
     if (keymap != m_keymap) {
         qCDebug(QTMIR_MIR_KEYMAP) << "SET KEYMAP" << keymap;
         m_keymap = keymap;
-        applyKeymap();
+
+        // Mir compiles the keymap again for each device, so don't do it from the GUI thread
+        KeymapCache::instance()->apply(this, KeymapNames::fromLayoutString(keymap), [this](const KeymapNames &) {
+            QMutexLocker locker(&m_mutex);
+            applyKeymap();
+        });
     }
 }
 
@@ -56,35 +67,41 @@ void MirInputDeviceObserver::applyKeymap()
 
 void MirInputDeviceObserver::applyKeymap(const std::shared_ptr<mi::Device> &device)
 {
-    if (!m_keymap.isEmpty()) {
-        const QStringList stringList = m_keymap.split('+', QString::SkipEmptyParts);
-
-        const QString &layout = stringList.at(0);
-        QString variant;
-
-        if (stringList.count() > 1) {
-            variant = stringList.at(1);
-        }
-
-        qCDebug(QTMIR_MIR_KEYMAP) << "Applying keymap" <<  layout << variant << "on" << device->id() << QString::fromStdString(device->name());
-        MirKeyboardConfig oldConfig;
-        mi::Keymap keymap;
-        if (device->keyboard_configuration().is_set()) { // preserve the model and options
-            oldConfig = device->keyboard_configuration().value();
-            keymap.model = oldConfig.device_keymap().model;
-            keymap.options = oldConfig.device_keymap().options;
-        }
-        keymap.layout = layout.toStdString();
-        keymap.variant = variant.toStdString();
-
-        try
-        {
-            device->apply_keyboard_configuration(std::move(keymap));
-            qCDebug(QTMIR_MIR_KEYMAP) << "Keymap applied";
-        }
-        catch(std::exception const& e)
-        {
-            qCWarning(QTMIR_MIR_KEYMAP) << "Keymap could not be applied:" << e.what();
-        }
+    const KeymapNames names = KeymapNames::fromLayoutString(m_keymap);
+    if (names.layout.empty()) {
+        return;
+    }
+
+    MirKeyboardConfig oldConfig;
+    mi::Keymap keymap;
+    if (device->keyboard_configuration().is_set()) { // preserve the model and options
+        oldConfig = device->keyboard_configuration().value();
+        keymap.model = oldConfig.device_keymap().model;
+        keymap.options = oldConfig.device_keymap().options;
+    }
+    keymap.layout = names.layout;
+    keymap.variant = names.variant;
+
+    if (device->keyboard_configuration().is_set()
+            && oldConfig.device_keymap().layout == keymap.layout
+            && oldConfig.device_keymap().variant == keymap.variant) {
+        qCDebug(QTMIR_MIR_KEYMAP) << "Keymap already applied on" << device->id();
+        return;
+    }
+
+    if (!KeymapCache::instance()->compile({keymap.model, keymap.layout, keymap.variant, keymap.options})) {
+        qCWarning(QTMIR_MIR_KEYMAP) << "Keymap" << m_keymap << "does not compile for" << device->id();
+        return;
+    }
+
+    qCDebug(QTMIR_MIR_KEYMAP) << "Applying keymap" << m_keymap << "on" << device->id() << QString::fromStdString(device->name());
+    try
+    {
+        device->apply_keyboard_configuration(std::move(keymap));
+        qCDebug(QTMIR_MIR_KEYMAP) << "Keymap applied";
+    }
+    catch(std::exception const& e)
+    {
+        qCWarning(QTMIR_MIR_KEYMAP) << "Keymap could not be applied:" << e.what();
     }
 }
@@ -31,7 +31,7 @@ class MirInputDeviceObserver: public QObject
     Q_OBJECT
 public:
     MirInputDeviceObserver(QObject * parent = nullptr);
-    ~MirInputDeviceObserver() = default;
+    ~MirInputDeviceObserver();
 
 private Q_SLOTS:
     void setKeymap(const QString &keymap);
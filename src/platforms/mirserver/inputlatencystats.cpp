@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "inputlatencystats.h"
+
+#include <QMutexLocker>
+
+// std
+#include <algorithm>
+
+using namespace std::chrono;
+
+namespace qtmir {
+
+namespace {
+
+// Surfaces come and go, so don't let the delivery histograms pile up forever
+const int maxDeliveryHistograms = 64;
+
+const char otherSurfaces[] = "(other)";
+
+QVariantMap toVariantMap(const InputLatencyStats::Histogram &histogram)
+{
+    QVariantList buckets;
+    for (quint64 bucket : histogram.buckets) {
+        buckets.append(bucket);
+    }
+
+    QVariantMap map;
+    map[QStringLiteral("count")] = histogram.count;
+    map[QStringLiteral("meanUs")] = histogram.count > 0 ? qint64(histogram.total.count() / histogram.count) : 0;
+    map[QStringLiteral("p50Us")] = qint64(histogram.percentile(50).count());
+    map[QStringLiteral("p99Us")] = qint64(histogram.percentile(99).count());
+    map[QStringLiteral("maxUs")] = qint64(histogram.max.count());
+    map[QStringLiteral("buckets")] = buckets;
+    return map;
+}
+
+} // namespace
+
+void InputLatencyStats::Histogram::add(microseconds latency)
+{
+    latency = std::max(latency, microseconds(0));
+
+    int bucket = 0;
+    for (auto us = latency.count(); us > 1 && bucket < bucketCount - 1; us >>= 1) {
+        ++bucket;
+    }
+
+    ++buckets[bucket];
+    ++count;
+    total += latency;
+    max = std::max(max, latency);
+}
+
+microseconds InputLatencyStats::Histogram::percentile(int percent) const
+{
+    if (count == 0) {
+        return microseconds(0);
+    }
+
+    const quint64 rank = (count * percent + 99) / 100;
+    quint64 seen = 0;
+    for (int i = 0; i < bucketCount; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return std::min(microseconds(qint64(2) << i), max);
+        }
+    }
+    return max;
+}
+
+InputLatencyStats *InputLatencyStats::instance()
+{
+    static InputLatencyStats stats;
+    return &stats;
+}
+
+void InputLatencyStats::recordDispatch(MirInputDeviceId deviceId, nanoseconds latency)
+{
+    QMutexLocker locker(&m_mutex);
+    m_dispatch[deviceId].add(duration_cast<microseconds>(latency));
+}
+
+void InputLatencyStats::recordDelivery(MirInputDeviceId deviceId, const QString &surface, nanoseconds latency)
+{
+    QMutexLocker locker(&m_mutex);
+    auto key = qMakePair(deviceId, surface);
+    if (!m_delivery.contains(key) && m_delivery.count() >= maxDeliveryHistograms) {
+        key.second = QLatin1String(otherSurfaces);
+    }
+    m_delivery[key].add(duration_cast<microseconds>(latency));
+}
+
+QVariantList InputLatencyStats::snapshot() const
+{
+    QMutexLocker locker(&m_mutex);
+    QVariantList result;
+
+    for (auto it = m_dispatch.constBegin(); it != m_dispatch.constEnd(); ++it) {
+        QVariantMap map = toVariantMap(it.value());
+        map[QStringLiteral("stage")] = QStringLiteral("dispatch");
+        map[QStringLiteral("deviceId")] = qint64(it.key());
+        map[QStringLiteral("surface")] = QString();
+        result.append(map);
+    }
+
+    for (auto it = m_delivery.constBegin(); it != m_delivery.constEnd(); ++it) {
+        QVariantMap map = toVariantMap(it.value());
+        map[QStringLiteral("stage")] = QStringLiteral("delivery");
+        map[QStringLiteral("deviceId")] = qint64(it.key().first);
+        map[QStringLiteral("surface")] = it.key().second;
+        result.append(map);
+    }
+
+    return result;
+}
+
+QString InputLatencyStats::report() const
+{
+    QString report = QStringLiteral("stage\tdevice\tsurface\tcount\tmean(us)\tp50(us)\tp99(us)\tmax(us)\n");
+    for (const QVariant &entry : snapshot()) {
+        const QVariantMap map = entry.toMap();
+        report += QStringLiteral("%1\t%2\t%3\t%4\t%5\t%6\t%7\t%8\n")
+                .arg(map[QStringLiteral("stage")].toString())
+                .arg(map[QStringLiteral("deviceId")].toLongLong())
+                .arg(map[QStringLiteral("surface")].toString())
+                .arg(map[QStringLiteral("count")].toULongLong())
+                .arg(map[QStringLiteral("meanUs")].toLongLong())
+                .arg(map[QStringLiteral("p50Us")].toLongLong())
+                .arg(map[QStringLiteral("p99Us")].toLongLong())
+                .arg(map[QStringLiteral("maxUs")].toLongLong());
+    }
+    return report;
+}
+
+void InputLatencyStats::reset()
+{
+    QMutexLocker locker(&m_mutex);
+    m_dispatch.clear();
+    m_delivery.clear();
+}
+
+} // namespace qtmir
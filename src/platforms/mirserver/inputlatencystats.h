@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QTMIR_INPUTLATENCYSTATS_H
+#define QTMIR_INPUTLATENCYSTATS_H
+
+#include <mir_toolkit/event.h>
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QPair>
+#include <QVariantList>
+
+#include <array>
+#include <chrono>
+
+namespace qtmir {
+
+/*
+    Histograms of the time input events take to go through the shell, kept per input device
+    and per target surface:
+     - dispatch: from the Mir event time until QtEventFeeder dispatches it to Qt
+     - delivery: from QtEventFeeder dispatching it until it's handed over to its client surface
+
+    Recording is cheap enough to be always on. It can be queried on D-Bus, at
+    /com/canonical/qtmir/InputLatency on the session bus.
+ */
+class InputLatencyStats : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "com.canonical.qtmir.InputLatency")
+public:
+    static InputLatencyStats *instance();
+
+    // Bucket i counts latencies in [2^i, 2^(i+1)) microseconds. The last one also counts anything longer.
+    static const int bucketCount = 20;
+
+    struct Histogram {
+        std::array<quint64, bucketCount> buckets{};
+        quint64 count{0};
+        std::chrono::microseconds total{0};
+        std::chrono::microseconds max{0};
+
+        void add(std::chrono::microseconds latency);
+        std::chrono::microseconds percentile(int percent) const; // upper bound of the bucket it falls in
+    };
+
+    // May be called from any thread
+    void recordDispatch(MirInputDeviceId deviceId, std::chrono::nanoseconds latency);
+    void recordDelivery(MirInputDeviceId deviceId, const QString &surface, std::chrono::nanoseconds latency);
+
+    /*
+        One QVariantMap per histogram, with the keys "stage" ("dispatch" or "delivery"), "deviceId",
+        "surface" (empty for the dispatch stage), "count", "meanUs", "p50Us", "p99Us", "maxUs" and
+        "buckets" (as in Histogram)
+     */
+    QVariantList snapshot() const;
+
+public Q_SLOTS:
+    // Human readable table with a line per histogram
+    Q_SCRIPTABLE QString report() const;
+
+    Q_SCRIPTABLE void reset();
+
+private:
+    InputLatencyStats() = default;
+
+    mutable QMutex m_mutex;
+    QHash<MirInputDeviceId, Histogram> m_dispatch;
+    QHash<QPair<MirInputDeviceId, QString>, Histogram> m_delivery;
+};
+
+} // namespace qtmir
+
+#endif // QTMIR_INPUTLATENCYSTATS_H
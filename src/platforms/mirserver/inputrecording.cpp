@@ -0,0 +1,250 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "inputrecording.h"
+
+#include "logging.h"
+#include "qteventfeeder.h"
+
+// mir
+#include <mir/events/event_builders.h>
+
+// std
+#include <chrono>
+#include <thread>
+
+// system
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace mev = mir::events;
+
+namespace qtmir {
+
+namespace {
+
+const quint32 fileMagic = 0x514d4952; // "QMIR"
+const quint16 fileVersion = 1;
+
+void setUpStream(QDataStream &stream)
+{
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+}
+
+mir::EventUPtr makeEvent(const InputReplayer::Record &record, std::chrono::nanoseconds time)
+{
+    const std::vector<uint8_t> cookie{};
+    const auto deviceId = MirInputDeviceId(record.deviceId);
+    const auto modifiers = MirInputEventModifiers(record.modifiers);
+
+    switch (record.type) {
+    case mir_input_event_type_key:
+        return mev::make_event(deviceId, time, cookie, MirKeyboardAction(record.action),
+                               record.keyCode, record.scanCode, modifiers);
+    case mir_input_event_type_touch: {
+        auto event = mev::make_event(deviceId, time, cookie, modifiers);
+        for (const auto &touch : record.touches) {
+            mev::add_touch(*event, touch.id, MirTouchAction(touch.action), MirTouchTooltype(touch.tooltype),
+                           touch.x, touch.y, touch.pressure, touch.touchMajor, touch.touchMinor, touch.size);
+        }
+        return event;
+    }
+    case mir_input_event_type_pointer:
+    default:
+        return mev::make_event(deviceId, time, cookie, modifiers, MirPointerAction(record.action),
+                               record.buttons, record.x, record.y, record.hscroll, record.vscroll,
+                               record.relativeX, record.relativeY);
+    }
+}
+
+} // namespace
+
+InputRecorder::InputRecorder(const QString &filePath)
+{
+    // The recording has every key typed, passwords included, so it's for the user's eyes only.
+    // Created with the right permissions straight away, as QFile would create it world readable first.
+    const int fd = ::open(QFile::encodeName(filePath).constData(),
+                          O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | O_NOFOLLOW, S_IRUSR | S_IWUSR);
+    if (fd < 0) {
+        qCWarning(QTMIR_MIR_INPUT) << "InputRecorder: failed to open" << filePath << "-" << strerror(errno);
+        return;
+    }
+    if (fchmod(fd, S_IRUSR | S_IWUSR) != 0) { // it might have existed already
+        qCWarning(QTMIR_MIR_INPUT) << "InputRecorder: failed to restrict the permissions of" << filePath << "-" << strerror(errno);
+        ::close(fd);
+        return;
+    }
+    if (!m_file.open(fd, QIODevice::WriteOnly, QFileDevice::AutoCloseHandle)) {
+        qCWarning(QTMIR_MIR_INPUT) << "InputRecorder: failed to open" << filePath << "-" << m_file.errorString();
+        ::close(fd);
+        return;
+    }
+
+    m_stream.setDevice(&m_file);
+    setUpStream(m_stream);
+    m_stream << fileMagic << fileVersion;
+
+    qCWarning(QTMIR_MIR_INPUT) << "InputRecorder: recording all input events, keystrokes included, into" << filePath;
+}
+
+InputRecorder::~InputRecorder()
+{
+    m_file.close();
+}
+
+void InputRecorder::record(MirInputEvent const* event)
+{
+    if (!m_file.isOpen()) {
+        return;
+    }
+
+    const auto type = mir_input_event_get_type(event);
+    m_stream << quint8(type)
+             << qint64(mir_input_event_get_event_time(event))
+             << qint64(mir_input_event_get_device_id(event));
+
+    switch (type) {
+    case mir_input_event_type_key: {
+        auto kev = mir_input_event_get_keyboard_event(event);
+        m_stream << quint32(mir_keyboard_event_modifiers(kev))
+                 << quint8(mir_keyboard_event_action(kev))
+                 << qint32(mir_keyboard_event_key_code(kev))
+                 << qint32(mir_keyboard_event_scan_code(kev));
+        break;
+    }
+    case mir_input_event_type_touch: {
+        auto tev = mir_input_event_get_touch_event(event);
+        const auto count = mir_touch_event_point_count(tev);
+        m_stream << quint32(mir_touch_event_modifiers(tev)) << quint8(count);
+        for (unsigned i = 0; i < count; ++i) {
+            m_stream << qint32(mir_touch_event_id(tev, i))
+                     << quint8(mir_touch_event_action(tev, i))
+                     << quint8(mir_touch_event_tooltype(tev, i))
+                     << mir_touch_event_axis_value(tev, i, mir_touch_axis_x)
+                     << mir_touch_event_axis_value(tev, i, mir_touch_axis_y)
+                     << mir_touch_event_axis_value(tev, i, mir_touch_axis_pressure)
+                     << mir_touch_event_axis_value(tev, i, mir_touch_axis_touch_major)
+                     << mir_touch_event_axis_value(tev, i, mir_touch_axis_touch_minor)
+                     << mir_touch_event_axis_value(tev, i, mir_touch_axis_size);
+        }
+        break;
+    }
+    case mir_input_event_type_pointer: {
+        auto pev = mir_input_event_get_pointer_event(event);
+        m_stream << quint32(mir_pointer_event_modifiers(pev))
+                 << quint8(mir_pointer_event_action(pev))
+                 << quint32(mir_pointer_event_buttons(pev))
+                 << mir_pointer_event_axis_value(pev, mir_pointer_axis_x)
+                 << mir_pointer_event_axis_value(pev, mir_pointer_axis_y)
+                 << mir_pointer_event_axis_value(pev, mir_pointer_axis_hscroll)
+                 << mir_pointer_event_axis_value(pev, mir_pointer_axis_vscroll)
+                 << mir_pointer_event_axis_value(pev, mir_pointer_axis_relative_x)
+                 << mir_pointer_event_axis_value(pev, mir_pointer_axis_relative_y);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+InputReplayer::InputReplayer(const QString &filePath)
+    : m_valid(false)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qCWarning(QTMIR_MIR_INPUT) << "InputReplayer: failed to open" << filePath << "-" << file.errorString();
+        return;
+    }
+
+    QDataStream stream(&file);
+    setUpStream(stream);
+
+    quint32 magic;
+    quint16 version;
+    stream >> magic >> version;
+    if (magic != fileMagic || version != fileVersion) {
+        qCWarning(QTMIR_MIR_INPUT) << "InputReplayer:" << filePath << "is not an input recording";
+        return;
+    }
+
+    while (!stream.atEnd()) {
+        Record record;
+        stream >> record.type >> record.time >> record.deviceId >> record.modifiers;
+
+        switch (record.type) {
+        case mir_input_event_type_key:
+            stream >> record.action >> record.keyCode >> record.scanCode;
+            break;
+        case mir_input_event_type_touch: {
+            quint8 count;
+            stream >> count;
+            record.touches.resize(count);
+            for (auto &touch : record.touches) {
+                stream >> touch.id >> touch.action >> touch.tooltype
+                       >> touch.x >> touch.y >> touch.pressure
+                       >> touch.touchMajor >> touch.touchMinor >> touch.size;
+            }
+            break;
+        }
+        case mir_input_event_type_pointer:
+            stream >> record.action >> record.buttons
+                   >> record.x >> record.y >> record.hscroll >> record.vscroll
+                   >> record.relativeX >> record.relativeY;
+            break;
+        default:
+            qCWarning(QTMIR_MIR_INPUT) << "InputReplayer: unknown event type" << record.type << "in" << filePath;
+            return;
+        }
+
+        if (stream.status() != QDataStream::Ok) {
+            // Most likely the recording process didn't get to flush its last event
+            qCWarning(QTMIR_MIR_INPUT) << "InputReplayer:" << filePath << "is truncated";
+            break;
+        }
+
+        m_records.append(record);
+    }
+
+    m_valid = true;
+}
+
+void InputReplayer::replay(QtEventFeeder *feeder, Speed speed) const
+{
+    if (m_records.isEmpty()) {
+        return;
+    }
+
+    using namespace std::chrono;
+    const auto start = steady_clock::now();
+    const nanoseconds firstTime(m_records.first().time);
+
+    for (const auto &record : m_records) {
+        const auto offset = nanoseconds(record.time) - firstTime;
+        if (speed == OriginalSpeed) {
+            std::this_thread::sleep_until(start + offset);
+        }
+
+        auto event = makeEvent(record, duration_cast<nanoseconds>(start.time_since_epoch()) + offset);
+        feeder->dispatch(*event);
+    }
+}
+
+} // namespace qtmir
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QTMIR_INPUTRECORDING_H
+#define QTMIR_INPUTRECORDING_H
+
+#include <mir_toolkit/event.h>
+
+#include <QDataStream>
+#include <QFile>
+#include <QVector>
+
+class QtEventFeeder;
+
+namespace qtmir {
+
+/*
+    Writes the input events given to QtEventFeeder to a compact binary file, so that a given input
+    load can be reproduced later on without the devices that generated it. See InputReplayer.
+
+    QtEventFeeder records into the file named by the QTMIR_INPUT_RECORDING environment variable, if set.
+    The file is readable by its owner only, as it holds everything the user typed.
+
+    Everything needed to rebuild the events is kept, apart from their cookies, which would not be
+    valid anymore on replay.
+ */
+class InputRecorder
+{
+public:
+    explicit InputRecorder(const QString &filePath);
+    ~InputRecorder();
+
+    bool isOpen() const { return m_file.isOpen(); }
+
+    void record(MirInputEvent const* event);
+
+private:
+    QFile m_file;
+    QDataStream m_stream;
+};
+
+/*
+    Feeds the events of a file written by InputRecorder to a QtEventFeeder
+ */
+class InputReplayer
+{
+public:
+    enum Speed {
+        OriginalSpeed, // keeps the intervals between events as recorded
+        MaximumSpeed // dispatches the events one after the other right away
+    };
+
+    explicit InputReplayer(const QString &filePath);
+
+    // Whether the recording could be read
+    bool isValid() const { return m_valid; }
+
+    int eventCount() const { return m_records.count(); }
+
+    // Event timestamps are moved to the time of the replay, keeping the intervals between them
+    void replay(QtEventFeeder *feeder, Speed speed) const;
+
+    struct TouchRecord {
+        qint32 id{0};
+        quint8 action{0};
+        quint8 tooltype{0};
+        float x{0}, y{0}, pressure{0}, touchMajor{0}, touchMinor{0}, size{0};
+    };
+
+    struct Record {
+        quint8 type{0}; // MirInputEventType
+        qint64 time{0}; // nanoseconds
+        qint64 deviceId{0};
+        quint32 modifiers{0};
+
+        // keyboard and pointer events
+        quint8 action{0};
+        // keyboard events
+        qint32 keyCode{0};
+        qint32 scanCode{0};
+        // pointer events
+        quint32 buttons{0};
+        float x{0}, y{0}, hscroll{0}, vscroll{0}, relativeX{0}, relativeY{0};
+        // touch events
+        QVector<TouchRecord> touches;
+    };
+
+private:
+    QVector<Record> m_records;
+    bool m_valid;
+};
+
+} // namespace qtmir
+
+#endif // QTMIR_INPUTRECORDING_H
@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "keymapcache.h"
+
+#include "logging.h"
+
+#include <QMutexLocker>
+#include <QStringList>
+
+#include <xkbcommon/xkbcommon.h>
+
+namespace qtmir {
+
+namespace {
+
+const char *namesValue(const std::string &value)
+{
+    // empty means the system default
+    return value.empty() ? nullptr : value.c_str();
+}
+
+} // namespace
+
+KeymapNames KeymapNames::fromLayoutString(const QString &layoutPlusVariant)
+{
+    const QStringList stringList = layoutPlusVariant.split('+', QString::SkipEmptyParts);
+
+    KeymapNames names;
+    if (stringList.count() > 0) {
+        names.layout = stringList.at(0).toStdString();
+    }
+    if (stringList.count() > 1) {
+        names.variant = stringList.at(1).toStdString();
+    }
+    return names;
+}
+
+QString KeymapNames::toString() const
+{
+    return QStringLiteral("%1:%2:%3:%4").arg(QString::fromStdString(model), QString::fromStdString(layout),
+                                             QString::fromStdString(variant), QString::fromStdString(options));
+}
+
+/*
+   Lives in the KeymapCache thread
+ */
+class KeymapCacheWorker : public QObject
+{
+    Q_OBJECT
+public:
+    KeymapCacheWorker(KeymapCache *cache) : m_cache(cache) {}
+
+public Q_SLOTS:
+    void applyPending() { m_cache->applyPending(); }
+
+private:
+    KeymapCache *m_cache;
+};
+
+#include "keymapcache.moc"
+
+KeymapCache::KeymapCache()
+    : m_context(xkb_context_new(XKB_CONTEXT_NO_FLAGS), &xkb_context_unref)
+    , m_worker(new KeymapCacheWorker(this))
+{
+    if (!m_context) {
+        qCWarning(QTMIR_MIR_KEYMAP) << "KeymapCache: failed to create an XKB context, keymaps won't be checked";
+    }
+
+    m_thread.setObjectName(QStringLiteral("KeymapCache"));
+    m_worker->moveToThread(&m_thread);
+    connect(&m_thread, &QThread::finished, m_worker, &QObject::deleteLater);
+    m_thread.start();
+}
+
+KeymapCache::~KeymapCache()
+{
+    m_thread.quit();
+    m_thread.wait();
+}
+
+KeymapCache *KeymapCache::instance()
+{
+    static KeymapCache *instance;
+    if (!instance) {
+        instance = new KeymapCache;
+    }
+    return instance;
+}
+
+void KeymapCache::apply(const void *target, const KeymapNames &keymap, const ApplyFunction &applyFunction)
+{
+    QMutexLocker locker(&m_mutex);
+    m_pending[target] = Request{keymap, applyFunction};
+
+    if (!m_applyScheduled) {
+        m_applyScheduled = true;
+        QMetaObject::invokeMethod(m_worker, "applyPending", Qt::QueuedConnection);
+    }
+}
+
+void KeymapCache::cancel(const void *target)
+{
+    QMutexLocker locker(&m_mutex);
+    m_pending.remove(target);
+
+    // It might have been taken already and be getting applied right now
+    while (m_applyingTarget == target) {
+        m_applyDone.wait(&m_mutex);
+    }
+}
+
+void KeymapCache::applyPending()
+{
+    QMutexLocker locker(&m_mutex);
+
+    while (!m_pending.isEmpty()) {
+        auto it = m_pending.begin();
+        const Request request = it.value();
+        m_applyingTarget = it.key();
+        m_pending.erase(it);
+        locker.unlock();
+
+        if (compile(request.keymap)) {
+            try {
+                request.applyFunction(request.keymap);
+            } catch (const std::exception &e) {
+                qCWarning(QTMIR_MIR_KEYMAP) << "KeymapCache: keymap" << request.keymap.toString()
+                                            << "could not be applied:" << e.what();
+            }
+        } else {
+            qCWarning(QTMIR_MIR_KEYMAP) << "KeymapCache: keymap" << request.keymap.toString() << "does not compile";
+        }
+
+        locker.relock();
+        m_applyingTarget = nullptr;
+        m_applyDone.wakeAll();
+    }
+
+    m_applyScheduled = false;
+}
+
+bool KeymapCache::compile(const KeymapNames &keymap)
+{
+    if (keymap.layout.empty()) {
+        return false;
+    }
+
+    const QString key = keymap.toString();
+
+    QMutexLocker locker(&m_compileMutex);
+    auto it = m_compiled.constFind(key);
+    if (it != m_compiled.constEnd()) {
+        return it.value() != nullptr;
+    }
+
+    if (!m_context) {
+        return true; // leave it to Mir
+    }
+
+    xkb_rule_names names;
+    names.rules = nullptr;
+    names.model = namesValue(keymap.model);
+    names.layout = namesValue(keymap.layout);
+    names.variant = namesValue(keymap.variant);
+    names.options = namesValue(keymap.options);
+
+    std::shared_ptr<xkb_keymap> compiled;
+    if (auto xkbKeymap = xkb_keymap_new_from_names(m_context.get(), &names, XKB_KEYMAP_COMPILE_NO_FLAGS)) {
+        compiled.reset(xkbKeymap, &xkb_keymap_unref);
+    }
+    qCDebug(QTMIR_MIR_KEYMAP) << "KeymapCache: compiled" << key << (compiled ? "successfully" : "with errors");
+
+    m_compiled.insert(key, compiled);
+    return compiled != nullptr;
+}
+
+int KeymapCache::compiledCount() const
+{
+    QMutexLocker locker(&m_compileMutex);
+    return m_compiled.count();
+}
+
+} // namespace qtmir
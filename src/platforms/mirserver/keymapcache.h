@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QTMIR_KEYMAPCACHE_H
+#define QTMIR_KEYMAPCACHE_H
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QThread>
+#include <QWaitCondition>
+
+#include <functional>
+#include <memory>
+#include <string>
+
+struct xkb_context;
+struct xkb_keymap;
+
+namespace qtmir {
+
+struct KeymapNames
+{
+    // Takes keymaps as the shell names them: "layout" or "layout+variant"
+    static KeymapNames fromLayoutString(const QString &layoutPlusVariant);
+
+    bool operator==(const KeymapNames &other) const {
+        return model == other.model && layout == other.layout
+            && variant == other.variant && options == other.options;
+    }
+    bool operator!=(const KeymapNames &other) const { return !(*this == other); }
+
+    QString toString() const;
+
+    std::string model;
+    std::string layout;
+    std::string variant;
+    std::string options;
+};
+
+class KeymapCacheWorker;
+
+/*
+    Process-wide cache of compiled XKB keymaps, keyed by (model, layout, variant, options).
+
+    Mir takes keymaps by name and compiles them on each surface or device they are applied to,
+    from the thread applying them. So keymaps get applied through here instead, from a thread of
+    its own: the GUI thread just queues the request, a given keymap is compiled once to check it's
+    valid, keymaps that don't compile are never handed to Mir, and only the latest keymap requested
+    for a given target gets applied.
+ */
+class KeymapCache : public QObject
+{
+    Q_OBJECT
+public:
+    static KeymapCache *instance();
+    ~KeymapCache();
+
+    using ApplyFunction = std::function<void(const KeymapNames &)>;
+
+    /*
+        Calls applyFunction with the given keymap from the cache thread, once the keymap is known to compile.
+        A pending request for the same target is replaced, so applyFunction might never be called.
+        May be called from any thread.
+     */
+    void apply(const void *target, const KeymapNames &keymap, const ApplyFunction &applyFunction);
+
+    // Drops the pending request for the given target, waiting for it to finish if it's being applied right now
+    void cancel(const void *target);
+
+    // Compiles the keymap unless it's cached already. Returns whether it compiles. May be called from any thread.
+    bool compile(const KeymapNames &keymap);
+
+    int compiledCount() const;
+
+private:
+    KeymapCache();
+    void applyPending();
+
+    struct Request {
+        KeymapNames keymap;
+        ApplyFunction applyFunction;
+    };
+
+    QMutex m_mutex;
+    QHash<const void*, Request> m_pending;
+    bool m_applyScheduled{false};
+    const void *m_applyingTarget{nullptr};
+    QWaitCondition m_applyDone;
+
+    mutable QMutex m_compileMutex; // xkb_context can't be used from several threads at once
+    std::shared_ptr<xkb_context> m_context;
+    QHash<QString, std::shared_ptr<xkb_keymap>> m_compiled; // null if it failed to compile
+
+    QThread m_thread;
+    KeymapCacheWorker *m_worker;
+
+    friend class KeymapCacheWorker;
+};
+
+} // namespace qtmir
+
+#endif // QTMIR_KEYMAPCACHE_H
@@ -18,10 +18,12 @@
 
 #include <mir/graphics/buffer.h>
 #include <mir/renderer/gl/texture_source.h>
+#include <mir/renderer/sw/pixel_source.h>
 
 #include <stdexcept>
 
 using mir::renderer::gl::TextureSource;
+using mir::renderer::software::PixelSource;
 
 miral::GLBuffer::GLBuffer() = default;
 miral::GLBuffer::~GLBuffer() = default;
@@ -52,6 +54,16 @@ mir::geometry::Size miral::GLBuffer::size() const
     return wrapped->size();
 }
 
+MirPixelFormat miral::GLBuffer::pixel_format() const
+{
+    return wrapped->pixel_format();
+}
+
+std::shared_ptr<mir::graphics::Buffer> miral::GLBuffer::buffer() const
+{
+    return wrapped;
+}
+
 void miral::GLBuffer::reset()
 {
     wrapped.reset();
@@ -80,3 +92,14 @@ void miral::GLBuffer::secure_for_render()
         throw std::logic_error("Buffer does not support GL rendering");
     }
 }
+
+bool miral::GLBuffer::read_pixels(std::function<void(unsigned char const* pixels, int stride)> const& do_with_pixels)
+{
+    auto const pixel_source = wrapped ? dynamic_cast<PixelSource*>(wrapped->native_buffer_base()) : nullptr;
+    if (!pixel_source)
+        return false;
+
+    auto const stride = pixel_source->stride().as_int();
+    pixel_source->read([&](unsigned char const* pixels) { do_with_pixels(pixels, stride); });
+    return true;
+}
@@ -18,7 +18,9 @@
 #define MIRAL_GLBUFFER_H
 
 #include <mir/geometry/size.h>
+#include <mir_toolkit/common.h>
 
+#include <functional>
 #include <memory>
 
 namespace mir { namespace graphics { class Buffer; }}
@@ -35,12 +37,18 @@ public:
     operator bool() const;
     bool has_alpha_channel() const;
     mir::geometry::Size size() const;
+    MirPixelFormat pixel_format() const;
+    std::shared_ptr<mir::graphics::Buffer> buffer() const;
 
     void reset();
     void reset(std::shared_ptr<mir::graphics::Buffer> const& buffer);
     void bind_to_texture();
     void secure_for_render();
 
+    // Calls do_with_pixels with the buffer contents if the CPU can read them (eg. shm buffers),
+    // otherwise returns false
+    bool read_pixels(std::function<void(unsigned char const* pixels, int stride)> const& do_with_pixels);
+
 private:
     std::shared_ptr<mir::graphics::Buffer> wrapped;
 };
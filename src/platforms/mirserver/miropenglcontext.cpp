@@ -16,9 +16,11 @@
 
 #include "miropenglcontext.h"
 
+#include "framebufferpool.h"
 #include "offscreensurface.h"
 #include "mirglconfig.h"
 #include "screenwindow.h"
+#include "logging.h"
 
 #include <QDebug>
 
@@ -34,6 +36,13 @@
 #include <mir/renderer/gl/context.h>
 #include <mir/renderer/gl/context_source.h>
 
+namespace {
+
+// Enough for a few full screen offscreen surfaces to come and go without reallocating
+const qint64 framebufferPoolBudgetBytes = 32 * 1024 * 1024;
+
+} // namespace
+
 // Qt supports one GL context per screen, but also shared contexts.
 // The Mir "Display" generates a shared GL context for all DisplayBuffers
 // (i.e. individual display output buffers) to use as a common base context.
@@ -43,6 +52,7 @@ MirOpenGLContext::MirOpenGLContext(
     mir::graphics::GLConfig &gl_config,
     const QSurfaceFormat &format)
     : m_currentWindow(nullptr)
+    , m_framebufferPool(std::make_shared<qtmir::FramebufferPool>(framebufferPoolBudgetBytes))
 #ifdef QGL_DEBUG
       , m_logger(new QOpenGLDebugLogger(this))
 #endif
@@ -142,13 +152,40 @@ static bool needsFBOReadBackWorkaround()
     return needsWorkaround;
 }
 
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS_OES
+#define GL_NUM_PROGRAM_BINARY_FORMATS_OES 0x87FE
+#endif
+
+// Without program binary formats, Qt's shader disk cache stays empty and every start compiles all shaders
+static void logProgramBinarySupport()
+{
+    static bool logged = false;
+
+    if (Q_UNLIKELY(!logged)) {
+        GLint formatCount = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS_OES, &formatCount);
+        glGetError(); // GL_INVALID_ENUM where it isn't supported at all
+
+        if (formatCount > 0) {
+            qCDebug(QTMIR_SCREENS) << "MirOpenGLContext - driver supports" << formatCount << "program binary formats";
+        } else {
+            qCWarning(QTMIR_SCREENS) << "MirOpenGLContext - driver doesn't support program binaries, shaders can't be cached";
+        }
+        logged = true;
+    }
+}
+
 bool MirOpenGLContext::makeCurrent(QPlatformSurface *surface)
 {
     if (surface->surface()->surfaceClass() == QSurface::Offscreen) {
         auto offscreen = static_cast<OffscreenSurface *>(surface);
-        if (!offscreen->buffer()) {
-            auto buffer = new QOpenGLFramebufferObject(surface->surface()->size());
-            offscreen->setBuffer(buffer);
+        const QSize size = surface->surface()->size();
+        // Also swaps buffers when the surface got resized, or was last current with another context.
+        // Acquiring deletes what got released in the meantime, over budget, now that this context is current.
+        if (!offscreen->buffer() || !m_framebufferPool->fits(offscreen->buffer(), size)) {
+            offscreen->setBuffer(m_framebufferPool->acquire(size), m_framebufferPool);
+        } else {
+            m_framebufferPool->trim();
         }
         return offscreen->buffer()->bind();
     }
@@ -158,6 +195,7 @@ bool MirOpenGLContext::makeCurrent(QPlatformSurface *surface)
     if (Q_LIKELY(screenWindow)) {
         m_currentWindow = screenWindow;
         screenWindow->makeCurrent();
+        m_framebufferPool->trim(); // what offscreen surfaces released while this context wasn't current
 
 #ifdef QGL_DEBUG
         if (!m_logger->isLogging() && m_logger->initialize()) {
@@ -170,6 +208,8 @@ bool MirOpenGLContext::makeCurrent(QPlatformSurface *surface)
         if (!ctx_d->workaround_brokenFBOReadBack && needsFBOReadBackWorkaround())
             ctx_d->workaround_brokenFBOReadBack = true;
 
+        logProgramBinarySupport();
+
         return true;
     }
 
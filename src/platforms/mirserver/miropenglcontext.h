@@ -19,11 +19,14 @@
 
 #include <qpa/qplatformopenglcontext.h>
 
+#include <memory>
+
 #ifdef QGL_DEBUG
 #include <QOpenGLDebugLogger>
 #endif
 
 class ScreenWindow;
+namespace qtmir { class FramebufferPool; }
 namespace mir { namespace graphics { class Display; class GLConfig; }}
 
 class MirOpenGLContext : public QObject, public QPlatformOpenGLContext
@@ -53,6 +56,7 @@ public:
 private:
     QSurfaceFormat m_format;
     ScreenWindow *m_currentWindow;
+    std::shared_ptr<qtmir::FramebufferPool> m_framebufferPool; // for offscreen surfaces
 #ifdef QGL_DEBUG
     QOpenGLDebugLogger *m_logger;
 #endif
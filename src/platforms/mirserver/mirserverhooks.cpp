@@ -18,6 +18,7 @@
 
 #include "mirserverhooks.h"
 
+#include "hardwarecursor.h"
 #include "mircursorimages.h"
 #include "promptsessionlistener.h"
 #include "screenscontroller.h"
@@ -85,11 +86,14 @@ struct qtmir::MirServerHooks::Self
     std::weak_ptr<mir::shell::DisplayConfigurationController> m_mirDisplayConfigurationController;
     std::weak_ptr<mir::scene::PromptSessionManager> m_mirPromptSessionManager;
     std::weak_ptr<mir::input::InputDeviceHub> m_inputDeviceHub;
+    std::weak_ptr<qtmir::HardwareCursorWrapper> m_hardwareCursor;
+    bool m_hardwareCursorEnabled{false};
 };
 
 qtmir::MirServerHooks::MirServerHooks() :
     self{std::make_shared<Self>()}
 {
+    self->m_hardwareCursorEnabled = HardwareCursor::isEnabled();
 }
 
 void qtmir::MirServerHooks::operator()(mir::Server& server)
@@ -97,8 +101,15 @@ void qtmir::MirServerHooks::operator()(mir::Server& server)
     server.override_the_cursor_images([]
         { return std::make_shared<qtmir::MirCursorImages>(); });
 
-    server.wrap_cursor([&](std::shared_ptr<mg::Cursor> const& wrapped)
-        { return std::make_shared<HiddenCursorWrapper>(wrapped); });
+    server.wrap_cursor([this](std::shared_ptr<mg::Cursor> const& wrapped) -> std::shared_ptr<mg::Cursor>
+        {
+            if (self->m_hardwareCursorEnabled) {
+                auto const result = std::make_shared<qtmir::HardwareCursorWrapper>(wrapped);
+                self->m_hardwareCursor = result;
+                return result;
+            }
+            return std::make_shared<HiddenCursorWrapper>(wrapped);
+        });
 
     server.override_the_prompt_session_listener([this]
         {
@@ -148,6 +159,15 @@ std::shared_ptr<mir::input::InputDeviceHub> qtmir::MirServerHooks::theInputDevic
     throw std::logic_error("No input device hub available. Server not running?");
 }
 
+qtmir::HardwareCursor *qtmir::MirServerHooks::hardwareCursor() const
+{
+    // Not an error if Mir hasn't made its cursor yet, or has none. Callers just look it up again later.
+    if (auto result = self->m_hardwareCursor.lock())
+        return result.get();
+
+    return nullptr;
+}
+
 QSharedPointer<ScreensController> qtmir::MirServerHooks::createScreensController(QSharedPointer<ScreensModel> const &screensModel) const
 {
     return QSharedPointer<ScreensController>(
@@ -33,6 +33,8 @@ class ScreensModel;
 
 namespace qtmir
 {
+class HardwareCursor;
+
 class MirServerHooks
 {
 public:
@@ -45,6 +47,9 @@ public:
     std::shared_ptr<mir::graphics::Display> theMirDisplay() const;
     std::shared_ptr<mir::input::InputDeviceHub> theInputDeviceHub() const;
 
+    // Null unless Mir is asked to draw the mouse pointer (QTMIR_HARDWARE_CURSOR=1) and has made its cursor
+    HardwareCursor *hardwareCursor() const;
+
     QSharedPointer<ScreensController> createScreensController(QSharedPointer<ScreensModel> const &screensModel) const;
     void createInputDeviceObserver();
 
@@ -28,6 +28,7 @@
 #include <qpa/qplatforminputcontextfactory_p.h>
 #include <qpa/qwindowsysteminterface.h>
 
+#include <QDBusConnection>
 #include <QGuiApplication>
 #include <QStringList>
 #include <QDebug>
@@ -38,6 +39,7 @@
 
 // local
 #include "clipboard.h"
+#include "inputlatencystats.h"
 #include "miropenglcontext.h"
 #include "nativeinterface.h"
 #include "offscreensurface.h"
@@ -46,10 +48,16 @@
 #include "screensmodel.h"
 #include "screenwindow.h"
 #include "services.h"
+#include "shadercache.h"
+#include "threadscheduling.h"
 #include "ubuntutheme.h"
 #include "logging.h"
 
 namespace mg = mir::graphics;
+
+namespace {
+const char inputLatencyPath[] = "/com/canonical/qtmir/InputLatency";
+}
 using qtmir::Clipboard;
 
 MirServerIntegration::MirServerIntegration()
@@ -70,6 +78,9 @@ MirServerIntegration::MirServerIntegration()
         }
     }
 
+    // Read the thread scheduling configuration now, not from whichever thread first asks for it
+    qtmir::ThreadScheduling::instance();
+
     // If Mir shuts down, quit.
     QObject::connect(m_mirServer.data(), &QMirServer::stopped,
                      QCoreApplication::instance(), &QCoreApplication::quit);
@@ -82,6 +93,7 @@ MirServerIntegration::MirServerIntegration()
 
 MirServerIntegration::~MirServerIntegration()
 {
+    QDBusConnection::sessionBus().unregisterObject(QLatin1String(inputLatencyPath));
     delete m_nativeInterface;
 }
 
@@ -157,6 +169,9 @@ void MirServerIntegration::handleScreenRemoved(QPlatformScreen *screen)
 
 void MirServerIntegration::initialize()
 {
+    // Gets the program binaries off the disk while Mir brings up the displays, ready for the first frame
+    qtmir::ShaderCache::prefetch();
+
     // Creates instance of and start the Mir server in a separate thread
     m_mirServer->start();
 
@@ -176,6 +191,10 @@ void MirServerIntegration::initialize()
     }
 
     m_nativeInterface = new NativeInterface(m_mirServer.data());
+
+    QDBusConnection::sessionBus().registerObject(QLatin1String(inputLatencyPath),
+                                                 qtmir::InputLatencyStats::instance(),
+                                                 QDBusConnection::ExportScriptableSlots);
 }
 
 QPlatformAccessibility *MirServerIntegration::accessibility() const
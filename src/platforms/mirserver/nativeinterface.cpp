@@ -110,6 +110,8 @@ void NativeInterface::setWindowProperty(QPlatformWindow */*window*/, const QStri
             qWarning().nospace() << "NativeInterface::setWindowProperty("
                 << name << "," << value << ") - value is not a QRect";
         }
+    } else if (name == QStringLiteral("directInputAllowed")) {
+        windowController->setDirectInputAllowed(value.toBool());
     }
 }
 
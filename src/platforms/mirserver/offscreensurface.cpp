@@ -15,6 +15,7 @@
  */
 
 #include "offscreensurface.h"
+#include "framebufferpool.h"
 
 //Qt
 #include <QOffscreenSurface>
@@ -27,6 +28,11 @@ OffscreenSurface::OffscreenSurface(QOffscreenSurface *offscreenSurface)
 {
 }
 
+OffscreenSurface::~OffscreenSurface()
+{
+    releaseBuffer();
+}
+
 QSurfaceFormat OffscreenSurface::format() const
 {
     return m_format;
@@ -45,7 +51,24 @@ QOpenGLFramebufferObject* OffscreenSurface::buffer() const
     return m_buffer;
 }
 
-void OffscreenSurface::setBuffer(QOpenGLFramebufferObject *buffer)
+void OffscreenSurface::setBuffer(QOpenGLFramebufferObject *buffer,
+                                 const std::shared_ptr<qtmir::FramebufferPool> &pool)
 {
+    releaseBuffer();
     m_buffer = buffer;
+    m_bufferPool = pool;
+}
+
+void OffscreenSurface::releaseBuffer()
+{
+    if (!m_buffer) {
+        return;
+    }
+
+    if (auto pool = m_bufferPool.lock()) {
+        pool->release(m_buffer);
+    } else {
+        delete m_buffer; // its GL context is gone already
+    }
+    m_buffer = nullptr;
 }
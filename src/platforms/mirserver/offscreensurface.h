@@ -21,22 +21,31 @@
 #include <QSurfaceFormat>
 #include <QSharedPointer>
 
+#include <memory>
+
 class MirServer;
 class QOpenGLFramebufferObject;
 
+namespace qtmir { class FramebufferPool; }
+
 class OffscreenSurface : public QPlatformOffscreenSurface
 {
 public:
     OffscreenSurface(QOffscreenSurface *offscreenSurface);
+    ~OffscreenSurface();
 
     QSurfaceFormat format() const override;
     bool isValid() const override;
 
     QOpenGLFramebufferObject* buffer() const;
-    void setBuffer(QOpenGLFramebufferObject *buffer);
+    // The previous buffer goes back to the pool it came from
+    void setBuffer(QOpenGLFramebufferObject *buffer, const std::shared_ptr<qtmir::FramebufferPool> &pool);
 
 private:
+    void releaseBuffer();
+
     QOpenGLFramebufferObject *m_buffer;
+    std::weak_ptr<qtmir::FramebufferPool> m_bufferPool;
     QSurfaceFormat m_format;
 };
 
@@ -22,6 +22,7 @@
 #include "windowmanagementpolicy.h"
 #include "promptsessionmanager.h"
 #include "setqtcompositor.h"
+#include "threadscheduling.h"
 
 // prototyping for later incorporation in miral
 #include <miral/persist_display_config.h>
@@ -90,7 +91,6 @@ PromptSessionListener *QMirServerPrivate::promptSessionListener() const
 
 void QMirServerPrivate::run(const std::function<void()> &startCallback)
 {
-
     miral::AddInitCallback addInitCallback{[&, this]
     {
         qCDebug(QTMIR_MIR_MESSAGES) << "MirServer created";
@@ -113,6 +113,12 @@ void QMirServerPrivate::run(const std::function<void()> &startCallback)
         }
     });
 
+    runner.add_start_callback([]
+    {
+        // Once Mir has created its threads, so that they don't inherit it
+        qtmir::ThreadScheduling::instance()->applyToCurrentThread(qtmir::ThreadScheduling::ServerThread);
+    });
+
     runner.add_start_callback([&]
     {
         screensModel->update();
@@ -75,6 +75,9 @@ public:
     qtmir::WindowControllerInterface *windowController() const
         { return &m_windowController; }
 
+    qtmir::HardwareCursor *hardwareCursor() const
+        { return m_mirServerHooks.hardwareCursor(); }
+
 private:
     qtmir::SetSessionAuthorizer m_sessionAuthorizer;
     qtmir::OpenGLContextFactory m_openGLContextFactory;
@@ -17,21 +17,29 @@
 #include "qteventfeeder.h"
 #include "cursor.h"
 #include "eventbuilder.h"
+#include "inputlatencystats.h"
+#include "inputrecording.h"
 #include "logging.h"
 #include "timestamp.h"
 #include "tracepoints.h" // generated from tracepoints.tp
 #include "screen.h"
+#include "threadscheduling.h"
 
 #include <qpa/qplatforminputcontext.h>
 #include <qpa/qplatformintegration.h>
 #include <qpa/qwindowsysteminterface_p.h>
 #include <QGuiApplication>
+#include <QMutex>
+#include <QScreen>
 #include <QTextCodec>
+#include <QVector>
 #include <QDebug>
 
 #include <xkbcommon/xkbcommon.h>
 #include <xkbcommon/xkbcommon-keysyms.h>
 
+#include <atomic>
+
 // common dir
 #include <debughelpers.h>
 
@@ -384,6 +392,29 @@ public:
         // because we're using QMetaObject::invoke with arguments of those types
         qRegisterMetaType<Qt::KeyboardModifiers>("Qt::KeyboardModifiers");
         qRegisterMetaType<Qt::MouseButtons>("Qt::MouseButtons");
+
+        // Screens come, go and move in the GUI thread, which keeps the Mir input thread's view of them up to date
+        QMutexLocker lock(&m_screensMutex);
+        m_screenConnections << QObject::connect(qGuiApp, &QGuiApplication::screenAdded, qGuiApp,
+            [this](QScreen *screen) { watchScreen(screen); updateScreens(); });
+        m_screenConnections << QObject::connect(qGuiApp, &QGuiApplication::screenRemoved, qGuiApp,
+            [this](QScreen *screen) { updateScreens(screen); });
+        m_screenConnections << QObject::connect(qGuiApp, &QGuiApplication::primaryScreenChanged, qGuiApp,
+            [this]() { updateScreens(); });
+        lock.unlock();
+
+        for (QScreen *screen : qGuiApp->screens()) {
+            watchScreen(screen);
+        }
+        updateScreens();
+    }
+
+    ~QtWindowSystem()
+    {
+        QMutexLocker lock(&m_screensMutex);
+        for (const auto &connection : m_screenConnections) {
+            QObject::disconnect(connection);
+        }
     }
 
     virtual QWindow* focusedWindow() override
@@ -434,48 +465,124 @@ public:
     void handleMouseEvent(ulong timestamp, QPointF relative, QPointF absolute, Qt::MouseButtons buttons,
                           Qt::KeyboardModifiers modifiers) override
     {
-        // Send to the first screen that handles the mouse event
-        // TODO: Have a mechanism to tell which screen currently has the logical mouse pointer
-        //       (because they all might have their own separate graphical mouse pointer item)
-        //       This will probably come once we implement the feature of having the mouse pointer
-        //       crossing adjacent screens.
-
-        const QList<QScreen *> screens = qGuiApp->screens();
-        bool eventHandled = false;
-        int i = 0;
-        while (i < screens.count() && !eventHandled) {
-            auto screenWindow = static_cast<Screen*>(screens[i]->handle());
-            auto platformCursor = static_cast<qtmir::Cursor*>(screenWindow->cursor());
-            eventHandled = platformCursor->handleMouseEvent(timestamp, relative, buttons, modifiers);
-            ++i;
-        }
-        if (!eventHandled) {
+        const bool handled = deliverToCursor(absolute, [&](qtmir::Cursor *cursor) {
+            return cursor->handleMouseEvent(timestamp, relative, buttons, modifiers);
+        });
+        if (!handled) {
             QWindowSystemInterface::handleMouseEvent(focusedWindow(), timestamp, absolute, absolute, buttons, modifiers);
         }
     }
 
     void handleWheelEvent(ulong timestamp, QPointF absolute, QPoint angleDelta, Qt::KeyboardModifiers modifiers) override
     {
-        // Send to the first screen that handles the mouse event
-        // TODO: Have a mechanism to tell which screen currently has the logical mouse pointer
-        //       (because they all might have their own separate graphical mouse pointer item)
-        //       This will probably come once we implement the feature of having the mouse pointer
-        //       crossing adjacent screens.
-
-        const QList<QScreen *> screens = qGuiApp->screens();
-        bool eventHandled = false;
-        int i = 0;
-        while (i < screens.count() && !eventHandled) {
-            auto screenWindow = static_cast<Screen*>(screens[i]->handle());
-            auto platformCursor = static_cast<qtmir::Cursor*>(screenWindow->cursor());
-            eventHandled = platformCursor->handleWheelEvent(timestamp, angleDelta, modifiers);
-            ++i;
-        }
-        if (!eventHandled) {
+        const bool handled = deliverToCursor(absolute, [&](qtmir::Cursor *cursor) {
+            return cursor->handleWheelEvent(timestamp, angleDelta, modifiers);
+        });
+        if (!handled) {
             QWindowSystemInterface::handleWheelEvent(focusedWindow(), timestamp, absolute, absolute,
                                                      QPoint(), angleDelta, modifiers, Qt::ScrollUpdate);
         }
     }
+
+private:
+    struct ScreenCursor {
+        qtmir::OutputId outputId;
+        QRect geometry;
+        qtmir::Cursor *cursor;
+    };
+
+    void watchScreen(QScreen *screen)
+    {
+        QMutexLocker lock(&m_screensMutex);
+        m_screenConnections << QObject::connect(screen, &QScreen::geometryChanged, qGuiApp,
+                                                [this]() { updateScreens(); });
+    }
+
+    // GUI thread. The removed screen may still be listed while it goes away.
+    void updateScreens(QScreen *removed = nullptr)
+    {
+        QVector<ScreenCursor> screens;
+        for (QScreen *qScreen : qGuiApp->screens()) {
+            if (qScreen != removed) {
+                auto screen = static_cast<Screen*>(qScreen->handle());
+                screens.append({screen->outputId(), screen->geometry(), static_cast<qtmir::Cursor*>(screen->cursor())});
+            }
+        }
+
+        QMutexLocker lock(&m_screensMutex);
+        m_screens = screens;
+        ++m_screensVersion;
+    }
+
+    /*
+        Offers the event to the Cursor of the screen holding the mouse pointer first, then to the Cursors
+        of the other screens until one takes it. Returns whether one did.
+
+        Works off a copy of the screens' geometries and Cursors, which the GUI thread refreshes as screens
+        come, go or move. The screen holding the pointer is only looked up again once the pointer leaves
+        its geometry, or when the screens changed.
+     */
+    template<typename Handler>
+    bool deliverToCursor(QPointF absolute, Handler handle)
+    {
+        const QPoint position = absolute.toPoint();
+
+        if (m_screensVersion.load() != m_inputScreensVersion) {
+            const qtmir::OutputId pointerOutputId = m_pointerScreen >= 0 ? m_inputScreens[m_pointerScreen].outputId
+                                                                         : qtmir::OutputId{-1};
+            {
+                QMutexLocker lock(&m_screensMutex);
+                m_inputScreens = m_screens;
+                m_inputScreensVersion = m_screensVersion.load();
+            }
+            m_pointerScreen = -1;
+            for (int i = 0; i < m_inputScreens.count(); ++i) {
+                if (m_inputScreens[i].outputId == pointerOutputId) {
+                    m_pointerScreen = i;
+                }
+            }
+        }
+
+        if (m_pointerScreen < 0 || !m_inputScreens[m_pointerScreen].geometry.contains(position)) {
+            int pointerScreen = -1;
+            for (int i = 0; i < m_inputScreens.count() && pointerScreen < 0; ++i) {
+                if (m_inputScreens[i].geometry.contains(position)) {
+                    pointerScreen = i;
+                }
+            }
+            if (pointerScreen < 0) {
+                // In between outputs, or outside all of them. Stick with the screen it was on, or else the primary one.
+                pointerScreen = m_pointerScreen >= 0 || m_inputScreens.isEmpty() ? m_pointerScreen : 0;
+            }
+            if (pointerScreen != m_pointerScreen && pointerScreen >= 0) {
+                qCDebug(QTMIR_MIR_INPUT) << "Mouse pointer moved to screen" << m_inputScreens[pointerScreen].geometry;
+            }
+            m_pointerScreen = pointerScreen;
+        }
+
+        if (m_pointerScreen >= 0 && handle(m_inputScreens[m_pointerScreen].cursor)) {
+            return true;
+        }
+
+        // The pointer's screen may have no MousePointer that takes events, whereas another one does
+        for (int i = 0; i < m_inputScreens.count(); ++i) {
+            if (i != m_pointerScreen && handle(m_inputScreens[i].cursor)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Written by the GUI thread, read by the Mir input thread
+    QMutex m_screensMutex;
+    QVector<ScreenCursor> m_screens; // primary first
+    std::atomic<int> m_screensVersion{0};
+    QVector<QMetaObject::Connection> m_screenConnections;
+
+    // Mir input thread only
+    QVector<ScreenCursor> m_inputScreens;
+    int m_inputScreensVersion{-1};
+    int m_pointerScreen{-1}; // index in m_inputScreens, none yet
 };
 
 } // anonymous namespace
@@ -498,6 +605,11 @@ QtEventFeeder::QtEventFeeder(QtEventFeeder::QtWindowSystemInterface *windowSyste
             QTouchDevice::Position | QTouchDevice::Area | QTouchDevice::Pressure |
             QTouchDevice::NormalizedPosition);
     mQtWindowSystem->registerTouchDevice(mTouchDevice);
+
+    const QString recordingPath = QString::fromLocal8Bit(qgetenv("QTMIR_INPUT_RECORDING"));
+    if (!recordingPath.isEmpty()) {
+        mRecorder.reset(new qtmir::InputRecorder(recordingPath));
+    }
 }
 
 QtEventFeeder::~QtEventFeeder()
@@ -507,6 +619,8 @@ QtEventFeeder::~QtEventFeeder()
 
 bool QtEventFeeder::dispatch(MirEvent const& event)
 {
+    qtmir::ThreadScheduling::instance()->applyToCurrentThread(qtmir::ThreadScheduling::InputThread);
+
     auto type = mir_event_get_type(&event);
     if (type != mir_event_type_input)
         return false;
@@ -532,6 +646,13 @@ bool QtEventFeeder::dispatch(MirEvent const& event)
 namespace
 {
 
+void recordDispatchLatency(const MirInputEvent *iev)
+{
+    const auto latency = std::chrono::steady_clock::now().time_since_epoch()
+            - std::chrono::nanoseconds(mir_input_event_get_event_time(iev));
+    qtmir::InputLatencyStats::instance()->recordDispatch(mir_input_event_get_device_id(iev), latency);
+}
+
 Qt::KeyboardModifiers getQtModifiersFromMir(MirInputEventModifiers modifiers)
 {
     Qt::KeyboardModifiers qtModifiers = Qt::NoModifier;
@@ -574,9 +695,13 @@ Qt::MouseButtons getQtMouseButtonsfromMirPointerEvent(MirPointerEvent const* pev
 void QtEventFeeder::dispatchPointer(const MirPointerEvent *pev)
 {
     auto iev = mir_pointer_event_input_event(pev);
+    if (mRecorder) {
+        mRecorder->record(iev);
+    }
     auto timestamp = qtmir::compressTimestamp<qtmir::Timestamp>(
                 std::chrono::nanoseconds(mir_input_event_get_event_time(iev)));
     EventBuilder::instance()->store(iev, timestamp.count());
+    recordDispatchLatency(iev);
     auto action = mir_pointer_event_action(pev);
     qCDebug(QTMIR_MIR_INPUT) << "Received" << qPrintable(mirPointerEventToString(pev));
 
@@ -612,9 +737,13 @@ void QtEventFeeder::dispatchPointer(const MirPointerEvent *pev)
 void QtEventFeeder::dispatchKey(const MirKeyboardEvent *kev)
 {
     auto iev = mir_keyboard_event_input_event(kev);
+    if (mRecorder) {
+        mRecorder->record(iev);
+    }
     auto timestamp = qtmir::compressTimestamp<qtmir::Timestamp>(
                 std::chrono::nanoseconds(mir_input_event_get_event_time(iev)));
     EventBuilder::instance()->store(iev, timestamp.count());
+    recordDispatchLatency(iev);
 
     xkb_keysym_t xk_sym = mir_keyboard_event_key_code(kev);
 
@@ -660,12 +789,16 @@ void QtEventFeeder::dispatchKey(const MirKeyboardEvent *kev)
         mir_keyboard_event_modifiers(kev), text, is_auto_rep);
 }
 
-void QtEventFeeder::dispatchTouch(const MirTouchEvent *tev)
+void QtEventFeeder::dispatchTouch(const MirTouchEvent *tev, bool deliveredToClient)
 {
     auto iev = mir_touch_event_input_event(tev);
+    if (mRecorder) {
+        mRecorder->record(iev);
+    }
     auto timestamp = qtmir::compressTimestamp<qtmir::Timestamp>(
                 std::chrono::nanoseconds(mir_input_event_get_event_time(iev)));
-    EventBuilder::instance()->store(iev, timestamp.count());
+    EventBuilder::instance()->store(iev, timestamp.count(), deliveredToClient);
+    recordDispatchLatency(iev);
 
     tracepoint(qtmirserver, touchEventDispatch_start, std::chrono::nanoseconds(timestamp).count());
 
@@ -21,8 +21,14 @@
 
 #include <qpa/qwindowsysteminterface.h>
 
+#include <memory>
+
 class QTouchDevice;
 
+namespace qtmir {
+class InputRecorder;
+}
+
 /*
   Fills Qt's event loop with input events from Mir
  */
@@ -58,7 +64,8 @@ public:
     virtual ~QtEventFeeder();
 
     void dispatchKey(MirKeyboardEvent const* event);
-    void dispatchTouch(MirTouchEvent const* event);
+    // deliveredToClient: the event has been dispatched to its client directly already, Qt gets just a copy
+    void dispatchTouch(MirTouchEvent const* event, bool deliveredToClient = false);
     void dispatchPointer(MirPointerEvent const* event);
 
     bool dispatch(MirEvent const& event); // FIXME used only in tests
@@ -75,6 +82,9 @@ private:
 
     // Maps the id of an active touch to its last known state
     QHash<int, QWindowSystemInterface::TouchPoint> mActiveTouches;
+
+    // Only when QTMIR_INPUT_RECORDING is set
+    std::unique_ptr<qtmir::InputRecorder> mRecorder;
 };
 
 #endif // MIR_QT_EVENT_FEEDER_H
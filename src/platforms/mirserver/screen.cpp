@@ -27,6 +27,7 @@
 #include "mir/graphics/display_buffer.h"
 #include "mir/graphics/display.h"
 #include <mir/graphics/display_configuration.h>
+#include <mir/graphics/renderable.h>
 #include <mir/renderer/gl/render_target.h>
 
 // Qt
@@ -103,6 +104,27 @@ enum QImage::Format qImageFormatFromMirPixelFormat(MirPixelFormat mirPixelFormat
     return QImage::Format_Invalid;
 }
 
+// A client buffer covering a whole output, as is
+class ScanoutRenderable : public mir::graphics::Renderable
+{
+public:
+    ScanoutRenderable(const std::shared_ptr<mir::graphics::Buffer> &buffer, const mg::Rectangle &position)
+        : m_buffer(buffer)
+        , m_position(position)
+    {}
+
+    ID id() const override { return m_buffer.get(); }
+    std::shared_ptr<mir::graphics::Buffer> buffer() const override { return m_buffer; }
+    mg::Rectangle screen_position() const override { return m_position; }
+    float alpha() const override { return 1.0f; }
+    glm::mat4 transformation() const override { return glm::mat4(); }
+    bool shaped() const override { return false; }
+
+private:
+    const std::shared_ptr<mir::graphics::Buffer> m_buffer;
+    const mg::Rectangle m_position;
+};
+
 QString displayTypeToString(qtmir::OutputTypes type)
 {
     typedef qtmir::OutputTypes Type;
@@ -151,7 +173,10 @@ Screen::Screen(const mir::graphics::DisplayConfigurationOutput &screen,
     , m_formFactor(mir_form_factor_unknown)
     , m_sensorEnabled(false)
     , m_renderTarget(nullptr)
+    , m_displayBuffer(nullptr)
     , m_displayGroup(nullptr)
+    , m_scanout(false)
+    , m_scannedOut(false)
     , m_screenWindow(nullptr)
 {
     // Hack to make signals work
@@ -355,12 +380,23 @@ void Screen::setMirDisplayBuffer(mir::graphics::DisplayBuffer *buffer, mir::grap
     qCDebug(QTMIR_SCREENS) << "Screen::setMirDisplayBuffer" << this << as_render_target(buffer) << group;
     // This operation should only be performed while rendering is stopped
     m_renderTarget = as_render_target(buffer);
+    m_displayBuffer = buffer;
     m_displayGroup = group;
 }
 
 void Screen::swapBuffers()
 {
-    m_renderTarget->swap_buffers();
+    if (m_scanout != m_scannedOut) {
+        qCDebug(QTMIR_SCREENS) << "Screen::swapBuffers" << this << (m_scanout ? "scanning out a client buffer" : "back to composing");
+        m_scannedOut = m_scanout;
+    }
+
+    // On scanout the display already has its buffer, what got rendered into the framebuffer is not shown
+    if (m_scanout) {
+        m_scanout = false;
+    } else {
+        m_renderTarget->swap_buffers();
+    }
 
     /* FIXME this exposes a QtMir architecture problem, as Screen is supposed to wrap a mg::DisplayBuffer.
      * We use Qt's multithreaded renderer, where each Screen is rendered to relatively independently, and
@@ -376,6 +412,17 @@ void Screen::swapBuffers()
     m_displayGroup->post();
 }
 
+bool Screen::scanout(const std::shared_ptr<mir::graphics::Buffer> &buffer)
+{
+    if (!m_displayBuffer || !buffer) {
+        return false;
+    }
+
+    mir::graphics::RenderableList renderables{std::make_shared<ScanoutRenderable>(buffer, m_displayBuffer->view_area())};
+    m_scanout = m_displayBuffer->overlay(renderables);
+    return m_scanout;
+}
+
 void Screen::makeCurrent()
 {
     m_renderTarget->make_current();
@@ -37,7 +37,7 @@
 
 class OrientationSensor;
 namespace mir {
-    namespace graphics { class DisplayBuffer; class DisplaySyncGroup; class DisplayConfigurationOutput; }
+    namespace graphics { class Buffer; class DisplayBuffer; class DisplaySyncGroup; class DisplayConfigurationOutput; }
     namespace renderer { namespace gl { class RenderTarget; }}
 }
 
@@ -87,6 +87,12 @@ protected:
     void makeCurrent();
     void doneCurrent();
 
+    // Has the display show the given client buffer as is for the frame being rendered, instead of
+    // what gets composed into the framebuffer. Returns whether the display could take it.
+    // Only for the render thread, once per frame, after the scene got synchronized and before swapBuffers()
+    bool scanout(const std::shared_ptr<mir::graphics::Buffer> &buffer);
+    bool scannedOut() const { return m_scannedOut; } // whether the frame last swapped was scanned out
+
 private:
     bool internalDisplay() const;
 
@@ -102,7 +108,10 @@ private:
     bool m_sensorEnabled;
 
     mir::renderer::gl::RenderTarget *m_renderTarget;
+    mir::graphics::DisplayBuffer *m_displayBuffer;
     mir::graphics::DisplaySyncGroup *m_displayGroup;
+    bool m_scanout; // whether this frame goes straight from a client buffer to the display
+    bool m_scannedOut; // same, for the previous frame
     qtmir::OutputId m_outputId;
     qtmir::OutputTypes m_type;
     MirPowerMode m_powerMode;
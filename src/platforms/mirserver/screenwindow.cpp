@@ -15,16 +15,24 @@
  */
 
 #include "screenwindow.h"
+#include "damagetracker.h"
 #include "screen.h"
+#include "threadscheduling.h"
 
 // Mir
 #include <mir/geometry/size.h>
+#include <mir/graphics/buffer.h>
 #include <mir/graphics/display_buffer.h>
 
 // Qt
 #include <qpa/qwindowsysteminterface.h>
 #include <qpa/qplatformscreen.h>
 #include <QQuickWindow>
+#include <QSGClipNode>
+#include <QSGGeometry>
+#include <QtQuick/private/qquickitem_p.h>
+#include <QtQuick/private/qquickwindow_p.h>
+#include <QtQuick/private/qsgrenderer_p.h>
 #include <QtQuick/private/qsgrenderloop_p.h>
 #include <QDebug>
 
@@ -40,10 +48,28 @@ static WId newWId()
     return ++id;
 }
 
+// Whether anything in the subtree of item gets drawn
+static bool drawsAnything(const QQuickItem *item)
+{
+    if (!item->isVisible() || qFuzzyIsNull(item->opacity())) {
+        return false;
+    }
+    if (item->flags() & QQuickItem::ItemHasContents) {
+        return true;
+    }
+    for (const QQuickItem *child : item->childItems()) {
+        if (drawsAnything(child)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 ScreenWindow::ScreenWindow(QWindow *window)
     : QPlatformWindow(window)
     , m_exposed(false)
     , m_winId(newWId())
+    , m_scanoutEnabled(qgetenv("QTMIR_DIRECT_SCANOUT") == "1")
 {
     // Note: window->screen() is set to the primaryScreen(), if not specified explicitly.
     const auto myScreen = static_cast<Screen *>(window->screen()->handle());
@@ -56,11 +82,25 @@ ScreenWindow::ScreenWindow(QWindow *window)
         window->setGeometry(screenGeometry);
     }
     window->setSurfaceType(QSurface::OpenGLSurface);
+
+    auto quickWindow = qobject_cast<QQuickWindow *>(window);
+    if (quickWindow && qgetenv("QTMIR_PARTIAL_UPDATES") == "1") {
+        m_damageTracker.reset(new qtmir::DamageTracker(quickWindow));
+    }
+    if (quickWindow && m_scanoutEnabled) {
+        m_clipConnections[0] = QObject::connect(quickWindow, &QQuickWindow::afterSynchronizing, quickWindow,
+                                                [this]() { clipScene(); }, Qt::DirectConnection);
+        m_clipConnections[1] = QObject::connect(quickWindow, &QQuickWindow::sceneGraphInvalidated, quickWindow,
+                                                [this]() { releaseClipNode(); }, Qt::DirectConnection);
+    }
 }
 
 ScreenWindow::~ScreenWindow()
 {
     qCDebug(QTMIR_SCREENS) << "Destroying ScreenWindow" << this;
+    for (const auto &connection : m_clipConnections) {
+        QObject::disconnect(connection);
+    }
     static_cast<Screen *>(screen())->setWindow(nullptr);
 }
 
@@ -115,11 +155,17 @@ void ScreenWindow::setScreen(QPlatformScreen *newScreen)
 
 void ScreenWindow::swapBuffers()
 {
-    static_cast<Screen *>(screen())->swapBuffers();
+    auto myScreen = static_cast<Screen *>(screen());
+    myScreen->swapBuffers();
+
+    if (m_damageTracker) {
+        m_damageTracker->frameSwapped(!myScreen->scannedOut());
+    }
 }
 
 void ScreenWindow::makeCurrent()
 {
+    qtmir::ThreadScheduling::instance()->applyToCurrentThread(qtmir::ThreadScheduling::RenderThread);
     static_cast<Screen *>(screen())->makeCurrent();
 }
 
@@ -127,3 +173,112 @@ void ScreenWindow::doneCurrent()
 {
     static_cast<Screen *>(screen())->doneCurrent();
 }
+
+bool ScreenWindow::scanout(const QQuickItem *item, const std::shared_ptr<mir::graphics::Buffer> &buffer)
+{
+    if (!m_scanoutEnabled || !buffer || !isUnobstructedFullscreen(item, window())) {
+        return false;
+    }
+
+    // Shown as is, so no scaling and nothing to blend with
+    const auto size = buffer->size();
+    if (QSize(size.width.as_int(), size.height.as_int()) != geometry().size()
+            || buffer->pixel_format() == mir_pixel_format_abgr_8888
+            || buffer->pixel_format() == mir_pixel_format_argb_8888) {
+        return false;
+    }
+
+    m_scanoutOffered = static_cast<Screen *>(screen())->scanout(buffer);
+    return m_scanoutOffered;
+}
+
+// On scanout what gets rendered isn't shown, so the whole scene gets clipped away, much like DamageTracker clips
+// it to what needs repainting. Otherwise the clip covers the whole window.
+void ScreenWindow::clipScene()
+{
+    const bool scanout = m_scanoutOffered;
+    m_scanoutOffered = false;
+
+    auto windowPrivate = QQuickWindowPrivate::get(static_cast<QQuickWindow *>(window()));
+    QSGNode *rootNode = windowPrivate->renderer ? windowPrivate->renderer->rootNode() : nullptr;
+    if (!rootNode) {
+        return;
+    }
+
+    if (rootNode != m_rootNode) {
+        if (!scanout) {
+            return; // no need for a clip node until there's a scanout
+        }
+
+        m_rootNode = rootNode;
+        m_clipNode = new QSGClipNode;
+        m_clipGeometry = new QSGGeometry(QSGGeometry::defaultAttributes_Point2D(), 4);
+        m_clipNode->setGeometry(m_clipGeometry);
+        m_clipNode->setFlag(QSGNode::OwnsGeometry);
+        m_clipNode->setIsRectangular(true);
+        m_clipRect = QRectF(0, 0, -1, -1); // anything but what's set below
+
+        while (QSGNode *child = m_rootNode->firstChild()) {
+            m_rootNode->removeChildNode(child);
+            m_clipNode->appendChildNode(child);
+        }
+        m_rootNode->appendChildNode(m_clipNode);
+    }
+
+    const QRectF clipRect = scanout ? QRectF() : QRectF(QPointF(0, 0), window()->size());
+    if (clipRect != m_clipRect) {
+        m_clipRect = clipRect;
+        m_clipNode->setClipRect(clipRect);
+        QSGGeometry::updateRectGeometry(m_clipGeometry, clipRect);
+        m_clipNode->markDirty(QSGNode::DirtyGeometry);
+    }
+}
+
+void ScreenWindow::releaseClipNode()
+{
+    // It went away with the rest of the scene graph
+    m_rootNode = nullptr;
+    m_clipNode = nullptr;
+    m_clipGeometry = nullptr;
+}
+
+bool ScreenWindow::isUnobstructedFullscreen(const QQuickItem *item, const QWindow *window)
+{
+    if (!item || !window || item->window() != window || !item->isVisible()) {
+        return false;
+    }
+
+    const QRectF windowRect(QPointF(0, 0), window->size());
+    if (item->mapRectToScene(QRectF(0, 0, item->width(), item->height())) != windowRect) {
+        return false;
+    }
+
+    // Anything drawn on top of the item itself
+    for (const QQuickItem *child : item->childItems()) {
+        if (drawsAnything(child)) {
+            return false;
+        }
+    }
+
+    for (const QQuickItem *current = item; current->parentItem(); current = current->parentItem()) {
+        if (!qFuzzyCompare(current->opacity(), 1.0) || current->rotation() != 0.0 || current->scale() != 1.0
+                || !QQuickItemPrivate::get(current)->transforms.isEmpty()) {
+            return false;
+        }
+
+        // Anything drawn after it, with the same parent
+        const QList<QQuickItem *> siblings = QQuickItemPrivate::get(current->parentItem())->paintOrderChildItems();
+        for (int i = siblings.indexOf(const_cast<QQuickItem *>(current)) + 1; i < siblings.count(); ++i) {
+            if (drawsAnything(siblings.at(i))) {
+                return false;
+            }
+        }
+
+        const QQuickItem *parent = current->parentItem();
+        if (parent->clip() && !parent->mapRectToScene(QRectF(0, 0, parent->width(), parent->height())).contains(windowRect)) {
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -18,6 +18,16 @@
 #define SCREENWINDOW_H
 
 #include <qpa/qplatformwindow.h>
+#include <QRectF>
+
+#include <memory>
+
+class QQuickItem;
+class QSGClipNode;
+class QSGGeometry;
+class QSGNode;
+namespace mir { namespace graphics { class Buffer; }}
+namespace qtmir { class DamageTracker; }
 
 // ScreenWindow implements the basics of a QPlatformWindow.
 // QtMir enforces one Window per Screen, so Window and Screen are tightly coupled.
@@ -40,9 +50,40 @@ public:
     void makeCurrent();
     void doneCurrent();
 
+    /*
+        Direct scanout, enabled with QTMIR_DIRECT_SCANOUT=1
+
+        Offers the display the buffer of an item showing a client surface, for the frame being rendered.
+        It's taken only if the item covers the whole screen, opaque and untransformed, with nothing drawn
+        on top of it. Returns whether it was taken, in which case the scene doesn't get rendered for that frame.
+
+        Only for the render thread, from QQuickItem::updatePaintNode(). The offer holds for one frame only:
+        a frame rendered without it, say because something else in the scene changed, gets composed.
+     */
+    bool scanout(const QQuickItem *item, const std::shared_ptr<mir::graphics::Buffer> &buffer);
+
+    /*
+        Whether the item covers the whole window, opaque and untransformed, with nothing drawn on top of it.
+        Only while the scene can't change, as when the GUI thread is blocked for synchronizing.
+     */
+    static bool isUnobstructedFullscreen(const QQuickItem *item, const QWindow *window);
+
 private:
+    void clipScene(); // render thread, GUI thread blocked
+    void releaseClipNode();
+
     bool m_exposed;
     WId m_winId;
+    const bool m_scanoutEnabled;
+    std::unique_ptr<qtmir::DamageTracker> m_damageTracker;
+
+    // On scanout the whole scene gets clipped away, so nothing gets rendered. All in the render thread.
+    bool m_scanoutOffered{false}; // and taken, for the frame being synchronized
+    QSGNode *m_rootNode{nullptr};
+    QSGClipNode *m_clipNode{nullptr};
+    QSGGeometry *m_clipGeometry{nullptr};
+    QRectF m_clipRect;
+    QMetaObject::Connection m_clipConnections[2];
 };
 
 #endif // SCREENWINDOW_H
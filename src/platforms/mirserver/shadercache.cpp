@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "shadercache.h"
+#include "logging.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QStandardPaths>
+#include <QThreadPool>
+
+#include <algorithm>
+
+#include <fcntl.h>
+
+namespace qtmir {
+
+namespace {
+
+// A shell's worth of scene graph programs is a few hundred KiB. Don't let a stale cache grow the startup I/O.
+const qint64 maxPrefetchBytes = 8 * 1024 * 1024;
+
+class ShaderCachePrefetchJob : public QRunnable
+{
+public:
+    ShaderCachePrefetchJob(const QStringList &directories)
+        : m_directories(directories) {}
+
+    void run() override
+    {
+        const QStringList files = ShaderCache::filesToPrefetch(m_directories, maxPrefetchBytes);
+        for (const QString &fileName : files) {
+            QFile file(fileName);
+            if (!file.open(QIODevice::ReadOnly)) {
+                continue;
+            }
+            // Only schedules the read, the kernel does it in the background
+            if (posix_fadvise(file.handle(), 0, 0, POSIX_FADV_WILLNEED) != 0) {
+                file.readAll();
+            }
+        }
+        qCDebug(QTMIR_SCREENS) << "ShaderCache - prefetched" << files.count() << "program binaries";
+    }
+
+private:
+    const QStringList m_directories;
+};
+
+bool isShaderDiskCacheDisabled()
+{
+    return QCoreApplication::testAttribute(Qt::AA_DisableShaderDiskCache)
+        || qEnvironmentVariableIntValue("QT_DISABLE_SHADER_DISK_CACHE") != 0;
+}
+
+} // namespace
+
+void ShaderCache::prefetch()
+{
+    if (isShaderDiskCacheDisabled()) {
+        return;
+    }
+
+    // Qt has stored them under either location, depending on its version
+    QStringList cacheLocations;
+    cacheLocations << QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+                   << QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation);
+
+    const QStringList directories = cacheDirectories(cacheLocations);
+    if (directories.isEmpty()) {
+        qCDebug(QTMIR_SCREENS) << "ShaderCache - nothing to prefetch, shaders will be compiled and cached this time";
+        return;
+    }
+
+    QThreadPool::globalInstance()->start(new ShaderCachePrefetchJob(directories));
+}
+
+QStringList ShaderCache::cacheDirectories(const QStringList &cacheLocations)
+{
+    QStringList directories;
+    for (const QString &location : cacheLocations) {
+        if (location.isEmpty()) {
+            continue;
+        }
+        const QFileInfoList entries = QDir(location).entryInfoList(QStringList() << QStringLiteral("qtshadercache*"),
+                                                                   QDir::Dirs | QDir::NoDotAndDotDot);
+        for (const QFileInfo &entry : entries) {
+            if (!directories.contains(entry.absoluteFilePath())) {
+                directories << entry.absoluteFilePath();
+            }
+        }
+    }
+    return directories;
+}
+
+QStringList ShaderCache::filesToPrefetch(const QStringList &directories, qint64 maxBytes)
+{
+    QFileInfoList candidates;
+    for (const QString &directory : directories) {
+        candidates << QDir(directory).entryInfoList(QDir::Files | QDir::Readable);
+    }
+
+    // Programs the last session used have the newest access or modification times
+    std::sort(candidates.begin(), candidates.end(), [](const QFileInfo &a, const QFileInfo &b) {
+        return qMax(a.lastRead(), a.lastModified()) > qMax(b.lastRead(), b.lastModified());
+    });
+
+    QStringList files;
+    qint64 totalBytes = 0;
+    for (const QFileInfo &candidate : candidates) {
+        if (totalBytes + candidate.size() > maxBytes) {
+            continue;
+        }
+        totalBytes += candidate.size();
+        files << candidate.absoluteFilePath();
+    }
+    return files;
+}
+
+} // namespace qtmir
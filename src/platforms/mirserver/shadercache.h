@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QTMIR_SHADERCACHE_H
+#define QTMIR_SHADERCACHE_H
+
+#include <QStringList>
+
+namespace qtmir {
+
+/*
+    Helps Qt's own disk cache of GL program binaries along.
+
+    Qt Quick builds its scene graph programs through QOpenGLShaderProgram's cacheable path, which stores
+    the linked binaries on disk keyed by the GL renderer, driver version and a hash of the shader sources,
+    and loads them back instead of compiling on later runs. That is already enabled for our contexts, as
+    they are OpenGL ES ones. What's left is the first frame after boot, where the scattered cache files are
+    read synchronously from a cold disk by the render thread; prefetch() pulls them into the page cache
+    from a worker thread while the Mir server is still starting up.
+ */
+class ShaderCache
+{
+public:
+    // Reads the cache files ahead on a worker thread. Does nothing if Qt's shader disk cache is disabled.
+    static void prefetch();
+
+    // Directories Qt keeps program binaries in, under the given cache locations
+    static QStringList cacheDirectories(const QStringList &cacheLocations);
+
+    // The files in the given directories most worth reading ahead, most recently used first, up to maxBytes
+    static QStringList filesToPrefetch(const QStringList &directories, qint64 maxBytes);
+};
+
+} // namespace qtmir
+
+#endif // QTMIR_SHADERCACHE_H
@@ -0,0 +1,200 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "threadscheduling.h"
+#include "logging.h"
+
+#include <QCoreApplication>
+#include <QList>
+#include <QThread>
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace qtmir {
+
+namespace {
+
+const char *const threadNames[] = { "RENDER", "INPUT", "SERVER" };
+
+bool parseInt(const QByteArray &string, int min, int max, int *value)
+{
+    bool ok = false;
+    const int result = string.trimmed().toInt(&ok);
+    if (!ok || result < min || result > max) {
+        return false;
+    }
+    *value = result;
+    return true;
+}
+
+} // namespace
+
+bool ThreadScheduling::Policy::parseScheduler(const QByteArray &string, Policy *policy)
+{
+    const QList<QByteArray> parts = string.trimmed().split(':');
+    if (parts.count() != 2) {
+        return false;
+    }
+
+    const QByteArray name = parts[0].trimmed().toLower();
+    Scheduler scheduler;
+    int min, max;
+    if (name == "fifo") {
+        scheduler = Fifo;
+        min = 1; max = 99;
+    } else if (name == "rr") {
+        scheduler = RoundRobin;
+        min = 1; max = 99;
+    } else if (name == "nice") {
+        scheduler = Nice;
+        min = -20; max = 19;
+    } else {
+        return false;
+    }
+
+    int priority;
+    if (!parseInt(parts[1], min, max, &priority)) {
+        return false;
+    }
+
+    policy->scheduler = scheduler;
+    policy->priority = priority;
+    return true;
+}
+
+bool ThreadScheduling::Policy::parseCpus(const QByteArray &string, Policy *policy)
+{
+    QVector<int> cpus;
+    for (const QByteArray &range : string.split(',')) {
+        const QList<QByteArray> bounds = range.split('-');
+        int first, last;
+        if (bounds.count() > 2
+                || !parseInt(bounds.first(), 0, CPU_SETSIZE - 1, &first)
+                || !parseInt(bounds.last(), first, CPU_SETSIZE - 1, &last)) {
+            return false;
+        }
+        for (int cpu = first; cpu <= last; ++cpu) {
+            if (!cpus.contains(cpu)) {
+                cpus << cpu;
+            }
+        }
+    }
+
+    policy->cpus = cpus;
+    return true;
+}
+
+ThreadScheduling *ThreadScheduling::instance()
+{
+    static ThreadScheduling instance;
+    return &instance;
+}
+
+ThreadScheduling::ThreadScheduling()
+{
+    for (int thread = RenderThread; thread <= ServerThread; ++thread) {
+        const QByteArray prefix = QByteArray("QTMIR_") + threadNames[thread] + "_THREAD_";
+        Policy &policy = m_policies[thread];
+
+        const QByteArray scheduler = qgetenv(prefix + "SCHEDULING");
+        if (!scheduler.isEmpty() && !Policy::parseScheduler(scheduler, &policy)) {
+            qCWarning(QTMIR_MIR_MESSAGES) << "ThreadScheduling - ignoring invalid" << (prefix + "SCHEDULING") << scheduler;
+        }
+
+        const QByteArray cpus = qgetenv(prefix + "CPUS");
+        if (!cpus.isEmpty() && !Policy::parseCpus(cpus, &policy)) {
+            qCWarning(QTMIR_MIR_MESSAGES) << "ThreadScheduling - ignoring invalid" << (prefix + "CPUS") << cpus;
+        }
+    }
+}
+
+bool ThreadScheduling::applyToCurrentThread(Thread thread) const
+{
+    static thread_local bool applied[ServerThread + 1] = {};
+    if (applied[thread]) {
+        return false;
+    }
+    applied[thread] = true;
+
+    // With the basic render loop the GUI thread renders too, and it shouldn't get the render thread's policy
+    if (thread == RenderThread && QCoreApplication::instance()
+            && QThread::currentThread() == QCoreApplication::instance()->thread()) {
+        return false;
+    }
+
+    const Policy &policy = m_policies[thread];
+    if (policy.isUnchanged()) {
+        return false;
+    }
+
+    if (apply(policy)) {
+        qCDebug(QTMIR_MIR_MESSAGES) << "ThreadScheduling - applied the" << threadNames[thread] << "thread policy";
+    }
+    return true;
+}
+
+bool ThreadScheduling::apply(const Policy &policy)
+{
+    bool ok = true;
+
+    if (!policy.cpus.isEmpty()) {
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        for (int cpu : policy.cpus) {
+            CPU_SET(cpu, &cpuSet);
+        }
+        const int error = pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+        if (error != 0) {
+            qCWarning(QTMIR_MIR_MESSAGES) << "ThreadScheduling - failed to set the CPU affinity:" << strerror(error);
+            ok = false;
+        }
+    }
+
+    switch (policy.scheduler) {
+    case Policy::Unchanged:
+        break;
+    case Policy::Nice: {
+        // Nice values are per thread on Linux, given the thread id
+        if (setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), policy.priority) != 0) {
+            qCWarning(QTMIR_MIR_MESSAGES) << "ThreadScheduling - failed to set nice value" << policy.priority << ":" << strerror(errno);
+            ok = false;
+        }
+        break;
+    }
+    case Policy::Fifo:
+    case Policy::RoundRobin: {
+        sched_param param;
+        param.sched_priority = policy.priority;
+        const int error = pthread_setschedparam(pthread_self(),
+                                                policy.scheduler == Policy::Fifo ? SCHED_FIFO : SCHED_RR, &param);
+        if (error != 0) {
+            qCWarning(QTMIR_MIR_MESSAGES) << "ThreadScheduling - failed to set real time priority" << policy.priority << ":" << strerror(error);
+            ok = false;
+        }
+        break;
+    }
+    }
+
+    return ok;
+}
+
+} // namespace qtmir
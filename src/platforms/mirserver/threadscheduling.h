@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QTMIR_THREADSCHEDULING_H
+#define QTMIR_THREADSCHEDULING_H
+
+#include <QByteArray>
+#include <QVector>
+
+namespace qtmir {
+
+/*
+    Scheduling policy and CPU affinity for the threads that make up the shell's input to display path,
+    so that on big.LITTLE devices, say, input and rendering can be pinned to the big cores.
+
+    Configured through the environment, read when the platform plugin starts up:
+      QTMIR_RENDER_THREAD_SCHEDULING, QTMIR_INPUT_THREAD_SCHEDULING, QTMIR_SERVER_THREAD_SCHEDULING
+          "fifo:<priority>" or "rr:<priority>" for real time scheduling, with a priority from 1 to 99,
+          or "nice:<value>" to stay time-shared with a nice value from -20 to 19
+      QTMIR_RENDER_THREAD_CPUS, QTMIR_INPUT_THREAD_CPUS, QTMIR_SERVER_THREAD_CPUS
+          the CPUs the thread may run on, like "4-7" or "0,2,4-5"
+
+    The render thread is whichever thread draws a ScreenWindow, except for the GUI thread: with the basic
+    render loop, which renders in the GUI thread, the render policy is left alone. The input thread is the
+    Mir thread that hands input events to QtEventFeeder. The server thread is the one running Mir's main
+    loop; its policy is applied once Mir has started, so the threads Mir creates on startup keep the
+    defaults rather than inheriting it.
+
+    Real time scheduling and negative nice values need CAP_SYS_NICE or a suitable RLIMIT_RTPRIO/RLIMIT_NICE.
+    A policy that can't be applied is logged and left alone.
+ */
+class ThreadScheduling
+{
+public:
+    enum Thread {
+        RenderThread,
+        InputThread,
+        ServerThread
+    };
+
+    struct Policy {
+        enum Scheduler {
+            Unchanged,
+            Nice,
+            Fifo,
+            RoundRobin
+        };
+
+        Scheduler scheduler{Unchanged};
+        int priority{0}; // real time priority, or nice value
+        QVector<int> cpus; // empty to leave the affinity alone
+
+        bool isUnchanged() const { return scheduler == Unchanged && cpus.isEmpty(); }
+
+        // Each returns false, leaving policy untouched, if the string isn't valid
+        static bool parseScheduler(const QByteArray &string, Policy *policy);
+        static bool parseCpus(const QByteArray &string, Policy *policy);
+    };
+
+    static ThreadScheduling *instance();
+
+    // Reads the policies from the environment. Use instance(), other than for testing.
+    ThreadScheduling();
+
+    Policy policy(Thread thread) const { return m_policies[thread]; }
+
+    // Applies the policy for the given thread to the calling thread, the first time a thread calls it for
+    // that kind of thread. Returns whether this call applied it, or tried to.
+    bool applyToCurrentThread(Thread thread) const;
+
+    // Returns whether all of it could be applied
+    static bool apply(const Policy &policy);
+
+private:
+    Policy m_policies[ServerThread + 1];
+};
+
+} // namespace qtmir
+
+#endif // QTMIR_THREADSCHEDULING_H
@@ -111,6 +111,13 @@ void WindowController::setWindowMargins(Mir::Type windowType, const QMargins &ma
     }
 }
 
+void WindowController::setDirectInputAllowed(bool allowed)
+{
+    if (m_policy) {
+        m_policy->set_direct_input_allowed(allowed);
+    }
+}
+
 void WindowController::setPolicy(WindowManagementPolicy * const policy)
 {
     m_policy = policy;
@@ -45,6 +45,7 @@ public:
 
     void setWindowConfinementRegions(const QVector<QRect> &regions) override;
     void setWindowMargins(Mir::Type windowType, const QMargins &margins) override;
+    void setDirectInputAllowed(bool allowed) override;
 
     void setPolicy(WindowManagementPolicy *policy);
 
@@ -27,12 +27,50 @@
 #include "mirqtconversion.h"
 #include "tracepoints.h"
 
+#include <mir/events/event_builders.h>
+#include <mir_toolkit/mir_cookie.h>
+
 namespace qtmir {
     std::shared_ptr<ExtraWindowInfo> getExtraInfo(const miral::WindowInfo &windowInfo) {
         return std::static_pointer_cast<ExtraWindowInfo>(windowInfo.userdata());
     }
 }
 
+namespace {
+
+// Copy of the touch event with its touches relative to the given point, as clients expect them
+mir::EventUPtr makeLocalTouchEvent(const MirTouchEvent *event, const QPoint &origin)
+{
+    auto iev = mir_touch_event_input_event(event);
+
+    std::vector<uint8_t> cookie;
+    if (mir_input_event_has_cookie(iev)) {
+        auto cookie_ptr = mir_input_event_get_cookie(iev);
+        cookie.resize(mir_cookie_buffer_size(cookie_ptr));
+        mir_cookie_to_buffer(cookie_ptr, cookie.data(), cookie.size());
+        mir_cookie_release(cookie_ptr);
+    }
+
+    auto ev = mir::events::make_event(mir_input_event_get_device_id(iev),
+                                      std::chrono::nanoseconds(mir_input_event_get_event_time(iev)),
+                                      cookie, mir_touch_event_modifiers(event));
+
+    for (int i = 0; i < static_cast<int>(mir_touch_event_point_count(event)); ++i) {
+        mir::events::add_touch(*ev, mir_touch_event_id(event, i), mir_touch_event_action(event, i),
+                               mir_touch_event_tooltype(event, i),
+                               mir_touch_event_axis_value(event, i, mir_touch_axis_x) - origin.x(),
+                               mir_touch_event_axis_value(event, i, mir_touch_axis_y) - origin.y(),
+                               mir_touch_event_axis_value(event, i, mir_touch_axis_pressure),
+                               mir_touch_event_axis_value(event, i, mir_touch_axis_touch_major),
+                               mir_touch_event_axis_value(event, i, mir_touch_axis_touch_minor),
+                               mir_touch_event_axis_value(event, i, mir_touch_axis_size));
+    }
+
+    return ev;
+}
+
+} // namespace
+
 using namespace qtmir;
 
 WindowManagementPolicy::WindowManagementPolicy(const miral::WindowManagerTools &tools,
@@ -120,13 +158,46 @@ Rectangle WindowManagementPolicy::confirm_placement_on_display(const miral::Wind
 /* Handle input events - here just inject them into Qt event loop for later processing */
 bool WindowManagementPolicy::handle_keyboard_event(const MirKeyboardEvent *event)
 {
+    // Keys always go through shell, even with direct input: it handles hardware keys and global shortcuts
     m_eventFeeder.dispatchKey(event);
     return true;
 }
 
 bool WindowManagementPolicy::handle_touch_event(const MirTouchEvent *event)
 {
-    m_eventFeeder.dispatchTouch(event);
+    const int pointCount = mir_touch_event_point_count(event);
+
+    // A touch sequence goes entirely either straight to the client or through the shell, so decide on its first touch
+    if (pointCount == 1 && mir_touch_event_action(event, 0) == mir_touch_action_down) {
+        m_directTouchWindow = directInputWindow(&m_directTouchArea);
+        if (m_directTouchWindow) {
+            const QPoint touchPos(static_cast<int>(mir_touch_event_axis_value(event, 0, mir_touch_axis_x)),
+                                  static_cast<int>(mir_touch_event_axis_value(event, 0, mir_touch_axis_y)));
+            if (!m_directTouchArea.contains(touchPos)) {
+                m_directTouchWindow = miral::Window();
+            }
+        }
+    }
+
+    if (m_directTouchWindow) {
+        auto localEvent = makeLocalTouchEvent(event, m_directTouchArea.topLeft());
+        dispatchInputEvent(m_directTouchWindow, mir_event_get_input_event(localEvent.get()));
+        // Shell still gets to see it, for its gestures
+        m_eventFeeder.dispatchTouch(event, true /* deliveredToClient */);
+    } else {
+        m_eventFeeder.dispatchTouch(event);
+    }
+
+    bool sequenceEnded = true;
+    for (int i = 0; i < pointCount; ++i) {
+        if (mir_touch_event_action(event, i) != mir_touch_action_up) {
+            sequenceEnded = false;
+        }
+    }
+    if (sequenceEnded) {
+        m_directTouchWindow = miral::Window();
+    }
+
     return true;
 }
 
@@ -383,6 +454,39 @@ void WindowManagementPolicy::set_window_margins(MirWindowType windowType, const
     // TODO: update window positions/sizes to respect new margins.
 }
 
+void WindowManagementPolicy::set_direct_input_allowed(bool allowed)
+{
+    m_directInputAllowed = allowed;
+}
+
+// Input can skip the shell only for a focused fullscreen window, and only while shell has nothing on top of it
+// and draws it one to one, at the returned area
+miral::Window WindowManagementPolicy::directInputWindow(QRect *area) const
+{
+    if (!m_directInputAllowed) {
+        return miral::Window();
+    }
+
+    auto window = tools.active_window();
+    if (!window) {
+        return miral::Window();
+    }
+
+    auto &windowInfo = tools.info_for(window);
+    if (windowInfo.state() != mir_window_state_fullscreen) {
+        return miral::Window();
+    }
+
+    auto extraWinInfo = getExtraInfo(windowInfo);
+    QMutexLocker locker(&extraWinInfo->mutex);
+    if (!extraWinInfo->directInputArea.isValid()) {
+        return miral::Window();
+    }
+    *area = extraWinInfo->directInputArea;
+
+    return window;
+}
+
 void WindowManagementPolicy::requestState(const miral::Window &window, const Mir::State state)
 {
     auto &windowInfo = tools.info_for(window);
@@ -27,6 +27,8 @@
 
 #include <QScopedPointer>
 
+#include <atomic>
+
 using namespace mir::geometry;
 
 class WindowManagementPolicy : public miral::CanonicalWindowManagerPolicy
@@ -100,9 +102,11 @@ public:
 
     void set_window_confinement_regions(const QVector<QRect> &regions);
     void set_window_margins(MirWindowType windowType, const QMargins &margins);
+    void set_direct_input_allowed(bool allowed);
 
 private:
     void ensureWindowIsActive(const miral::Window &window);
+    miral::Window directInputWindow(QRect *area) const;
     QRect getConfinementRect(const QRect rect) const;
 
     qtmir::WindowModelNotifier &m_windowModel;
@@ -111,6 +115,11 @@ private:
     QtEventFeeder m_eventFeeder;
     QVector<QRect> m_confinementRegions;
     QMargins m_windowMargins[mir_window_types];
+
+    std::atomic<bool> m_directInputAllowed{false};
+    // Window getting the current touch sequence directly, if any, and where it's drawn
+    miral::Window m_directTouchWindow;
+    QRect m_directTouchArea;
 };
 
 #endif // WINDOWMANAGEMENTPOLICY_H
@@ -54,7 +54,7 @@ Mir::Type FakeMirSurface::type() const { return Mir::NormalType; }
 
 QString FakeMirSurface::name() const { return QString("Fake MirSurface"); }
 
-QString FakeMirSurface::persistentId() const { return QString("FakeSurfaceId"); }
+QString FakeMirSurface::persistentId() const { return m_persistentId; }
 
 QSize FakeMirSurface::size() const { return m_size; }
 
@@ -237,4 +237,12 @@ void FakeMirSurface::setSession(SessionInterface *session)
     m_session = session;
 }
 
+void FakeMirSurface::setActiveFocus(bool activeFocus)
+{
+    if (m_activeFocus != activeFocus) {
+        m_activeFocus = activeFocus;
+        Q_EMIT activeFocusChanged(m_activeFocus);
+    }
+}
+
 } // namespace qtmir
@@ -104,6 +104,8 @@ public:
     void startFrameDropper() override;
     void setLive(bool value) override;
     void setViewExposure(qintptr viewId, bool visible) override;
+    void setViewMaxFrameRate(qintptr, qreal) override {}
+    void setViewInputArea(qintptr, const QRect &) override {}
     bool isBeingDisplayed() const override;
     void registerView(qintptr viewId) override;
     void unregisterView(qintptr viewId) override;
@@ -119,7 +121,7 @@ public:
     void setFocused(bool focus) override;
 
     void setViewActiveFocus(qintptr, bool) override {}
-    bool activeFocus() const override { return false; }
+    bool activeFocus() const override { return m_activeFocus; }
 
     void mousePressEvent(QMouseEvent *) override;
     void mouseMoveEvent(QMouseEvent *) override;
@@ -166,6 +168,9 @@ public:
 
     void setSession(SessionInterface *session);
 
+    void setPersistentId(const QString &persistentId) { m_persistentId = persistentId; }
+    void setActiveFocus(bool activeFocus);
+
 private:
     void updateVisibility();
 
@@ -183,6 +188,8 @@ private:
     QList<TouchEvent> m_touchesReceived;
 
     SessionInterface *m_session{nullptr};
+    QString m_persistentId{QStringLiteral("FakeSurfaceId")};
+    bool m_activeFocus{false};
 };
 
 } // namespace qtmir
@@ -31,6 +31,8 @@ FakeSession::FakeSession()
 FakeSession::~FakeSession()
 {
     delete m_childSessions;
+
+    Q_EMIT destroyed(this); // Early warning, like Session does, while surfaceList() can still be accessed
 }
 
 QString FakeSession::name() const { return QString("foo-session"); }
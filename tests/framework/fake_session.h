@@ -46,6 +46,7 @@ public:
     // For MirSurfaceItem and MirSurfaceManager use
 
     void registerSurface(MirSurfaceInterface*) override;
+    QSharedPointer<PressedKeyTable> pressedKeyTable() const override { return {}; }
 
     // For Application use
 
@@ -61,7 +62,7 @@ public:
 
     bool activeFocus() const override { return false; }
 
-    pid_t pid() const override { return 0; }
+    pid_t pid() const override { return m_pid; }
 
     // For SessionManager use
 
@@ -82,6 +83,7 @@ public:
 
     void setState(State state);
     void setSession(std::shared_ptr<mir::scene::Session> session);
+    void setPid(pid_t pid) { m_pid = pid; }
 
 private:
     unity::shell::application::ApplicationInfoInterface* m_application;
@@ -90,6 +92,7 @@ private:
     MirSurfaceListModel m_surfaceList;
     MirSurfaceListModel m_promptSurfaceList;
     SessionModel *m_childSessions{new SessionModel};
+    pid_t m_pid{0};
 };
 
 } // namespace qtmi
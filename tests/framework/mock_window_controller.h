@@ -41,6 +41,7 @@ public:
 
     MOCK_METHOD1(setWindowConfinementRegions, void(const QVector<QRect> &regions));
     MOCK_METHOD2(setWindowMargins, void(Mir::Type windowType, const QMargins &margins));
+    MOCK_METHOD1(setDirectInputAllowed, void(bool allowed));
 };
 
 #endif // MOCK_WINDOW_CONTROLLER_H
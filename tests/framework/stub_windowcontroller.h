@@ -40,6 +40,7 @@ struct StubWindowModelController : public WindowControllerInterface
 
     void setWindowConfinementRegions(const QVector<QRect> &/*regions*/) override { return; }
     void setWindowMargins(Mir::Type /*windowType*/, const QMargins &/*margins*/) override { return; }
+    void setDirectInputAllowed(bool /*allowed*/) override { return; }
 };
 
 } //namespace qtmir
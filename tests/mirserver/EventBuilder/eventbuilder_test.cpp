@@ -156,3 +156,98 @@ TEST_F(EventBuilderTest, ReconstructDeviceId)
     auto input_event = mir_event_get_input_event(newMirEvent.get());
     EXPECT_EQ(deviceId, mir_input_event_get_device_id(input_event));
 }
+
+/*
+ Events already dispatched straight to their client must be recognizable as such, so that the copy given
+ to the shell doesn't reach the client a second time
+ */
+TEST_F(EventBuilderTest, RememberEventsDeliveredToClient)
+{
+    QScopedPointer<EventBuilder> eventBuilder(new EventBuilder);
+
+    ulong qtTimestamp = 12345;
+
+    {
+        mir::EventUPtr mirEvent = mir::events::make_event(0 /*DeviceID */, std::chrono::nanoseconds(111)/*timestamp*/,
+                std::vector<uint8_t>{}/*cookie*/, mir_keyboard_action_down, 70, 50,
+                mir_input_event_modifier_none);
+        eventBuilder->store(mir_event_get_input_event(mirEvent.get()), qtTimestamp, true /*deliveredToClient*/);
+    }
+    {
+        mir::EventUPtr mirEvent = mir::events::make_event(0 /*DeviceID */, std::chrono::nanoseconds(222)/*timestamp*/,
+                std::vector<uint8_t>{}/*cookie*/, mir_keyboard_action_up, 70, 50,
+                mir_input_event_modifier_none);
+        eventBuilder->store(mir_event_get_input_event(mirEvent.get()), qtTimestamp + 10);
+    }
+
+    ASSERT_NE(nullptr, eventBuilder->findInfo(qtTimestamp));
+    EXPECT_TRUE(eventBuilder->findInfo(qtTimestamp)->deliveredToClient);
+    ASSERT_NE(nullptr, eventBuilder->findInfo(qtTimestamp + 10));
+    EXPECT_FALSE(eventBuilder->findInfo(qtTimestamp + 10)->deliveredToClient);
+}
+
+TEST_F(EventBuilderTest, ReconstructMergedPointerMotion)
+{
+    QScopedPointer<EventBuilder> eventBuilder(new EventBuilder);
+
+    ulong qtTimestamp = 12345;
+
+    // The latest of a few Mir events merged together
+    {
+        mir::EventUPtr mirEvent = mir::events::make_event(0 /*DeviceID */, std::chrono::nanoseconds(111)/*timestamp*/,
+                std::vector<uint8_t>{} /* cookie */, mir_input_event_modifier_none, mir_pointer_action_motion, 0 /*buttons*/,
+                0 /*x*/, 0 /*y*/, 0 /*hscroll*/, 0 /*vscroll*/, 1.0 /*relativeX*/, 1.0 /*relativeY*/);
+
+        eventBuilder->store(mir_event_get_input_event(mirEvent.get()), qtTimestamp);
+    }
+
+    eventBuilder->storeMergedMotion(qtTimestamp, QPointF(5.5, -3.0));
+
+    QPointF relativeMotion;
+    ASSERT_TRUE(eventBuilder->relativeMotion(qtTimestamp, &relativeMotion));
+    EXPECT_EQ(QPointF(5.5, -3.0), relativeMotion);
+
+    QMouseEvent mouseEvent(QEvent::MouseMove, QPointF(0,0) /*localPos*/, Qt::NoButton, Qt::NoButton, Qt::NoModifier);
+    mouseEvent.setTimestamp(qtTimestamp);
+
+    mir::EventUPtr newMirEvent = eventBuilder->reconstructMirEvent(&mouseEvent);
+
+    // The reconstructed event carries the merged motion, not the one of the latest Mir event
+    const MirPointerEvent *newMirPointerEvent = mir_input_event_get_pointer_event(mir_event_get_input_event(newMirEvent.get()));
+    EXPECT_EQ(5.5f, mir_pointer_event_axis_value(newMirPointerEvent, mir_pointer_axis_relative_x));
+    EXPECT_EQ(-3.0f, mir_pointer_event_axis_value(newMirPointerEvent, mir_pointer_axis_relative_y));
+
+    // Nothing is known about events which were never stored
+    EXPECT_FALSE(eventBuilder->relativeMotion(qtTimestamp + 10, &relativeMotion));
+}
+
+/*
+ Events that share their qtTimestamp with another one can't be told apart, so a unique lookup gives none of them
+ */
+TEST_F(EventBuilderTest, UniqueLookupRefusesAmbiguousTimestamps)
+{
+    QScopedPointer<EventBuilder> eventBuilder(new EventBuilder);
+
+    ulong qtTimestamp = 12345;
+
+    for (MirInputDeviceId deviceId : {MirInputDeviceId(1), MirInputDeviceId(2)}) {
+        mir::EventUPtr mirEvent = mir::events::make_event(deviceId, std::chrono::nanoseconds(111)/*timestamp*/,
+                std::vector<uint8_t>{}/*cookie*/, mir_keyboard_action_down, 70, 50,
+                mir_input_event_modifier_none);
+        eventBuilder->store(mir_event_get_input_event(mirEvent.get()), qtTimestamp);
+    }
+    {
+        mir::EventUPtr mirEvent = mir::events::make_event(3 /*DeviceID */, std::chrono::nanoseconds(222)/*timestamp*/,
+                std::vector<uint8_t>{}/*cookie*/, mir_keyboard_action_up, 70, 50,
+                mir_input_event_modifier_none);
+        eventBuilder->store(mir_event_get_input_event(mirEvent.get()), qtTimestamp + 10);
+    }
+
+    EXPECT_NE(nullptr, eventBuilder->findInfo(qtTimestamp));
+    EXPECT_EQ(nullptr, eventBuilder->findUniqueInfo(qtTimestamp));
+
+    ASSERT_NE(nullptr, eventBuilder->findUniqueInfo(qtTimestamp + 10));
+    EXPECT_EQ(3, eventBuilder->findUniqueInfo(qtTimestamp + 10)->deviceId);
+
+    EXPECT_EQ(nullptr, eventBuilder->findUniqueInfo(qtTimestamp + 20));
+}
@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <framebufferpool.h>
+
+#include <QList>
+#include <QScopedPointer>
+
+using namespace qtmir;
+
+// Stands in for GL, the pool never looks inside its buffers
+class FramebufferPoolTest : public ::testing::Test
+{
+public:
+    FramebufferPool *createPool(qint64 budgetBytes)
+    {
+        pool.reset(new FramebufferPool(budgetBytes,
+            [this](const QSize &size) {
+                createdSizes.append(size);
+                return reinterpret_cast<QOpenGLFramebufferObject*>(quintptr(createdSizes.count()));
+            },
+            [this](QOpenGLFramebufferObject *buffer) {
+                destroyed.append(buffer);
+            }));
+        return pool.data();
+    }
+
+    static qint64 bytes(int width, int height) { return FramebufferPool::bytesFor(QSize(width, height)); }
+
+    QList<QSize> createdSizes;
+    QList<QOpenGLFramebufferObject*> destroyed;
+    QScopedPointer<FramebufferPool> pool; // last, as it destroys its free buffers when going away
+};
+
+TEST_F(FramebufferPoolTest, BuffersHaveTheExactSize)
+{
+    createPool(bytes(2048, 2048));
+
+    pool->acquire(QSize(1080, 1920));
+    pool->acquire(QSize(1, 64));
+
+    EXPECT_EQ(QList<QSize>() << QSize(1080, 1920) << QSize(1, 64), createdSizes);
+    EXPECT_EQ(bytes(1080, 1920) + bytes(1, 64), pool->allocatedBytes());
+}
+
+TEST_F(FramebufferPoolTest, ReleasedBuffersGetReusedForTheSameSize)
+{
+    createPool(bytes(1024, 1024));
+
+    auto buffer = pool->acquire(QSize(100, 100));
+    pool->release(buffer);
+
+    EXPECT_EQ(buffer, pool->acquire(QSize(100, 100)));
+    EXPECT_EQ(1, createdSizes.count());
+}
+
+TEST_F(FramebufferPoolTest, BuffersInUseArentShared)
+{
+    createPool(bytes(1024, 1024));
+
+    auto first = pool->acquire(QSize(100, 100));
+    auto second = pool->acquire(QSize(100, 100));
+
+    EXPECT_NE(first, second);
+    EXPECT_EQ(2, createdSizes.count());
+}
+
+TEST_F(FramebufferPoolTest, OtherSizesGetANewBuffer)
+{
+    createPool(bytes(1024, 1024));
+
+    auto buffer = pool->acquire(QSize(100, 100));
+    pool->release(buffer);
+
+    EXPECT_NE(buffer, pool->acquire(QSize(101, 100)));
+    EXPECT_EQ(1, pool->freeCount());
+}
+
+TEST_F(FramebufferPoolTest, Fits)
+{
+    createPool(bytes(1024, 1024));
+
+    auto buffer = pool->acquire(QSize(100, 100));
+
+    EXPECT_TRUE(pool->fits(buffer, QSize(100, 100)));
+    EXPECT_FALSE(pool->fits(buffer, QSize(100, 99)));
+
+    pool->release(buffer);
+    EXPECT_FALSE(pool->fits(buffer, QSize(100, 100)));
+}
+
+TEST_F(FramebufferPoolTest, EvictsLeastRecentlyReleasedOverBudget)
+{
+    createPool(bytes(128, 128) * 2);
+
+    auto first = pool->acquire(QSize(128, 128));
+    auto second = pool->acquire(QSize(128, 128));
+    pool->release(first);
+    pool->release(second);
+    ASSERT_TRUE(destroyed.isEmpty());
+
+    pool->acquire(QSize(64, 64));
+
+    EXPECT_EQ(QList<QOpenGLFramebufferObject*>() << first, destroyed);
+    EXPECT_EQ(bytes(128, 128) + bytes(64, 64), pool->allocatedBytes());
+}
+
+TEST_F(FramebufferPoolTest, NeverEvictsBuffersInUse)
+{
+    createPool(bytes(64, 64));
+
+    auto first = pool->acquire(QSize(640, 480));
+    auto second = pool->acquire(QSize(640, 480));
+
+    EXPECT_TRUE(destroyed.isEmpty());
+
+    pool->release(first);
+    pool->trim();
+    EXPECT_EQ(QList<QOpenGLFramebufferObject*>() << first, destroyed);
+    EXPECT_TRUE(pool->fits(second, QSize(640, 480)));
+}
+
+// Releasing may happen with any context current, so deleting waits for the pool's own
+TEST_F(FramebufferPoolTest, ReleasingNeverDeletes)
+{
+    createPool(bytes(64, 64));
+
+    auto buffer = pool->acquire(QSize(640, 480));
+    pool->release(buffer);
+
+    EXPECT_TRUE(destroyed.isEmpty());
+    EXPECT_EQ(1, pool->freeCount());
+
+    pool->trim();
+
+    EXPECT_EQ(QList<QOpenGLFramebufferObject*>() << buffer, destroyed);
+    EXPECT_EQ(0, pool->allocatedBytes());
+}
+
+TEST_F(FramebufferPoolTest, DestroysFreeBuffersWithThePool)
+{
+    createPool(bytes(1024, 1024));
+
+    auto buffer = pool->acquire(QSize(100, 100));
+    pool->acquire(QSize(100, 100));
+    pool->release(buffer);
+
+    pool.reset();
+
+    EXPECT_EQ(QList<QOpenGLFramebufferObject*>() << buffer, destroyed);
+}
@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <hardwarecursor.h>
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+
+using namespace qtmir;
+using namespace testing;
+
+namespace mg = mir::graphics;
+
+namespace {
+
+class MockCursor : public mg::Cursor
+{
+public:
+    MOCK_METHOD0(show, void());
+    MOCK_METHOD1(show, void(mg::CursorImage const&));
+    MOCK_METHOD0(hide, void());
+    MOCK_METHOD1(move_to, void(mir::geometry::Point));
+};
+
+std::shared_ptr<mg::CursorImage> anImage()
+{
+    QImage image(2, 2, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::red);
+    return std::make_shared<ImageCursor>(image, QPoint(1, 1));
+}
+
+// Writes a single image Xcursor file
+void writeXcursor(const QString &path, int nominalSize, int width, int height, QPoint hotspot, quint32 pixel)
+{
+    const quint32 imageType = 0xfffd0002;
+    const quint32 fileHeaderSize = 16;
+    const quint32 tocEntrySize = 12;
+    const quint32 imageHeaderSize = 36;
+
+    QFile file(path);
+    ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+    QDataStream stream(&file);
+    stream.setByteOrder(QDataStream::LittleEndian);
+
+    stream << quint32(0x72756358) // "Xcur"
+           << fileHeaderSize << quint32(0x10000) << quint32(1);
+    stream << imageType << quint32(nominalSize) << quint32(fileHeaderSize + tocEntrySize);
+    stream << imageHeaderSize << imageType << quint32(nominalSize) << quint32(1)
+           << quint32(width) << quint32(height) << quint32(hotspot.x()) << quint32(hotspot.y()) << quint32(0);
+    for (int i = 0; i < width * height; ++i) {
+        stream << pixel;
+    }
+}
+
+} // namespace
+
+TEST(HardwareCursorWrapperTest, hidesMirsCursorUntilItHasAnImage)
+{
+    auto mirCursor = std::make_shared<NiceMock<MockCursor>>();
+    EXPECT_CALL(*mirCursor, hide()).Times(AtLeast(1));
+    EXPECT_CALL(*mirCursor, show(_)).Times(0);
+
+    HardwareCursorWrapper wrapper(mirCursor);
+    wrapper.show();
+}
+
+TEST(HardwareCursorWrapperTest, showsItsImageWhenMirShowsTheCursor)
+{
+    auto mirCursor = std::make_shared<NiceMock<MockCursor>>();
+    auto image = anImage();
+    HardwareCursorWrapper wrapper(mirCursor);
+
+    wrapper.setImage(image);
+
+    // Whatever image Mir asks for, it's the one from setImage() that is shown
+    EXPECT_CALL(*mirCursor, show(Ref(*image))).Times(1);
+    wrapper.show(*anImage());
+}
+
+TEST(HardwareCursorWrapperTest, newImagesShowRightAwayWhileVisible)
+{
+    auto mirCursor = std::make_shared<NiceMock<MockCursor>>();
+    HardwareCursorWrapper wrapper(mirCursor);
+    wrapper.show();
+
+    auto image = anImage();
+    EXPECT_CALL(*mirCursor, show(Ref(*image))).Times(1);
+    wrapper.setImage(image);
+}
+
+TEST(HardwareCursorWrapperTest, aNullImageHidesTheCursor)
+{
+    auto mirCursor = std::make_shared<NiceMock<MockCursor>>();
+    HardwareCursorWrapper wrapper(mirCursor);
+    wrapper.setImage(anImage());
+    wrapper.show();
+
+    EXPECT_CALL(*mirCursor, show(_)).Times(0);
+    EXPECT_CALL(*mirCursor, hide()).Times(1);
+    wrapper.setImage(nullptr);
+}
+
+TEST(HardwareCursorWrapperTest, hidingWins)
+{
+    auto mirCursor = std::make_shared<NiceMock<MockCursor>>();
+    HardwareCursorWrapper wrapper(mirCursor);
+    wrapper.show();
+    wrapper.hide();
+
+    EXPECT_CALL(*mirCursor, show(_)).Times(0);
+    wrapper.setImage(anImage());
+}
+
+TEST(HardwareCursorWrapperTest, passesMovesOn)
+{
+    auto mirCursor = std::make_shared<NiceMock<MockCursor>>();
+    HardwareCursorWrapper wrapper(mirCursor);
+
+    EXPECT_CALL(*mirCursor, move_to(mir::geometry::Point{10, 20})).Times(1);
+    wrapper.move_to({10, 20});
+}
+
+class XcursorThemeTest : public ::testing::Test
+{
+public:
+    // libXcursor reads XCURSOR_PATH only once, so all tests share the same theme directory
+    static void SetUpTestCase()
+    {
+        themesDir = new QTemporaryDir;
+        ASSERT_TRUE(QDir(themesDir->path()).mkpath("test-theme/cursors"));
+        qputenv("XCURSOR_PATH", themesDir->path().toLocal8Bit());
+
+        writeXcursor(themesDir->path() + "/test-theme/cursors/left_ptr", 24, 3, 2, QPoint(1, 2), 0xff0000ff);
+    }
+
+    static void TearDownTestCase()
+    {
+        delete themesDir;
+        themesDir = nullptr;
+    }
+
+    static QTemporaryDir *themesDir;
+};
+
+QTemporaryDir *XcursorThemeTest::themesDir = nullptr;
+
+TEST_F(XcursorThemeTest, loadsTheImageOfANamedCursor)
+{
+    auto image = loadThemeCursorImage("left_ptr", "test-theme", 24);
+
+    ASSERT_NE(nullptr, image);
+    EXPECT_EQ(mir::geometry::Size(3, 2), image->size());
+    EXPECT_EQ(mir::geometry::Displacement(1, 2), image->hotspot());
+
+    auto pixels = static_cast<const quint32*>(image->as_argb_8888());
+    for (int i = 0; i < 3 * 2; ++i) {
+        EXPECT_EQ(0xff0000ffu, pixels[i]) << "pixel " << i;
+    }
+}
+
+TEST_F(XcursorThemeTest, noImageForACursorTheThemeHasnt)
+{
+    EXPECT_EQ(nullptr, loadThemeCursorImage("no_such_cursor", "test-theme", 24));
+}
+
+TEST_F(XcursorThemeTest, noImageFromAThemeThatDoesntExist)
+{
+    EXPECT_EQ(nullptr, loadThemeCursorImage("left_ptr", "no-such-theme", 24));
+}
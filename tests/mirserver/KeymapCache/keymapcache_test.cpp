@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <keymapcache.h>
+
+#include <QCoreApplication>
+#include <QSemaphore>
+#include <QStringList>
+#include <QThread>
+
+using namespace qtmir;
+
+class KeymapCacheTest : public ::testing::Test
+{
+public:
+    KeymapCacheTest()
+        : qtApp(argc, argv)
+    {
+    }
+
+    int argc{0};
+    char **argv{nullptr};
+    QCoreApplication qtApp;
+};
+
+TEST_F(KeymapCacheTest, parsesLayoutPlusVariant)
+{
+    KeymapNames names = KeymapNames::fromLayoutString(QStringLiteral("fr+bepo"));
+    EXPECT_EQ("fr", names.layout);
+    EXPECT_EQ("bepo", names.variant);
+    EXPECT_EQ("", names.model);
+    EXPECT_EQ("", names.options);
+
+    names = KeymapNames::fromLayoutString(QStringLiteral("us"));
+    EXPECT_EQ("us", names.layout);
+    EXPECT_EQ("", names.variant);
+}
+
+TEST_F(KeymapCacheTest, compilesEachKeymapOnce)
+{
+    auto cache = KeymapCache::instance();
+    const KeymapNames names = KeymapNames::fromLayoutString(QStringLiteral("us+dvorak"));
+
+    const bool compiles = cache->compile(names);
+    const int count = cache->compiledCount();
+
+    EXPECT_EQ(compiles, cache->compile(names));
+    EXPECT_EQ(count, cache->compiledCount());
+}
+
+TEST_F(KeymapCacheTest, onlyLatestRequestForATargetIsApplied)
+{
+    auto cache = KeymapCache::instance();
+    int blocker, target;
+
+    // Keep the cache thread busy while the requests for target pile up
+    QSemaphore blockerStarted, blockerRelease;
+    cache->apply(&blocker, KeymapNames::fromLayoutString(QStringLiteral("us")), [&](const KeymapNames &) {
+        blockerStarted.release();
+        blockerRelease.acquire();
+    });
+    ASSERT_TRUE(blockerStarted.tryAcquire(1, 5000));
+
+    QStringList applied;
+    QThread *applyThread = nullptr;
+    QSemaphore done;
+    auto record = [&](const KeymapNames &names) {
+        applied.append(QString::fromStdString(names.layout));
+        applyThread = QThread::currentThread();
+        done.release();
+    };
+    cache->apply(&target, KeymapNames::fromLayoutString(QStringLiteral("us")), record);
+    cache->apply(&target, KeymapNames::fromLayoutString(QStringLiteral("de")), record);
+
+    blockerRelease.release();
+    ASSERT_TRUE(done.tryAcquire(1, 5000));
+    cache->cancel(&target); // waits for the cache thread to be done with it
+
+    EXPECT_EQ(QStringList() << QStringLiteral("de"), applied);
+    EXPECT_NE(QThread::currentThread(), applyThread);
+}
+
+TEST_F(KeymapCacheTest, cancelledRequestIsNotApplied)
+{
+    auto cache = KeymapCache::instance();
+    int blocker, target;
+
+    QSemaphore blockerStarted, blockerRelease;
+    cache->apply(&blocker, KeymapNames::fromLayoutString(QStringLiteral("us")), [&](const KeymapNames &) {
+        blockerStarted.release();
+        blockerRelease.acquire();
+    });
+    ASSERT_TRUE(blockerStarted.tryAcquire(1, 5000));
+
+    bool applied = false;
+    cache->apply(&target, KeymapNames::fromLayoutString(QStringLiteral("us")), [&](const KeymapNames &) {
+        applied = true;
+    });
+    cache->apply(&blocker, KeymapNames::fromLayoutString(QStringLiteral("us")), [](const KeymapNames &) {});
+    cache->cancel(&target);
+
+    blockerRelease.release();
+    cache->cancel(&blocker);
+
+    EXPECT_FALSE(applied);
+}
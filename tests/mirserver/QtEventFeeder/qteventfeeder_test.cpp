@@ -18,9 +18,15 @@
 #include <gtest/gtest.h>
 
 #include <qteventfeeder.h>
+#include <inputlatencystats.h>
+#include <inputrecording.h>
 #include <debughelpers.h>
+#include <timestamp.h>
 
+#include <QElapsedTimer>
+#include <QFileInfo>
 #include <QGuiApplication>
+#include <QTemporaryDir>
 #include <QWindow>
 
 #include "mir/events/event_builders.h"
@@ -30,6 +36,8 @@
 #include <linux/input.h>
 #include <xkbcommon/xkbcommon-keysyms.h>
 
+#include <algorithm>
+
 using ::testing::_;
 using ::testing::AllOf;
 using ::testing::AnyNumber;
@@ -270,14 +278,17 @@ TEST_F(QtEventFeederTest, PressSameTouchTwice)
 
 TEST_F(QtEventFeederTest, TimestampInMilliseconds)
 {
+    // Relative to the first event where ulong can't hold the mir timestamp as is
+    const ulong base = qtmir::detail::HoldsNativeTimestamp<qtmir::Timestamp>::value ? 123 : 0;
+
     setIrrelevantMockWindowSystemExpectations();
-    EXPECT_CALL(*mockWindowSystem, handleTouchEvent(_,0,_,_,_)).Times(1);
+    EXPECT_CALL(*mockWindowSystem, handleTouchEvent(_,base,_,_,_)).Times(1);
     auto ev1 = mev::make_event(MirInputDeviceId(), std::chrono::milliseconds(123), std::vector<uint8_t>{} /* cookie */, 0);
     qtEventFeeder->dispatch(*ev1);
     ASSERT_TRUE(Mock::VerifyAndClearExpectations(mockWindowSystem));
 
     setIrrelevantMockWindowSystemExpectations();
-    EXPECT_CALL(*mockWindowSystem, handleTouchEvent(_,2,_,_,_)).Times(1);
+    EXPECT_CALL(*mockWindowSystem, handleTouchEvent(_,base + 2,_,_,_)).Times(1);
     auto ev2 = mev::make_event(MirInputDeviceId(), std::chrono::milliseconds(125), std::vector<uint8_t>{} /* cookie */, 0);
     qtEventFeeder->dispatch(*ev2);
     ASSERT_TRUE(Mock::VerifyAndClearExpectations(mockWindowSystem));
@@ -321,3 +332,183 @@ TEST_F(QtEventFeederTest, composeKeysNotFilteredOut)
     dispatch_key_event(up, KEY_RIGHTSHIFT, XKB_KEY_Shift_R);
     dispatch_key_event(down, KEY_U, XKB_KEY_udiaeresis);
 }
+
+TEST_F(QtEventFeederTest, ReplayRecordedEvents)
+{
+    setIrrelevantMockWindowSystemExpectations();
+
+    QTemporaryDir dir;
+    const QString recordingPath = dir.filePath(QStringLiteral("input.rec"));
+    {
+        qtmir::InputRecorder recorder(recordingPath);
+        ASSERT_TRUE(recorder.isOpen());
+
+        auto ev1 = mev::make_event(MirInputDeviceId(3), std::chrono::milliseconds(123), std::vector<uint8_t>{} /* cookie */, 0);
+        mev::add_touch(*ev1, 0 /* touch ID */, mir_touch_action_down, mir_touch_tooltype_finger,
+                       10, 10, 10 /* x, y, pressure */,
+                       1, 1, 10 /* touch major, minor, size */);
+        recorder.record(mir_event_get_input_event(ev1.get()));
+
+        auto ev2 = mev::make_event(MirInputDeviceId(3), std::chrono::milliseconds(125), std::vector<uint8_t>{} /* cookie */, 0);
+        mev::add_touch(*ev2, 0 /* touch ID */, mir_touch_action_up, mir_touch_tooltype_finger,
+                       20, 20, 10 /* x, y, pressure */,
+                       1, 1, 10 /* touch major, minor, size */);
+        recorder.record(mir_event_get_input_event(ev2.get()));
+
+        auto ev3 = mev::make_event(MirInputDeviceId(4), std::chrono::milliseconds(130), std::vector<uint8_t>{},
+                mir_keyboard_action_down, XKB_KEY_a, KEY_A, mir_input_event_modifier_none);
+        recorder.record(mir_event_get_input_event(ev3.get()));
+    }
+
+    qtmir::InputReplayer replayer(recordingPath);
+    ASSERT_TRUE(replayer.isValid());
+    ASSERT_EQ(3, replayer.eventCount());
+
+    InSequence seq;
+    EXPECT_CALL(*mockWindowSystem, handleTouchEvent(_,_,_,AllOf(SizeIs(1),
+                                                              Contains(AllOf(HasId(0),
+                                                                             IsPressed()))),_)).Times(1);
+    EXPECT_CALL(*mockWindowSystem, handleTouchEvent(_,_,_,AllOf(SizeIs(1),
+                                                              Contains(AllOf(HasId(0),
+                                                                             IsReleased()))),_)).Times(1);
+    EXPECT_CALL(*mockWindowSystem,
+                handleExtendedKeyEvent(_, _, QEvent::KeyPress, _, _, KEY_A, XKB_KEY_a, _, _, _)).Times(1);
+
+    replayer.replay(qtEventFeeder, qtmir::InputReplayer::MaximumSpeed);
+}
+
+TEST_F(QtEventFeederTest, ReplayKeepsRecordedIntervalsAtOriginalSpeed)
+{
+    setIrrelevantMockWindowSystemExpectations();
+    EXPECT_CALL(*mockWindowSystem, handleTouchEvent(_,_,_,_,_)).Times(2);
+
+    QTemporaryDir dir;
+    const QString recordingPath = dir.filePath(QStringLiteral("input.rec"));
+    {
+        qtmir::InputRecorder recorder(recordingPath);
+
+        auto ev1 = mev::make_event(MirInputDeviceId(), std::chrono::milliseconds(100), std::vector<uint8_t>{}, 0);
+        mev::add_touch(*ev1, 0, mir_touch_action_down, mir_touch_tooltype_finger, 10, 10, 10, 1, 1, 10);
+        recorder.record(mir_event_get_input_event(ev1.get()));
+
+        auto ev2 = mev::make_event(MirInputDeviceId(), std::chrono::milliseconds(150), std::vector<uint8_t>{}, 0);
+        mev::add_touch(*ev2, 0, mir_touch_action_up, mir_touch_tooltype_finger, 10, 10, 10, 1, 1, 10);
+        recorder.record(mir_event_get_input_event(ev2.get()));
+    }
+
+    qtmir::InputReplayer replayer(recordingPath);
+
+    QElapsedTimer timer;
+    timer.start();
+    replayer.replay(qtEventFeeder, qtmir::InputReplayer::OriginalSpeed);
+
+    EXPECT_GE(timer.elapsed(), 50);
+}
+
+TEST_F(QtEventFeederTest, RecordingIsReadableByItsOwnerOnly)
+{
+    QTemporaryDir dir;
+    const QString recordingPath = dir.filePath(QStringLiteral("input.rec"));
+
+    // Even if it was there already, with looser permissions
+    {
+        QFile file(recordingPath);
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+        ASSERT_TRUE(file.setPermissions(file.permissions() | QFileDevice::ReadOther | QFileDevice::ReadGroup));
+    }
+
+    qtmir::InputRecorder recorder(recordingPath);
+    ASSERT_TRUE(recorder.isOpen());
+
+    const QFileDevice::Permissions ownerGroupOther = QFileDevice::ReadOwner | QFileDevice::WriteOwner | QFileDevice::ExeOwner
+            | QFileDevice::ReadGroup | QFileDevice::WriteGroup | QFileDevice::ExeGroup
+            | QFileDevice::ReadOther | QFileDevice::WriteOther | QFileDevice::ExeOther;
+    EXPECT_EQ(QFileDevice::ReadOwner | QFileDevice::WriteOwner, QFileInfo(recordingPath).permissions() & ownerGroupOther);
+}
+
+/*
+   Input throughput benchmark: replays a long touch drag at maximum speed.
+   Set QTMIR_INPUT_RECORDING_BENCHMARK to the path of a recording to replay that instead.
+ */
+TEST_F(QtEventFeederTest, ReplayThroughput)
+{
+    QTemporaryDir dir;
+    QString recordingPath = QString::fromLocal8Bit(qgetenv("QTMIR_INPUT_RECORDING_BENCHMARK"));
+    const bool synthetic = recordingPath.isEmpty();
+    const int moves = 10000;
+
+    setIrrelevantMockWindowSystemExpectations();
+    if (synthetic) {
+        EXPECT_CALL(*mockWindowSystem, handleTouchEvent(_,_,_,_,_)).Times(moves + 2);
+    } else {
+        EXPECT_CALL(*mockWindowSystem, handleTouchEvent(_,_,_,_,_)).Times(AnyNumber());
+    }
+    EXPECT_CALL(*mockWindowSystem, handleExtendedKeyEvent(_,_,_,_,_,_,_,_,_,_)).Times(AnyNumber());
+    EXPECT_CALL(*mockWindowSystem, handleMouseEvent(_,_,_,_,_)).Times(AnyNumber());
+    EXPECT_CALL(*mockWindowSystem, handleWheelEvent(_,_,_,_)).Times(AnyNumber());
+
+    if (synthetic) {
+        recordingPath = dir.filePath(QStringLiteral("input.rec"));
+        qtmir::InputRecorder recorder(recordingPath);
+
+        for (int i = 0; i <= moves + 1; ++i) {
+            auto action = i == 0 ? mir_touch_action_down : (i > moves ? mir_touch_action_up : mir_touch_action_change);
+            auto ev = mev::make_event(MirInputDeviceId(), std::chrono::milliseconds(100 + i * 8), std::vector<uint8_t>{}, 0);
+            mev::add_touch(*ev, 0, action, mir_touch_tooltype_finger, i % 500, i % 300, 10, 1, 1, 10);
+            recorder.record(mir_event_get_input_event(ev.get()));
+        }
+    }
+
+    qtmir::InputReplayer replayer(recordingPath);
+    ASSERT_TRUE(replayer.isValid());
+    if (synthetic) {
+        ASSERT_EQ(moves + 2, replayer.eventCount());
+    } else {
+        ASSERT_GT(replayer.eventCount(), 0);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    replayer.replay(qtEventFeeder, qtmir::InputReplayer::MaximumSpeed);
+    const qint64 elapsedNs = std::max(timer.nsecsElapsed(), qint64(1));
+
+    RecordProperty("events", replayer.eventCount());
+    RecordProperty("eventsPerSecond", static_cast<int>(replayer.eventCount() * 1000000000LL / elapsedNs));
+}
+
+TEST_F(QtEventFeederTest, DispatchLatencyIsRecordedPerDevice)
+{
+    setIrrelevantMockWindowSystemExpectations();
+    EXPECT_CALL(*mockWindowSystem, handleExtendedKeyEvent(_,_,_,_,_,_,_,_,_,_)).Times(1);
+
+    auto stats = qtmir::InputLatencyStats::instance();
+    stats->reset();
+
+    const auto eventTime = std::chrono::steady_clock::now().time_since_epoch() - std::chrono::milliseconds(5);
+    qtEventFeeder->dispatch(*mev::make_event(MirInputDeviceId{42}, eventTime, std::vector<uint8_t>{},
+            mir_keyboard_action_down, XKB_KEY_a, KEY_A, mir_input_event_modifier_none));
+
+    const QVariantList snapshot = stats->snapshot();
+    ASSERT_EQ(1, snapshot.count());
+    const QVariantMap histogram = snapshot.first().toMap();
+    EXPECT_EQ(QStringLiteral("dispatch"), histogram[QStringLiteral("stage")].toString());
+    EXPECT_EQ(42, histogram[QStringLiteral("deviceId")].toLongLong());
+    EXPECT_EQ(1u, histogram[QStringLiteral("count")].toULongLong());
+    EXPECT_GE(histogram[QStringLiteral("maxUs")].toLongLong(), 5000);
+}
+
+TEST(InputLatencyHistogramTest, PercentilesFallInTheirBuckets)
+{
+    qtmir::InputLatencyStats::Histogram histogram;
+    for (int i = 0; i < 98; ++i) {
+        histogram.add(std::chrono::microseconds(100)); // bucket [64, 128)
+    }
+    histogram.add(std::chrono::microseconds(3000)); // bucket [2048, 4096)
+    histogram.add(std::chrono::microseconds(3000));
+
+    EXPECT_EQ(100u, histogram.count);
+    EXPECT_EQ(98u, histogram.buckets[6]);
+    EXPECT_EQ(2u, histogram.buckets[11]);
+    EXPECT_EQ(std::chrono::microseconds(128), histogram.percentile(50));
+    EXPECT_EQ(std::chrono::microseconds(3000), histogram.percentile(99)); // capped by the max seen
+}
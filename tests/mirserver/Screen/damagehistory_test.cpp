@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <damagetracker.h>
+
+using namespace qtmir;
+
+namespace {
+const QSize frameSize(3840, 2160);
+const QRect fullFrame(QPoint(0, 0), frameSize);
+}
+
+TEST(DamageHistoryTest, FirstFrameIsRepaintedInFull)
+{
+    DamageHistory history;
+    history.setFrameSize(frameSize);
+
+    EXPECT_EQ(fullFrame, history.repaintRect(1));
+}
+
+TEST(DamageHistoryTest, RepaintsOnlyWhatChangedSinceTheBufferWasPresented)
+{
+    DamageHistory history;
+    history.setFrameSize(frameSize);
+    history.frameSwapped();
+
+    // eg. a clock ticking
+    const QRect clock(3700, 0, 140, 40);
+    history.addDamage(clock);
+    EXPECT_EQ(clock, history.repaintRect(1));
+    history.frameSwapped();
+
+    const QRect cursorBlink(100, 100, 2, 20);
+    history.addDamage(cursorBlink);
+
+    // A double buffered back buffer holds the frame before the clock ticked
+    EXPECT_EQ(cursorBlink | clock, history.repaintRect(2));
+}
+
+TEST(DamageHistoryTest, UnknownOrTooOldBuffersAreRepaintedInFull)
+{
+    DamageHistory history(3);
+    history.setFrameSize(frameSize);
+    for (int i = 0; i < 5; ++i) {
+        history.frameSwapped();
+    }
+    history.addDamage(QRect(0, 0, 10, 10));
+
+    EXPECT_EQ(fullFrame, history.repaintRect(0));
+    EXPECT_EQ(QRect(0, 0, 10, 10), history.repaintRect(3));
+    EXPECT_EQ(fullFrame, history.repaintRect(4));
+}
+
+TEST(DamageHistoryTest, ResizeAndResetDamageEverything)
+{
+    DamageHistory history;
+    history.setFrameSize(frameSize);
+    history.frameSwapped();
+    history.frameSwapped();
+
+    history.reset();
+    EXPECT_EQ(fullFrame, history.repaintRect(1));
+    history.frameSwapped();
+    EXPECT_EQ(fullFrame, history.repaintRect(2));
+    history.frameSwapped();
+    EXPECT_EQ(QRect(), history.repaintRect(1));
+
+    history.setFrameSize(QSize(1920, 1080));
+    EXPECT_EQ(QRect(0, 0, 1920, 1080), history.repaintRect(1));
+}
+
+TEST(DamageHistoryTest, DamageIsClippedToTheFrame)
+{
+    DamageHistory history;
+    history.setFrameSize(QSize(100, 100));
+    history.frameSwapped();
+
+    history.addDamage(QRect(90, 90, 50, 50));
+    EXPECT_EQ(QRect(90, 90, 10, 10), history.repaintRect(1));
+}
@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <screenwindow.h>
+
+#include <QGuiApplication>
+#include <QQuickItem>
+#include <QQuickWindow>
+
+namespace {
+
+class DrawingItem : public QQuickItem
+{
+public:
+    explicit DrawingItem(QQuickItem *parent) : QQuickItem(parent) { setFlag(ItemHasContents); }
+};
+
+} // namespace
+
+class ScreenWindowTest : public ::testing::Test
+{
+public:
+    ScreenWindowTest()
+    {
+        setenv("QT_QPA_PLATFORM", "minimal", 1);
+        int argc = 0;
+        char **argv = nullptr;
+        app = new QGuiApplication(argc, argv);
+
+        window = new QQuickWindow;
+        window->resize(1000, 500);
+        // Not shown, so it doesn't get resized along with the window
+        window->contentItem()->setSize(QSizeF(1000, 500));
+    }
+    ~ScreenWindowTest()
+    {
+        delete window;
+        delete app;
+    }
+
+    template<typename Item = QQuickItem>
+    Item *createItem(const QRectF &rect, QQuickItem *parent = nullptr)
+    {
+        auto item = new Item(parent ? parent : window->contentItem());
+        item->setPosition(rect.topLeft());
+        item->setSize(rect.size());
+        return item;
+    }
+
+    bool isUnobstructedFullscreen(const QQuickItem *item) const
+    {
+        return ScreenWindow::isUnobstructedFullscreen(item, window);
+    }
+
+    const QRectF fullscreen{0, 0, 1000, 500};
+    QGuiApplication *app;
+    QQuickWindow *window;
+};
+
+TEST_F(ScreenWindowTest, FullscreenItemIsUnobstructed)
+{
+    auto item = createItem<DrawingItem>(fullscreen);
+
+    EXPECT_TRUE(isUnobstructedFullscreen(item));
+}
+
+TEST_F(ScreenWindowTest, ItemHasToCoverTheWholeWindow)
+{
+    auto smaller = createItem<DrawingItem>(QRectF(0, 0, 999, 500));
+    auto offset = createItem<DrawingItem>(QRectF(1, 0, 1000, 500));
+    auto larger = createItem<DrawingItem>(QRectF(0, 0, 1000, 501));
+
+    EXPECT_FALSE(isUnobstructedFullscreen(smaller));
+    EXPECT_FALSE(isUnobstructedFullscreen(offset));
+    EXPECT_FALSE(isUnobstructedFullscreen(larger));
+}
+
+TEST_F(ScreenWindowTest, ItemDrawnAfterItObstructsIt)
+{
+    auto item = createItem<DrawingItem>(fullscreen);
+    createItem<DrawingItem>(QRectF(10, 10, 10, 10));
+
+    EXPECT_FALSE(isUnobstructedFullscreen(item));
+}
+
+TEST_F(ScreenWindowTest, ItemDrawnBeforeItDoesNotObstructIt)
+{
+    createItem<DrawingItem>(QRectF(10, 10, 10, 10));
+    auto item = createItem<DrawingItem>(fullscreen);
+
+    EXPECT_TRUE(isUnobstructedFullscreen(item));
+}
+
+TEST_F(ScreenWindowTest, ItemsOnTopThatDrawNothingDoNotObstructIt)
+{
+    auto item = createItem<DrawingItem>(fullscreen);
+    createItem(fullscreen); // no contents of its own
+    createItem<DrawingItem>(fullscreen)->setVisible(false);
+    createItem<DrawingItem>(fullscreen)->setOpacity(0.0);
+
+    EXPECT_TRUE(isUnobstructedFullscreen(item));
+}
+
+TEST_F(ScreenWindowTest, DrawingDescendantOnTopObstructsIt)
+{
+    auto item = createItem<DrawingItem>(fullscreen);
+    auto container = createItem(fullscreen);
+    createItem<DrawingItem>(QRectF(10, 10, 10, 10), container);
+
+    EXPECT_FALSE(isUnobstructedFullscreen(item));
+}
+
+TEST_F(ScreenWindowTest, DrawingChildObstructsIt)
+{
+    auto item = createItem<DrawingItem>(fullscreen);
+    createItem<DrawingItem>(QRectF(10, 10, 10, 10), item);
+
+    EXPECT_FALSE(isUnobstructedFullscreen(item));
+}
+
+TEST_F(ScreenWindowTest, TranslucentOrTransformedAncestorDisqualifiesIt)
+{
+    auto parent = createItem(fullscreen);
+    auto item = createItem<DrawingItem>(fullscreen, parent);
+    ASSERT_TRUE(isUnobstructedFullscreen(item));
+
+    parent->setOpacity(0.5);
+    EXPECT_FALSE(isUnobstructedFullscreen(item));
+    parent->setOpacity(1.0);
+
+    parent->setRotation(180);
+    EXPECT_FALSE(isUnobstructedFullscreen(item));
+    parent->setRotation(0);
+
+    parent->setScale(1.5);
+    EXPECT_FALSE(isUnobstructedFullscreen(item));
+    parent->setScale(1.0);
+
+    EXPECT_TRUE(isUnobstructedFullscreen(item));
+}
+
+TEST_F(ScreenWindowTest, ClippingAncestorSmallerThanTheWindowDisqualifiesIt)
+{
+    auto parent = createItem(fullscreen);
+    auto item = createItem<DrawingItem>(fullscreen, parent);
+    parent->setClip(true);
+    ASSERT_TRUE(isUnobstructedFullscreen(item));
+
+    parent->setWidth(500);
+
+    EXPECT_FALSE(isUnobstructedFullscreen(item));
+}
+
+TEST_F(ScreenWindowTest, ItemHasToBeInTheWindow)
+{
+    QQuickWindow otherWindow;
+    otherWindow.resize(1000, 500);
+    otherWindow.contentItem()->setSize(QSizeF(1000, 500));
+    auto item = createItem<DrawingItem>(fullscreen, otherWindow.contentItem());
+
+    EXPECT_FALSE(isUnobstructedFullscreen(item));
+    EXPECT_FALSE(isUnobstructedFullscreen(nullptr));
+}
+
+TEST_F(ScreenWindowTest, InvisibleItemIsNotShown)
+{
+    auto item = createItem<DrawingItem>(fullscreen);
+    item->setVisible(false);
+
+    EXPECT_FALSE(isUnobstructedFullscreen(item));
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <shadercache.h>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+
+#include <utime.h>
+
+using namespace qtmir;
+
+class ShaderCacheTest : public ::testing::Test
+{
+public:
+    QString createFile(const QString &path, int size, time_t lastUsed)
+    {
+        const QString fileName = cacheRoot.path() + "/" + path;
+        QDir().mkpath(QFileInfo(fileName).path());
+
+        QFile file(fileName);
+        file.open(QIODevice::WriteOnly);
+        file.write(QByteArray(size, 'x'));
+        file.close();
+
+        struct utimbuf times;
+        times.actime = lastUsed;
+        times.modtime = lastUsed;
+        utime(qPrintable(fileName), &times);
+
+        return fileName;
+    }
+
+    QTemporaryDir cacheRoot;
+};
+
+TEST_F(ShaderCacheTest, FindsQtShaderCacheDirectories)
+{
+    createFile("qtshadercache/a", 10, 1000);
+    createFile("qtshadercache-arm-little_endian-ilp32-eabi-hardfloat/b", 10, 1000);
+    createFile("fontconfig/c", 10, 1000);
+
+    QStringList directories = ShaderCache::cacheDirectories(QStringList() << cacheRoot.path() << QString());
+    directories.sort();
+
+    ASSERT_EQ(2, directories.count());
+    EXPECT_EQ(cacheRoot.path() + "/qtshadercache", directories[0]);
+    EXPECT_EQ(cacheRoot.path() + "/qtshadercache-arm-little_endian-ilp32-eabi-hardfloat", directories[1]);
+}
+
+TEST_F(ShaderCacheTest, SameLocationTwiceListsDirectoriesOnce)
+{
+    createFile("qtshadercache/a", 10, 1000);
+
+    EXPECT_EQ(1, ShaderCache::cacheDirectories(QStringList() << cacheRoot.path() << cacheRoot.path()).count());
+}
+
+TEST_F(ShaderCacheTest, MostRecentlyUsedFilesFirst)
+{
+    const QString older = createFile("qtshadercache/older", 10, 1000);
+    const QString newest = createFile("qtshadercache-x/newest", 10, 3000);
+    const QString newer = createFile("qtshadercache/newer", 10, 2000);
+
+    const QStringList directories = ShaderCache::cacheDirectories(QStringList() << cacheRoot.path());
+
+    EXPECT_EQ(QStringList() << newest << newer << older, ShaderCache::filesToPrefetch(directories, 1000));
+}
+
+TEST_F(ShaderCacheTest, StaysWithinTheByteBudget)
+{
+    const QString newest = createFile("qtshadercache/newest", 60, 3000);
+    createFile("qtshadercache/big", 50, 2000);
+    const QString small = createFile("qtshadercache/small", 30, 1000);
+
+    const QStringList directories = ShaderCache::cacheDirectories(QStringList() << cacheRoot.path());
+
+    EXPECT_EQ(QStringList() << newest << small, ShaderCache::filesToPrefetch(directories, 100));
+}
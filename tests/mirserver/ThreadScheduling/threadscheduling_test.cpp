@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <threadscheduling.h>
+
+#include <QCoreApplication>
+#include <QScopedPointer>
+
+#include <thread>
+
+using namespace qtmir;
+
+using Policy = ThreadScheduling::Policy;
+
+TEST(ThreadSchedulingTest, ParsesRealTimeSchedulers)
+{
+    Policy policy;
+
+    ASSERT_TRUE(Policy::parseScheduler("fifo:10", &policy));
+    EXPECT_EQ(Policy::Fifo, policy.scheduler);
+    EXPECT_EQ(10, policy.priority);
+
+    ASSERT_TRUE(Policy::parseScheduler(" RR : 99 ", &policy));
+    EXPECT_EQ(Policy::RoundRobin, policy.scheduler);
+    EXPECT_EQ(99, policy.priority);
+}
+
+TEST(ThreadSchedulingTest, ParsesNiceValues)
+{
+    Policy policy;
+
+    ASSERT_TRUE(Policy::parseScheduler("nice:-5", &policy));
+    EXPECT_EQ(Policy::Nice, policy.scheduler);
+    EXPECT_EQ(-5, policy.priority);
+}
+
+TEST(ThreadSchedulingTest, RejectsInvalidSchedulers)
+{
+    Policy policy;
+
+    EXPECT_FALSE(Policy::parseScheduler("fifo", &policy));
+    EXPECT_FALSE(Policy::parseScheduler("fifo:0", &policy));
+    EXPECT_FALSE(Policy::parseScheduler("rr:100", &policy));
+    EXPECT_FALSE(Policy::parseScheduler("nice:-21", &policy));
+    EXPECT_FALSE(Policy::parseScheduler("batch:5", &policy));
+    EXPECT_FALSE(Policy::parseScheduler("fifo:high", &policy));
+    EXPECT_FALSE(Policy::parseScheduler("fifo:1:2", &policy));
+
+    EXPECT_TRUE(policy.isUnchanged());
+}
+
+TEST(ThreadSchedulingTest, ParsesCpuLists)
+{
+    Policy policy;
+
+    ASSERT_TRUE(Policy::parseCpus("4-7", &policy));
+    EXPECT_EQ(QVector<int>({4, 5, 6, 7}), policy.cpus);
+
+    ASSERT_TRUE(Policy::parseCpus("0, 2,4-5,5", &policy));
+    EXPECT_EQ(QVector<int>({0, 2, 4, 5}), policy.cpus);
+}
+
+TEST(ThreadSchedulingTest, RejectsInvalidCpuLists)
+{
+    Policy policy;
+
+    EXPECT_FALSE(Policy::parseCpus("", &policy));
+    EXPECT_FALSE(Policy::parseCpus("7-4", &policy));
+    EXPECT_FALSE(Policy::parseCpus("4-", &policy));
+    EXPECT_FALSE(Policy::parseCpus("1-2-3", &policy));
+    EXPECT_FALSE(Policy::parseCpus("-1", &policy));
+    EXPECT_FALSE(Policy::parseCpus("big", &policy));
+    EXPECT_FALSE(Policy::parseCpus("0,99999", &policy));
+
+    EXPECT_TRUE(policy.isUnchanged());
+}
+
+TEST(ThreadSchedulingTest, NoConfigurationLeavesThreadsAlone)
+{
+    // The test environment doesn't set any of the variables
+    for (auto thread : {ThreadScheduling::RenderThread, ThreadScheduling::InputThread, ThreadScheduling::ServerThread}) {
+        EXPECT_TRUE(ThreadScheduling::instance()->policy(thread).isUnchanged());
+    }
+}
+
+namespace {
+
+// Raising the nice value is always allowed, and only ever done in threads started for the purpose
+ThreadScheduling *createScheduling(std::initializer_list<const char*> variables)
+{
+    for (auto variable : variables) {
+        qputenv(variable, "nice:19");
+    }
+    auto scheduling = new ThreadScheduling;
+    for (auto variable : variables) {
+        qunsetenv(variable);
+    }
+    return scheduling;
+}
+
+template<typename Function>
+void runInNewThread(Function function)
+{
+    std::thread thread(function);
+    thread.join();
+}
+
+} // namespace
+
+TEST(ThreadSchedulingTest, AppliesEachKindOfPolicyOncePerThread)
+{
+    QScopedPointer<ThreadScheduling> scheduling(createScheduling({"QTMIR_SERVER_THREAD_SCHEDULING",
+                                                                  "QTMIR_INPUT_THREAD_SCHEDULING"}));
+
+    runInNewThread([&]() {
+        EXPECT_TRUE(scheduling->applyToCurrentThread(ThreadScheduling::ServerThread));
+        EXPECT_FALSE(scheduling->applyToCurrentThread(ThreadScheduling::ServerThread));
+
+        // Not taken for applied already, as another kind of thread
+        EXPECT_TRUE(scheduling->applyToCurrentThread(ThreadScheduling::InputThread));
+        EXPECT_FALSE(scheduling->applyToCurrentThread(ThreadScheduling::InputThread));
+    });
+
+    runInNewThread([&]() {
+        EXPECT_TRUE(scheduling->applyToCurrentThread(ThreadScheduling::InputThread));
+    });
+}
+
+TEST(ThreadSchedulingTest, UnchangedPolicyIsNotApplied)
+{
+    QScopedPointer<ThreadScheduling> scheduling(createScheduling({"QTMIR_SERVER_THREAD_SCHEDULING"}));
+
+    runInNewThread([&]() {
+        EXPECT_FALSE(scheduling->applyToCurrentThread(ThreadScheduling::InputThread));
+    });
+}
+
+TEST(ThreadSchedulingTest, GuiThreadDoesNotGetTheRenderPolicy)
+{
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+    QScopedPointer<ThreadScheduling> scheduling(createScheduling({"QTMIR_RENDER_THREAD_SCHEDULING"}));
+
+    // As with the basic render loop
+    EXPECT_FALSE(scheduling->applyToCurrentThread(ThreadScheduling::RenderThread));
+
+    runInNewThread([&]() {
+        EXPECT_TRUE(scheduling->applyToCurrentThread(ThreadScheduling::RenderThread));
+    });
+}
@@ -0,0 +1,308 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <Unity/Application/dbusfocusinfo.h>
+#include <Unity/Application/proc_info.h>
+
+#include <fake_mirsurface.h>
+#include <fake_session.h>
+
+#include <QCoreApplication>
+#include <QScopedPointer>
+
+using namespace qtmir;
+
+namespace {
+
+class StubProcInfo : public ProcInfo
+{
+public:
+    QString cgroup(pid_t pid, const char*) override { return cgroups.value(pid); }
+
+    QHash<pid_t, QString> cgroups;
+};
+
+const char appCGroup[] = "/user.slice/user-32011.slice/session-c3.scope/upstart/application-legacy-puritine_gedit_0.0-";
+
+} // namespace
+
+class DBusFocusInfoTest : public ::testing::Test
+{
+public:
+    DBusFocusInfoTest()
+        : qtApp(argc, argv)
+        , procInfo(new StubProcInfo)
+        , focusInfo(new DBusFocusInfo(procInfo))
+    {
+    }
+
+    FakeMirSurface *addSurface(FakeSession *session, const QString &id)
+    {
+        auto surface = new FakeMirSurface;
+        surface->setPersistentId(id);
+        surface->setSession(session);
+        surfaces << surface;
+        session->surfaceList()->prependSurface(surface);
+        return surface;
+    }
+
+    QSharedPointer<const FocusSnapshot> snapshot() const { return focusInfo->snapshot(); }
+
+    int argc{0};
+    char **argv{nullptr};
+    QCoreApplication qtApp;
+    QSharedPointer<StubProcInfo> procInfo;
+    QScopedPointer<DBusFocusInfo> focusInfo;
+    QList<FakeMirSurface*> surfaces;
+
+    ~DBusFocusInfoTest()
+    {
+        focusInfo.reset();
+        qDeleteAll(surfaces);
+    }
+};
+
+TEST_F(DBusFocusInfoTest, indexesTheSurfacesOfRegisteredSessions)
+{
+    FakeSession session;
+    session.setPid(100);
+    addSurface(&session, "surface-a");
+    focusInfo->registerSession(&session);
+
+    addSurface(&session, "surface-b");
+
+    EXPECT_EQ(QSet<QString>({"surface-a", "surface-b"}), snapshot()->knownSurfaceIds);
+    EXPECT_TRUE(snapshot()->focusedSurfaceIds.isEmpty());
+    EXPECT_FALSE(snapshot()->isPidFocused(100, QString()));
+}
+
+TEST_F(DBusFocusInfoTest, followsActiveFocus)
+{
+    FakeSession session;
+    session.setPid(100);
+    auto surface = addSurface(&session, "surface-a");
+    focusInfo->registerSession(&session);
+
+    surface->setActiveFocus(true);
+
+    EXPECT_EQ(QSet<QString>({"surface-a"}), snapshot()->focusedSurfaceIds);
+    EXPECT_TRUE(snapshot()->isPidFocused(100, QString()));
+    EXPECT_FALSE(snapshot()->isPidFocused(101, QString()));
+
+    surface->setActiveFocus(false);
+
+    EXPECT_TRUE(snapshot()->focusedSurfaceIds.isEmpty());
+    EXPECT_FALSE(snapshot()->isPidFocused(100, QString()));
+}
+
+TEST_F(DBusFocusInfoTest, registeringTwiceIsHarmless)
+{
+    FakeSession session;
+    addSurface(&session, "surface-a")->setActiveFocus(true);
+
+    focusInfo->registerSession(&session);
+    focusInfo->registerSession(&session);
+
+    EXPECT_EQ(QSet<QString>({"surface-a"}), snapshot()->knownSurfaceIds);
+}
+
+TEST_F(DBusFocusInfoTest, forgetsRemovedSurfaces)
+{
+    FakeSession session;
+    auto surface = addSurface(&session, "surface-a");
+    surface->setActiveFocus(true);
+    focusInfo->registerSession(&session);
+
+    session.surfaceList()->removeSurface(surface);
+
+    EXPECT_TRUE(snapshot()->knownSurfaceIds.isEmpty());
+    EXPECT_TRUE(snapshot()->focusedSurfaceIds.isEmpty());
+
+    // Not tracked anymore
+    surface->setActiveFocus(false);
+    surface->setActiveFocus(true);
+    EXPECT_TRUE(snapshot()->focusedSurfaceIds.isEmpty());
+}
+
+TEST_F(DBusFocusInfoTest, unregistersDestroyedSessions)
+{
+    auto session = new FakeSession;
+    session->setPid(100);
+    addSurface(session, "surface-a")->setActiveFocus(true);
+    focusInfo->registerSession(session);
+    ASSERT_TRUE(snapshot()->isPidFocused(100, QString()));
+
+    delete session;
+
+    EXPECT_TRUE(snapshot()->knownSurfaceIds.isEmpty());
+    EXPECT_FALSE(snapshot()->isPidFocused(100, QString()));
+}
+
+TEST_F(DBusFocusInfoTest, otherProcessesOfAFocusedAppCGroupAreFocused)
+{
+    procInfo->cgroups.insert(100, appCGroup);
+    FakeSession session;
+    session.setPid(100);
+    addSurface(&session, "surface-a")->setActiveFocus(true);
+    focusInfo->registerSession(&session);
+
+    EXPECT_TRUE(snapshot()->isPidFocused(200, appCGroup));
+    EXPECT_FALSE(snapshot()->isPidFocused(200, "/user.slice/user-32011.slice/session-c3.scope/upstart/other"));
+}
+
+TEST_F(DBusFocusInfoTest, cgroupsWhichArentAppSpecificArentShared)
+{
+    procInfo->cgroups.insert(100, "/user.slice/user-32011.slice/session-c3.scope");
+    FakeSession session;
+    session.setPid(100);
+    addSurface(&session, "surface-a")->setActiveFocus(true);
+    focusInfo->registerSession(&session);
+
+    EXPECT_TRUE(snapshot()->focusedCGroups.isEmpty());
+    EXPECT_FALSE(snapshot()->isPidFocused(200, QString()));
+}
+
+TEST_F(DBusFocusInfoTest, promptSessionSurfacesBelongToTheirOwnProcess)
+{
+    FakeSession appSession;
+    appSession.setPid(100);
+    addSurface(&appSession, "app-surface");
+
+    // Prompt providers are sessions of their own, registered as they start, then adopted by the app session
+    FakeSession promptProvider;
+    promptProvider.setPid(200);
+    auto promptSurface = addSurface(&promptProvider, "prompt-surface");
+
+    focusInfo->registerSession(&appSession);
+    focusInfo->registerSession(&promptProvider);
+    appSession.addChildSession(&promptProvider);
+
+    promptSurface->setActiveFocus(true);
+
+    EXPECT_EQ(QSet<QString>({"app-surface", "prompt-surface"}), snapshot()->knownSurfaceIds);
+    EXPECT_EQ(QSet<QString>({"prompt-surface"}), snapshot()->focusedSurfaceIds);
+    EXPECT_TRUE(snapshot()->isPidFocused(200, QString()));
+    EXPECT_FALSE(snapshot()->isPidFocused(100, QString()));
+}
+
+TEST_F(DBusFocusInfoTest, childSessionGoingAwayLeavesItsParentIndexed)
+{
+    FakeSession appSession;
+    appSession.setPid(100);
+    addSurface(&appSession, "app-surface")->setActiveFocus(true);
+
+    auto promptProvider = new FakeSession;
+    promptProvider->setPid(200);
+    addSurface(promptProvider, "prompt-surface");
+
+    focusInfo->registerSession(&appSession);
+    focusInfo->registerSession(promptProvider);
+    appSession.addChildSession(promptProvider);
+
+    appSession.removeChildSession(promptProvider);
+    delete promptProvider;
+
+    EXPECT_EQ(QSet<QString>({"app-surface"}), snapshot()->knownSurfaceIds);
+    EXPECT_TRUE(snapshot()->isPidFocused(100, QString()));
+}
+
+TEST(FocusSnapshotTest, pidsAreFocusedThroughTheirProcessOrTheirAppCGroup)
+{
+    FocusSnapshot snapshot;
+    snapshot.focusedPids.insert(100);
+    snapshot.focusedCGroups.insert(appCGroup);
+
+    EXPECT_TRUE(snapshot.isPidFocused(100, QString()));
+    EXPECT_TRUE(snapshot.isPidFocused(200, appCGroup));
+    EXPECT_FALSE(snapshot.isPidFocused(200, QString()));
+    EXPECT_FALSE(snapshot.isPidFocused(200, "/user.slice/user-32011.slice/session-c3.scope/upstart/other"));
+}
+
+TEST(FocusSnapshotTest, anEmptySnapshotFocusesNothing)
+{
+    FocusSnapshot snapshot;
+    snapshot.focusedCGroups.insert(QString()); // harmless even if it got in somehow
+
+    EXPECT_FALSE(snapshot.isPidFocused(0, QString()));
+    EXPECT_FALSE(snapshot.isPidFocused(100, QString()));
+}
+
+TEST(QueryRateLimiterTest, admitsABurstAndThenRefuses)
+{
+    QueryRateLimiter limiter(20, 40);
+
+    for (int i = 0; i < 40; ++i) {
+        EXPECT_TRUE(limiter.admit(":1.42", 1000)) << "query " << i;
+    }
+    EXPECT_FALSE(limiter.admit(":1.42", 1000));
+    EXPECT_FALSE(limiter.admit(":1.42", 1049));
+}
+
+TEST(QueryRateLimiterTest, refillsAtItsRate)
+{
+    QueryRateLimiter limiter(20, 40);
+    for (int i = 0; i < 40; ++i) {
+        limiter.admit(":1.42", 0);
+    }
+
+    // One query every 50ms
+    EXPECT_TRUE(limiter.admit(":1.42", 50));
+    EXPECT_FALSE(limiter.admit(":1.42", 50));
+
+    // Half a second is worth 10 queries
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_TRUE(limiter.admit(":1.42", 550)) << "query " << i;
+    }
+    EXPECT_FALSE(limiter.admit(":1.42", 550));
+}
+
+TEST(QueryRateLimiterTest, refillsNoFurtherThanTheBurst)
+{
+    QueryRateLimiter limiter(20, 40);
+    limiter.admit(":1.42", 0);
+
+    for (int i = 0; i < 40; ++i) {
+        EXPECT_TRUE(limiter.admit(":1.42", 60000)) << "query " << i;
+    }
+    EXPECT_FALSE(limiter.admit(":1.42", 60000));
+}
+
+TEST(QueryRateLimiterTest, callersHaveBucketsOfTheirOwn)
+{
+    QueryRateLimiter limiter(20, 40);
+    for (int i = 0; i < 40; ++i) {
+        limiter.admit(":1.42", 0);
+    }
+    ASSERT_FALSE(limiter.admit(":1.42", 0));
+
+    EXPECT_TRUE(limiter.admit(":1.43", 0));
+}
+
+TEST(QueryRateLimiterTest, forgetsCallersWithAFullBucket)
+{
+    QueryRateLimiter limiter(20, 40);
+    for (int i = 0; i < 100; ++i) {
+        limiter.admit(QString(":1.%1").arg(i), 0);
+    }
+    ASSERT_EQ(100, limiter.callerCount());
+
+    // Two seconds later every bucket would be full again
+    limiter.admit(":1.1000", 2001);
+
+    EXPECT_EQ(1, limiter.callerCount());
+}
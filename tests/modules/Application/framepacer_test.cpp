@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <Unity/Application/framepacer.h>
+
+#include <QtMath>
+
+using namespace qtmir;
+
+namespace {
+
+// How many frames get taken when offered one on every refresh of a display at refreshRate, for a second
+int framesTakenInASecond(FramePacer &pacer, qreal refreshRate, qint64 start = 100000)
+{
+    int count = 0;
+    for (int i = 0; i < qRound(refreshRate); ++i) {
+        const qint64 now = start + qFloor(i * 1000 / refreshRate);
+        if (pacer.isFrameDue(now)) {
+            pacer.frameTaken(now);
+            ++count;
+        }
+    }
+    return count;
+}
+
+} // namespace
+
+TEST(FramePacerTest, NoLimitByDefault)
+{
+    FramePacer pacer;
+
+    EXPECT_EQ(0, pacer.maxFrameRate());
+    EXPECT_EQ(60, framesTakenInASecond(pacer, 60));
+}
+
+TEST(FramePacerTest, HalfTheRefreshRateGetsEveryOtherFrame)
+{
+    FramePacer pacer;
+    pacer.setMaxFrameRate(30);
+
+    EXPECT_EQ(30, framesTakenInASecond(pacer, 60));
+}
+
+TEST(FramePacerTest, LowFrameRates)
+{
+    FramePacer pacer;
+    pacer.setMaxFrameRate(5);
+
+    EXPECT_EQ(5, framesTakenInASecond(pacer, 60));
+}
+
+TEST(FramePacerTest, FrameRateAboveTheRefreshRateDoesntLimit)
+{
+    FramePacer pacer;
+    pacer.setMaxFrameRate(120);
+
+    EXPECT_EQ(60, framesTakenInASecond(pacer, 60));
+}
+
+TEST(FramePacerTest, TimeUntilNextFrame)
+{
+    FramePacer pacer;
+    pacer.setMaxFrameRate(10);
+
+    ASSERT_TRUE(pacer.isFrameDue(1000));
+    pacer.frameTaken(1000);
+
+    EXPECT_FALSE(pacer.isFrameDue(1050));
+    EXPECT_EQ(50, pacer.timeUntilNextFrame(1050));
+    EXPECT_TRUE(pacer.isFrameDue(1100));
+}
+
+TEST(FramePacerTest, LateFramesDontCauseBursts)
+{
+    FramePacer pacer;
+    pacer.setMaxFrameRate(10);
+
+    pacer.frameTaken(1000);
+    pacer.frameTaken(2000); // the client went quiet for a while
+
+    EXPECT_FALSE(pacer.isFrameDue(2050));
+    EXPECT_TRUE(pacer.isFrameDue(2100));
+}
+
+TEST(FramePacerTest, NewLimitTakesEffectRightAway)
+{
+    FramePacer pacer;
+    pacer.setMaxFrameRate(1);
+    pacer.frameTaken(1000);
+    ASSERT_FALSE(pacer.isFrameDue(1100));
+
+    pacer.setMaxFrameRate(30);
+    EXPECT_TRUE(pacer.isFrameDue(1100));
+
+    pacer.setMaxFrameRate(0);
+    EXPECT_EQ(60, framesTakenInASecond(pacer, 60));
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <Unity/Application/mirsurfacenode.h>
+
+using namespace qtmir;
+
+namespace {
+
+class FakeTexture : public QSGTexture
+{
+public:
+    FakeTexture(const QRectF &subRect = QRectF(0, 0, 1, 1), bool alpha = false)
+        : m_subRect(subRect), m_alpha(alpha) {}
+
+    int textureId() const override { return 1; }
+    QSize textureSize() const override { return QSize(100, 100); }
+    bool hasAlphaChannel() const override { return m_alpha; }
+    bool hasMipmaps() const override { return false; }
+    QRectF normalizedTextureSubRect() const override { return m_subRect; }
+    bool isAtlasTexture() const override { return m_subRect != QRectF(0, 0, 1, 1); }
+    void bind() override {}
+
+private:
+    QRectF m_subRect;
+    bool m_alpha;
+};
+
+QRectF vertexRect(const QSGGeometry *geometry)
+{
+    auto vertices = geometry->vertexDataAsTexturedPoint2D();
+    return QRectF(QPointF(vertices[0].x, vertices[0].y), QPointF(vertices[3].x, vertices[3].y));
+}
+
+QRectF textureRect(const QSGGeometry *geometry)
+{
+    auto vertices = geometry->vertexDataAsTexturedPoint2D();
+    return QRectF(QPointF(vertices[0].tx, vertices[0].ty), QPointF(vertices[3].tx, vertices[3].ty));
+}
+
+} // namespace
+
+TEST(MirSurfaceNodeTest, DrawsTheSourceRectIntoTheTargetRect)
+{
+    FakeTexture texture;
+    MirSurfaceNode node;
+    node.setTexture(&texture);
+
+    node.setRect(QRectF(10, 20, 300, 200), QRectF(0, 0, 0.5, 0.25));
+
+    EXPECT_EQ(QRectF(10, 20, 300, 200), vertexRect(node.geometry()));
+    EXPECT_EQ(QRectF(0, 0, 0.5, 0.25), textureRect(node.geometry()));
+}
+
+TEST(MirSurfaceNodeTest, SourceRectIsRelativeToTheAtlasSubRect)
+{
+    FakeTexture texture(QRectF(0.5, 0.5, 0.25, 0.5));
+    MirSurfaceNode node;
+    node.setRect(QRectF(0, 0, 100, 100), QRectF(0, 0, 0.5, 1));
+
+    node.setTexture(&texture);
+
+    EXPECT_EQ(QRectF(0.5, 0.5, 0.125, 0.5), textureRect(node.geometry()));
+}
+
+TEST(MirSurfaceNodeTest, SwitchingTexturesKeepsTheGeometryInSync)
+{
+    FakeTexture atlasTexture(QRectF(0.5, 0, 0.5, 0.5));
+    FakeTexture texture;
+    MirSurfaceNode node;
+    node.setRect(QRectF(0, 0, 100, 100), QRectF(0, 0, 1, 1));
+
+    node.setTexture(&atlasTexture);
+    EXPECT_EQ(QRectF(0.5, 0, 0.5, 0.5), textureRect(node.geometry()));
+
+    node.setTexture(&texture);
+    EXPECT_EQ(QRectF(0, 0, 1, 1), textureRect(node.geometry()));
+    EXPECT_EQ(&texture, node.texture());
+}
+
+TEST(MirSurfaceNodeTest, BlendsOnlyTexturesWithAlpha)
+{
+    FakeTexture opaqueTexture;
+    FakeTexture translucentTexture(QRectF(0, 0, 1, 1), true);
+    MirSurfaceNode node;
+
+    node.setTexture(&opaqueTexture);
+    EXPECT_FALSE(node.opaqueMaterial()->flags() & QSGMaterial::Blending);
+
+    node.setTexture(&translucentTexture);
+    EXPECT_TRUE(node.opaqueMaterial()->flags() & QSGMaterial::Blending);
+}
@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <Unity/Application/occlusiontracker.h>
+
+#include <QGuiApplication>
+#include <QQuickItem>
+
+using namespace qtmir;
+
+class OcclusionCullerTest : public ::testing::Test
+{
+public:
+    OcclusionCullerTest()
+        : culler([this](const QQuickItem *item) { return opaqueItems.contains(item); })
+    {
+        setenv("QT_QPA_PLATFORM", "minimal", 1);
+        int argc = 0;
+        char **argv = nullptr;
+        app = new QGuiApplication(argc, argv);
+
+        root = new QQuickItem;
+        root->setSize(QSizeF(1000, 1000));
+    }
+    ~OcclusionCullerTest()
+    {
+        delete root;
+        delete app;
+    }
+
+    QQuickItem *createItem(const QRectF &rect, bool opaque, QQuickItem *parent = nullptr)
+    {
+        auto item = new QQuickItem(parent ? parent : root);
+        item->setPosition(rect.topLeft());
+        item->setSize(rect.size());
+        if (opaque) {
+            opaqueItems.insert(item);
+        }
+        return item;
+    }
+
+    bool isOccluded(QQuickItem *item)
+    {
+        return culler.occludedItems(root, {item}).contains(item);
+    }
+
+    QGuiApplication *app;
+    QQuickItem *root;
+    QSet<const QQuickItem*> opaqueItems;
+    OcclusionCuller culler;
+};
+
+TEST_F(OcclusionCullerTest, ItemUnderOpaqueItemIsOccluded)
+{
+    auto item = createItem(QRectF(100, 100, 200, 200), true);
+    createItem(QRectF(50, 50, 400, 400), true);
+
+    EXPECT_TRUE(isOccluded(item));
+}
+
+TEST_F(OcclusionCullerTest, ItemOverOpaqueItemIsNotOccluded)
+{
+    createItem(QRectF(50, 50, 400, 400), true);
+    auto item = createItem(QRectF(100, 100, 200, 200), true);
+
+    EXPECT_FALSE(isOccluded(item));
+}
+
+TEST_F(OcclusionCullerTest, ZOrderTakesPrecedenceOverItemOrder)
+{
+    auto item = createItem(QRectF(100, 100, 200, 200), true);
+    auto cover = createItem(QRectF(50, 50, 400, 400), true);
+
+    item->setZ(1);
+    EXPECT_FALSE(isOccluded(item));
+
+    cover->setZ(2);
+    EXPECT_TRUE(isOccluded(item));
+}
+
+TEST_F(OcclusionCullerTest, PartiallyCoveredItemIsNotOccluded)
+{
+    auto item = createItem(QRectF(100, 100, 200, 200), true);
+    createItem(QRectF(150, 50, 400, 400), true);
+
+    EXPECT_FALSE(isOccluded(item));
+}
+
+TEST_F(OcclusionCullerTest, ItemCoveredByOpaqueItemsTogetherIsOccluded)
+{
+    auto item = createItem(QRectF(100, 100, 200, 200), true);
+    createItem(QRectF(0, 0, 200, 400), true);
+    createItem(QRectF(200, 0, 200, 400), true);
+
+    EXPECT_TRUE(isOccluded(item));
+}
+
+TEST_F(OcclusionCullerTest, FractionalEdgesOfOpaqueItemsDontCover)
+{
+    auto item = createItem(QRectF(100, 100, 200, 200), true);
+    createItem(QRectF(100.5, 100, 200, 200), true);
+
+    EXPECT_FALSE(isOccluded(item));
+}
+
+TEST_F(OcclusionCullerTest, TranslucentItemsDontOcclude)
+{
+    auto item = createItem(QRectF(100, 100, 200, 200), true);
+    auto cover = createItem(QRectF(50, 50, 400, 400), false);
+
+    EXPECT_FALSE(isOccluded(item));
+
+    opaqueItems.insert(cover);
+    cover->setOpacity(0.5);
+    EXPECT_FALSE(isOccluded(item));
+}
+
+TEST_F(OcclusionCullerTest, ItemsInTranslucentParentsDontOcclude)
+{
+    auto item = createItem(QRectF(100, 100, 200, 200), true);
+    auto parent = createItem(QRectF(0, 0, 1000, 1000), false);
+    parent->setOpacity(0.9);
+    createItem(QRectF(50, 50, 400, 400), true, parent);
+
+    EXPECT_FALSE(isOccluded(item));
+}
+
+TEST_F(OcclusionCullerTest, RotatedItemsDontOcclude)
+{
+    auto item = createItem(QRectF(100, 100, 200, 200), true);
+    auto cover = createItem(QRectF(0, 0, 500, 500), true);
+    cover->setRotation(10);
+
+    EXPECT_FALSE(isOccluded(item));
+}
+
+TEST_F(OcclusionCullerTest, HiddenItemsDontOcclude)
+{
+    auto item = createItem(QRectF(100, 100, 200, 200), true);
+    auto cover = createItem(QRectF(50, 50, 400, 400), true);
+    cover->setVisible(false);
+
+    EXPECT_FALSE(isOccluded(item));
+}
+
+TEST_F(OcclusionCullerTest, ClippedItemsOnlyOccludeWhatsLeftOfThem)
+{
+    auto item = createItem(QRectF(100, 100, 200, 200), true);
+    auto parent = createItem(QRectF(0, 0, 200, 1000), false);
+    parent->setClip(true);
+    createItem(QRectF(50, 50, 400, 400), true, parent);
+
+    EXPECT_FALSE(isOccluded(item));
+
+    parent->setWidth(300);
+    EXPECT_TRUE(isOccluded(item));
+}
+
+TEST_F(OcclusionCullerTest, ItemsOutsideTheSceneAreNotOccluded)
+{
+    auto item = createItem(QRectF(2000, 2000, 200, 200), true);
+
+    EXPECT_FALSE(isOccluded(item));
+}
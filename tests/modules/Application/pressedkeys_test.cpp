@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <Unity/Application/pressedkeys.h>
+
+#include <QList>
+
+#include <algorithm>
+
+using namespace qtmir;
+
+namespace {
+
+PressedKey makeKey(quint32 nativeScanCode, quint32 nativeVirtualKey, ulong timestamp = 0)
+{
+    PressedKey key;
+    key.nativeScanCode = nativeScanCode;
+    key.nativeVirtualKey = nativeVirtualKey;
+    key.timestamp = timestamp;
+    return key;
+}
+
+QList<quint32> releaseAllScanCodes(PressedKeys &pressedKeys)
+{
+    QList<quint32> scanCodes;
+    pressedKeys.releaseAll([&](const PressedKey &key) { scanCodes.append(key.nativeScanCode); });
+    std::sort(scanCodes.begin(), scanCodes.end());
+    return scanCodes;
+}
+
+} // namespace
+
+TEST(PressedKeysTests, tracksPressAndRelease)
+{
+    PressedKeys pressedKeys(QSharedPointer<PressedKeyTable>::create());
+    EXPECT_TRUE(pressedKeys.isEmpty());
+
+    pressedKeys.press(makeKey(30, 'a'));
+    EXPECT_FALSE(pressedKeys.isEmpty());
+    EXPECT_TRUE(pressedKeys.isPressed(30, 'a'));
+    EXPECT_FALSE(pressedKeys.isPressed(48, 'b'));
+
+    EXPECT_TRUE(pressedKeys.release(30, 'a'));
+    EXPECT_FALSE(pressedKeys.release(30, 'a'));
+    EXPECT_TRUE(pressedKeys.isEmpty());
+}
+
+TEST(PressedKeysTests, releaseMatchesScanCodeEvenIfVirtualKeyChanged)
+{
+    PressedKeys pressedKeys(QSharedPointer<PressedKeyTable>::create());
+
+    // eg. shift was released between the press and the release of the key
+    pressedKeys.press(makeKey(30, 'A'));
+    EXPECT_TRUE(pressedKeys.release(30, 'a'));
+}
+
+TEST(PressedKeysTests, releaseAllVisitsEachPressedKeyOnce)
+{
+    PressedKeys pressedKeys(QSharedPointer<PressedKeyTable>::create());
+    pressedKeys.press(makeKey(1, 0xff1b));
+    pressedKeys.press(makeKey(63, 0xffc2));
+    pressedKeys.press(makeKey(64, 0xffc3));
+    pressedKeys.press(makeKey(PressedKeyTable::keyCount - 1, 0x1008ff01));
+    pressedKeys.press(makeKey(0, 0x1008ff02)); // no scan code
+
+    EXPECT_EQ((QList<quint32>{0, 1, 63, 64, PressedKeyTable::keyCount - 1}), releaseAllScanCodes(pressedKeys));
+    EXPECT_TRUE(pressedKeys.isEmpty());
+    EXPECT_TRUE(releaseAllScanCodes(pressedKeys).isEmpty());
+}
+
+TEST(PressedKeysTests, keysWithoutScanCodeAreMatchedByVirtualKey)
+{
+    PressedKeys pressedKeys(QSharedPointer<PressedKeyTable>::create());
+    pressedKeys.press(makeKey(0, 'a'));
+    pressedKeys.press(makeKey(0, 'b'));
+
+    EXPECT_TRUE(pressedKeys.isPressed(0, 'b'));
+    EXPECT_TRUE(pressedKeys.release(0, 'a'));
+    EXPECT_FALSE(pressedKeys.isPressed(0, 'a'));
+    EXPECT_TRUE(pressedKeys.isPressed(0, 'b'));
+}
+
+TEST(PressedKeysTests, surfacesOfASessionShareTheTableButNotTheirPressedKeys)
+{
+    auto table = QSharedPointer<PressedKeyTable>::create();
+    PressedKeys first(table);
+    PressedKeys second(table);
+
+    first.press(makeKey(30, 'a', 100));
+    EXPECT_FALSE(second.isPressed(30, 'a'));
+
+    // The key got released somewhere else and pressed again on the second surface, whose keymap differs
+    second.press(makeKey(30, 'q', 200));
+    EXPECT_TRUE(second.release(30, 'q'));
+
+    // Timestamp and device are those of the latest press, but the virtual key is the one the first surface sent
+    PressedKey releasedKey;
+    first.releaseAll([&](const PressedKey &key) { releasedKey = key; });
+    EXPECT_EQ(30u, releasedKey.nativeScanCode);
+    EXPECT_EQ(quint32('a'), releasedKey.nativeVirtualKey);
+    EXPECT_EQ(200u, releasedKey.timestamp);
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <Unity/Application/proc_info.h>
+
+#include <QString>
+
+using namespace qtmir;
+
+namespace {
+
+const char cgroupV1[] =
+        "11:freezer:/user.slice/user-32011.slice/session-c3.scope/upstart/application-legacy-puritine_gedit_0.0-\n"
+        "10:cpu,cpuacct:/user.slice\n"
+        "1:name=systemd:/user.slice/user-32011.slice/session-c3.scope\n";
+
+const char cgroupHybrid[] =
+        "10:cpu,cpuacct:/user.slice\n"
+        "1:name=systemd:/user.slice/user-32011.slice/session-c3.scope\n"
+        "0::/user.slice/user-32011.slice/session-c3.scope\n";
+
+const char cgroupV2[] = "0::/user.slice/user-32011.slice/user@32011.service/app.slice/app-gedit.scope\n";
+
+} // namespace
+
+TEST(ProcInfoTest, FindsTheHierarchyOfTheController)
+{
+    EXPECT_EQ(QString("/user.slice/user-32011.slice/session-c3.scope/upstart/application-legacy-puritine_gedit_0.0-"),
+              ProcInfo::cgroupFromProcFile(cgroupV1, "freezer"));
+    EXPECT_EQ(QString("/user.slice"), ProcInfo::cgroupFromProcFile(cgroupV1, "cpuacct"));
+}
+
+TEST(ProcInfoTest, ControllerNamesMatchExactly)
+{
+    EXPECT_EQ(QString(), ProcInfo::cgroupFromProcFile(cgroupV1, "cpua"));
+    EXPECT_EQ(QString(), ProcInfo::cgroupFromProcFile(cgroupV1, "systemd"));
+}
+
+TEST(ProcInfoTest, FallsBackToTheUnifiedHierarchy)
+{
+    EXPECT_EQ(QString("/user.slice/user-32011.slice/user@32011.service/app.slice/app-gedit.scope"),
+              ProcInfo::cgroupFromProcFile(cgroupV2, "freezer"));
+    EXPECT_EQ(QString("/user.slice/user-32011.slice/session-c3.scope"),
+              ProcInfo::cgroupFromProcFile(cgroupHybrid, "freezer"));
+
+    // A v1 hierarchy with the controller wins over the unified one
+    EXPECT_EQ(QString("/user.slice"), ProcInfo::cgroupFromProcFile(cgroupHybrid, "cpu"));
+}
+
+TEST(ProcInfoTest, IgnoresMalformedLines)
+{
+    EXPECT_EQ(QString(), ProcInfo::cgroupFromProcFile("", "freezer"));
+    EXPECT_EQ(QString(), ProcInfo::cgroupFromProcFile("garbage\nfreezer\n11:freezer\n", "freezer"));
+    EXPECT_EQ(QString("/a"), ProcInfo::cgroupFromProcFile("garbage\n11:freezer:/a", "freezer"));
+}
+
+TEST(ProcInfoTest, NoCGroupForAMissingProcess)
+{
+    ProcInfo procInfo;
+
+    EXPECT_EQ(QString(), procInfo.cgroup(-1, "freezer"));
+}
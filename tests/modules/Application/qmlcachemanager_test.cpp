@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <Unity/Application/qmlcachemanager.h>
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+
+using namespace qtmir;
+
+class QmlCacheManagerTests : public ::testing::Test
+{
+public:
+    QmlCacheManagerTests()
+        : qtApp(argc, argv)
+    {
+    }
+
+    void createCache(const QString &dirName, int bytes)
+    {
+        QDir root(cacheRoot.path());
+        root.mkdir(dirName);
+        QFile file(root.filePath(dirName + QStringLiteral("/main.qmlc")));
+        file.open(QFile::WriteOnly);
+        file.write(QByteArray(bytes, 'x'));
+    }
+
+    bool cacheExists(const QString &dirName) const
+    {
+        return QDir(cacheRoot.path()).exists(dirName);
+    }
+
+    int argc{0};
+    char **argv{nullptr};
+    QCoreApplication qtApp; // for the queued signals coming from the worker thread
+    QTemporaryDir cacheRoot;
+};
+
+TEST_F(QmlCacheManagerTests, invalidatedCacheIsMovedAwayAndDeletedOnPurge)
+{
+    createCache(QStringLiteral("webbrowser-app"), 10);
+    createCache(QStringLiteral("gallery-app"), 10);
+
+    QmlCacheManager cacheManager(cacheRoot.path(), 0);
+    QSignalSpy purgedSpy(&cacheManager, &QmlCacheManager::purged);
+
+    cacheManager.invalidate(QStringLiteral("webbrowser-app"));
+    cacheManager.purge();
+    ASSERT_TRUE(purgedSpy.wait());
+
+    EXPECT_FALSE(cacheExists(QStringLiteral("webbrowser-app")));
+    EXPECT_TRUE(cacheExists(QStringLiteral("gallery-app")));
+    EXPECT_EQ(QStringList({QStringLiteral("gallery-app")}),
+              QDir(cacheRoot.path()).entryList(QDir::Dirs | QDir::Hidden | QDir::NoDotAndDotDot));
+    EXPECT_EQ(10, purgedSpy.at(0).at(0).toLongLong());
+}
+
+TEST_F(QmlCacheManagerTests, leastRecentlyUsedCacheIsEvictedWhenOverBudget)
+{
+    createCache(QStringLiteral("webbrowser-app"), 100);
+    createCache(QStringLiteral("gallery-app"), 100);
+    createCache(QStringLiteral("camera-app"), 100);
+
+    QmlCacheManager cacheManager(cacheRoot.path(), 250);
+    QSignalSpy purgedSpy(&cacheManager, &QmlCacheManager::purged);
+
+    cacheManager.markUsed(QStringLiteral("gallery-app"));
+    cacheManager.markUsed(QStringLiteral("webbrowser-app"));
+    cacheManager.markUsed(QStringLiteral("camera-app"));
+    cacheManager.markUsed(QStringLiteral("webbrowser-app"));
+    cacheManager.purge();
+    ASSERT_TRUE(purgedSpy.wait());
+
+    EXPECT_FALSE(cacheExists(QStringLiteral("gallery-app")));
+    EXPECT_TRUE(cacheExists(QStringLiteral("camera-app")));
+    EXPECT_TRUE(cacheExists(QStringLiteral("webbrowser-app")));
+    EXPECT_EQ(200, purgedSpy.at(0).at(0).toLongLong());
+}
+
+TEST_F(QmlCacheManagerTests, onlyTheCacheNamedAfterTheAppIdIsInvalidated)
+{
+    createCache(QStringLiteral("foo-bar"), 10);
+    createCache(QStringLiteral("foo"), 10);
+    createCache(QStringLiteral("barfoo"), 10);
+
+    QmlCacheManager cacheManager(cacheRoot.path(), 0);
+    QSignalSpy purgedSpy(&cacheManager, &QmlCacheManager::purged);
+
+    cacheManager.invalidate(QStringLiteral("foo"));
+    cacheManager.purge();
+    ASSERT_TRUE(purgedSpy.wait());
+
+    EXPECT_FALSE(cacheExists(QStringLiteral("foo")));
+    EXPECT_TRUE(cacheExists(QStringLiteral("foo-bar")));
+    EXPECT_TRUE(cacheExists(QStringLiteral("barfoo")));
+}
+
+TEST_F(QmlCacheManagerTests, cachesNamedAfterTheVersionedAppIdAreInvalidated)
+{
+    createCache(QStringLiteral("com.ubuntu.camera_camera_3.0.0.656"), 10);
+    createCache(QStringLiteral("com.ubuntu.camera_camera-helper"), 10);
+    createCache(QStringLiteral("com.ubuntu.camera_cameraroll_1.0"), 10);
+
+    QmlCacheManager cacheManager(cacheRoot.path(), 0);
+    QSignalSpy purgedSpy(&cacheManager, &QmlCacheManager::purged);
+
+    cacheManager.invalidate(QStringLiteral("com.ubuntu.camera_camera"));
+    cacheManager.purge();
+    ASSERT_TRUE(purgedSpy.wait());
+
+    EXPECT_FALSE(cacheExists(QStringLiteral("com.ubuntu.camera_camera_3.0.0.656")));
+    EXPECT_TRUE(cacheExists(QStringLiteral("com.ubuntu.camera_camera-helper")));
+    EXPECT_TRUE(cacheExists(QStringLiteral("com.ubuntu.camera_cameraroll_1.0")));
+}
+
+TEST_F(QmlCacheManagerTests, cachesNamedAfterTheVersionedAppIdAreMarkedUsed)
+{
+    createCache(QStringLiteral("gallery-app_2.9"), 100);
+    createCache(QStringLiteral("camera-app"), 100);
+
+    QmlCacheManager cacheManager(cacheRoot.path(), 150);
+    QSignalSpy purgedSpy(&cacheManager, &QmlCacheManager::purged);
+
+    cacheManager.markUsed(QStringLiteral("camera-app"));
+    cacheManager.markUsed(QStringLiteral("gallery-app"));
+    cacheManager.purge();
+    ASSERT_TRUE(purgedSpy.wait());
+
+    EXPECT_FALSE(cacheExists(QStringLiteral("camera-app")));
+    EXPECT_TRUE(cacheExists(QStringLiteral("gallery-app_2.9")));
+}
+
+TEST_F(QmlCacheManagerTests, invalidatingAnAppWithoutACacheLeavesOthersAlone)
+{
+    createCache(QStringLiteral("foo-bar"), 10);
+
+    QmlCacheManager cacheManager(cacheRoot.path(), 0);
+    QSignalSpy purgedSpy(&cacheManager, &QmlCacheManager::purged);
+
+    cacheManager.invalidate(QStringLiteral("foo"));
+    cacheManager.purge();
+    ASSERT_TRUE(purgedSpy.wait());
+
+    EXPECT_TRUE(cacheExists(QStringLiteral("foo-bar")));
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2017 Canonical, Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 3, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranties of MERCHANTABILITY,
+ * SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <Unity/Application/touchresampler.h>
+
+using namespace qtmir;
+
+namespace {
+
+TouchResampler::Sample makeSample(ulong timestamp, QPointF pos, Qt::TouchPointState state = Qt::TouchPointMoved)
+{
+    QTouchEvent::TouchPoint touchPoint(0);
+    touchPoint.setPos(pos);
+    touchPoint.setState(state);
+
+    TouchResampler::Sample sample;
+    sample.timestamp = timestamp;
+    sample.touchPoints.append(touchPoint);
+    sample.touchPointStates = state;
+    return sample;
+}
+
+} // namespace
+
+TEST(TouchResamplerTests, interpolatesBetweenSamplesAroundFrameTime)
+{
+    TouchResampler resampler;
+    resampler.delivered(makeSample(100, QPointF(0, 0), Qt::TouchPointPressed));
+    resampler.queue(makeSample(110, QPointF(10, 0)));
+    resampler.queue(makeSample(120, QPointF(20, 10)));
+
+    auto sample = resampler.resample(115);
+
+    EXPECT_FALSE(resampler.hasQueuedSamples());
+    EXPECT_EQ(120ul, sample.timestamp); // so that it can still be matched to the Mir event
+    ASSERT_EQ(1, sample.touchPoints.count());
+    EXPECT_EQ(QPointF(15, 5), sample.touchPoints[0].pos());
+    EXPECT_EQ(Qt::TouchPointMoved, sample.touchPoints[0].state());
+}
+
+TEST(TouchResamplerTests, predictsAtMostHalfTheLastSampleInterval)
+{
+    TouchResampler resampler;
+    resampler.delivered(makeSample(100, QPointF(0, 0), Qt::TouchPointPressed));
+    resampler.queue(makeSample(110, QPointF(10, 0)));
+
+    auto sample = resampler.resample(130);
+
+    ASSERT_EQ(1, sample.touchPoints.count());
+    EXPECT_EQ(QPointF(15, 0), sample.touchPoints[0].pos());
+}
+
+TEST(TouchResamplerTests, doesNotPredictFromStaleSamples)
+{
+    TouchResampler resampler;
+    resampler.delivered(makeSample(100, QPointF(0, 0), Qt::TouchPointPressed));
+    resampler.queue(makeSample(200, QPointF(10, 0)));
+
+    auto sample = resampler.resample(210);
+
+    ASSERT_EQ(1, sample.touchPoints.count());
+    EXPECT_EQ(QPointF(10, 0), sample.touchPoints[0].pos());
+}
+
+TEST(TouchResamplerTests, takeLatestReturnsLatestSampleAsIs)
+{
+    TouchResampler resampler;
+    resampler.delivered(makeSample(100, QPointF(0, 0), Qt::TouchPointPressed));
+    resampler.queue(makeSample(110, QPointF(10, 0)));
+    resampler.queue(makeSample(120, QPointF(10, 0), Qt::TouchPointStationary));
+
+    auto sample = resampler.takeLatest();
+
+    EXPECT_FALSE(resampler.hasQueuedSamples());
+    EXPECT_EQ(120ul, sample.timestamp);
+    EXPECT_EQ(QPointF(10, 0), sample.touchPoints[0].pos());
+    EXPECT_TRUE(sample.touchPointStates & Qt::TouchPointMoved);
+}
+
+TEST(TouchResamplerTests, onlyMotionIsQueueable)
+{
+    QTouchEvent::TouchPoint moved(0);
+    moved.setState(Qt::TouchPointMoved);
+    QTouchEvent::TouchPoint pressed(1);
+    pressed.setState(Qt::TouchPointPressed);
+
+    EXPECT_TRUE(TouchResampler::isMotion({moved}));
+    EXPECT_FALSE(TouchResampler::isMotion({moved, pressed}));
+    EXPECT_FALSE(TouchResampler::isMotion({}));
+}
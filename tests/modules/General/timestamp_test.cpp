@@ -32,6 +32,9 @@ protected:
     }
 };
 
+typedef std::chrono::duration<quint32, std::milli> Timestamp32bit;
+typedef std::chrono::duration<quint64, std::milli> Timestamp64bit;
+
 TEST_F(TimestampTest, TestCompressAndUncompress)
 {
     using namespace testing;
@@ -40,15 +43,15 @@ TEST_F(TimestampTest, TestCompressAndUncompress)
     now = std::chrono::system_clock::now();
     auto original_timestamp = now.time_since_epoch();
 
-    qtmir::Timestamp addToTimestamp(0);
+    Timestamp32bit addToTimestamp(0);
 
     for (int i = 0; i < 100; i++) {
         auto timestamp = original_timestamp + addToTimestamp;
 
-        qtmir::Timestamp compressedTimestamp = qtmir::compressTimestamp<qtmir::Timestamp>(timestamp);
+        Timestamp32bit compressedTimestamp = qtmir::compressTimestamp<Timestamp32bit>(timestamp);
 
         EXPECT_EQ(addToTimestamp, compressedTimestamp);
-        EXPECT_EQ(qtmir::uncompressTimestamp<qtmir::Timestamp>(compressedTimestamp), timestamp);
+        EXPECT_EQ(qtmir::uncompressTimestamp<Timestamp32bit>(compressedTimestamp), timestamp);
 
         addToTimestamp += std::chrono::seconds(1);
     }
@@ -62,8 +65,6 @@ TEST_F(TimestampTest, TestOverflowWhenExceeding32bitCompression)
     now = std::chrono::system_clock::now();
     auto timestamp = now.time_since_epoch();
 
-    typedef std::chrono::duration<quint32, std::milli> Timestamp32bit;
-
     // Do first compression. This will result in qield of 0 as seen in TestCompressUncompress
     auto compressedTimestamp = qtmir::compressTimestamp<Timestamp32bit>(timestamp);
 
@@ -76,3 +77,80 @@ TEST_F(TimestampTest, TestOverflowWhenExceeding32bitCompression)
     // ensure the uncompression will yields the original timestamp
     EXPECT_EQ(qtmir::uncompressTimestamp<Timestamp32bit>(compressedTimestamp), timestamp);
 }
+
+TEST_F(TimestampTest, Test64bitTimestampsAreNotRelativeToStartTime)
+{
+    using namespace testing;
+
+    auto timestamp = std::chrono::steady_clock::now().time_since_epoch();
+
+    auto compressedTimestamp = qtmir::compressTimestamp<Timestamp64bit>(timestamp);
+
+    EXPECT_EQ(std::chrono::duration_cast<Timestamp64bit>(timestamp), compressedTimestamp);
+    EXPECT_EQ(std::chrono::duration_cast<Timestamp64bit>(timestamp), qtmir::uncompressTimestamp<Timestamp64bit>(compressedTimestamp));
+
+    // The start time wasn't even looked at
+    EXPECT_EQ(0, getStartTime(std::chrono::nanoseconds(0), false).count());
+}
+
+TEST_F(TimestampTest, Test64bitTimestampsKeepTheirOrderWhenTravellingToThePast)
+{
+    using namespace testing;
+
+    auto timestamp = std::chrono::steady_clock::now().time_since_epoch();
+
+    auto later = qtmir::compressTimestamp<Timestamp64bit>(timestamp + std::chrono::seconds(1));
+    auto earlier = qtmir::compressTimestamp<Timestamp64bit>(timestamp);
+
+    // A relative timestamp would have been reset to 0 here, and the events after it reordered
+    EXPECT_LT(earlier, later);
+    EXPECT_EQ(std::chrono::milliseconds(1000), later - earlier);
+}
+
+TEST_F(TimestampTest, TestQtTimestampsAreNativeOn64bitArchs)
+{
+    using namespace testing;
+
+    EXPECT_EQ(sizeof(ulong) >= sizeof(qint64), qtmir::detail::HoldsNativeTimestamp<qtmir::Timestamp>::value);
+}
+
+TEST_F(TimestampTest, Test64bitRoundTripCost)
+{
+    using namespace testing;
+
+    const int iterations = 1000000;
+    // Whole milliseconds, so that both kinds of timestamps can round trip exactly
+    auto timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch());
+
+    int relativeMismatches = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        auto ts = timestamp + std::chrono::milliseconds(i);
+        if (qtmir::uncompressTimestamp(qtmir::compressTimestamp<Timestamp32bit>(ts)) != ts) {
+            ++relativeMismatches;
+        }
+    }
+    auto relativeDuration = std::chrono::steady_clock::now() - start;
+
+    resetStartTime(std::chrono::nanoseconds(0));
+
+    int nativeMismatches = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        auto ts = timestamp + std::chrono::milliseconds(i);
+        if (qtmir::uncompressTimestamp(qtmir::compressTimestamp<Timestamp64bit>(ts)) != ts) {
+            ++nativeMismatches;
+        }
+    }
+    auto nativeDuration = std::chrono::steady_clock::now() - start;
+
+    EXPECT_EQ(0, relativeMismatches);
+    EXPECT_EQ(0, nativeMismatches);
+
+    // The 64 bit round trips never needed a start time
+    EXPECT_EQ(0, getStartTime(std::chrono::nanoseconds(0), false).count());
+
+    // Not asserted on, timings are too noisy on the builders
+    RecordProperty("relativeRoundTripNs", int(std::chrono::duration_cast<std::chrono::nanoseconds>(relativeDuration).count() / iterations));
+    RecordProperty("nativeRoundTripNs", int(std::chrono::duration_cast<std::chrono::nanoseconds>(nativeDuration).count() / iterations));
+}
@@ -164,7 +164,7 @@ TEST_F(SharedWakelockTest, doubleAcquireThenReleaseBySameOwnerDestroysWakelock)
     wakelock.acquire(object.data());
     wakelock.acquire(object.data());
     wakelock.release(object.data());
-    wakelockEnabledSpy.wait();
+    while (wakelockEnabledSpy.wait(1000)) {} // release only happens once the hold-off window expires
     EXPECT_FALSE(wakelock.enabled());
 }
 
@@ -202,7 +202,7 @@ TEST_F(SharedWakelockTest, twoOwnersWhenBothReleaseWakelockReleased)
     wakelock.release(object1.data());
     wakelock.release(object2.data());
 
-    wakelockEnabledSpy.wait();
+    while (wakelockEnabledSpy.wait(1000)) {} // release only happens once the hold-off window expires
     EXPECT_FALSE(wakelock.enabled());
 }
 
@@ -232,9 +232,9 @@ TEST_F(SharedWakelockTest, wakelockAcquireReleaseFlood)
     implementRequestSysState();
     implementClearSysState();
 
-    SharedWakelock wakelock(dbus.systemConnection());
+    SharedWakelock wakelock(dbus.systemConnection(), 100);
 
-    QSignalSpy wakelockEnabledSpy(&wakelock, SIGNAL( enabledChanged(bool) ));
+    QSignalSpy wakelockDBusMethodSpy(&powerdMockInterface(), SIGNAL(MethodCalled(const QString &, const QVariantList &)));
 
     QScopedPointer<QObject> object(new QObject);
     wakelock.acquire(object.data());
@@ -243,8 +243,39 @@ TEST_F(SharedWakelockTest, wakelockAcquireReleaseFlood)
     wakelock.release(object.data());
     wakelock.acquire(object.data());
     wakelock.release(object.data());
-    while (wakelockEnabledSpy.wait(100)) {}
+    while (wakelockDBusMethodSpy.wait(500)) {}
     EXPECT_FALSE(wakelock.enabled());
+
+    // the flood is merged into a single acquisition and a single release
+    ASSERT_EQ(2, wakelockDBusMethodSpy.count());
+    EXPECT_CALL(wakelockDBusMethodSpy, 0, "requestSysState",
+                QVariantList() << QString("active") << 1);
+    EXPECT_CALL(wakelockDBusMethodSpy, 1, "clearSysState",
+                QVariantList() << QString("cookie"));
+}
+
+TEST_F(SharedWakelockTest, acquireAfterAReleaseIsNotHeldBack)
+{
+    implementRequestSysState();
+    implementClearSysState();
+
+    SharedWakelock wakelock(dbus.systemConnection(), 100);
+
+    QSignalSpy wakelockDBusMethodSpy(&powerdMockInterface(), SIGNAL(MethodCalled(const QString &, const QVariantList &)));
+
+    QScopedPointer<QObject> object(new QObject);
+    wakelock.acquire(object.data());
+    wakelock.release(object.data());
+    while (wakelockDBusMethodSpy.wait(500)) {}
+    ASSERT_FALSE(wakelock.enabled());
+    ASSERT_EQ(2, wakelockDBusMethodSpy.count());
+
+    // right after a release, the new acquire goes out without waiting for any window
+    wakelock.acquire(object.data());
+    EXPECT_TRUE(wakelock.enabled());
+    ASSERT_TRUE(wakelockDBusMethodSpy.wait(50));
+    EXPECT_CALL(wakelockDBusMethodSpy, 2, "requestSysState",
+                QVariantList() << QString("active") << 1);
 }
 
 TEST_F(SharedWakelockTest, wakelockAcquireReleaseAcquireWithDelays)
@@ -258,7 +289,7 @@ TEST_F(SharedWakelockTest, wakelockAcquireReleaseAcquireWithDelays)
 
     implementClearSysState();
 
-    SharedWakelock wakelock(dbus.systemConnection());
+    SharedWakelock wakelock(dbus.systemConnection(), 100);
 
     QSignalSpy wakelockDBusMethodSpy(&powerdMockInterface(), SIGNAL(MethodCalled(const QString &, const QVariantList &)));
 
@@ -267,21 +298,14 @@ TEST_F(SharedWakelockTest, wakelockAcquireReleaseAcquireWithDelays)
     wakelock.release(object.data());
     wakelock.acquire(object.data());
 
-    while (wakelockDBusMethodSpy.wait()) {}
+    while (wakelockDBusMethodSpy.wait(500)) {}
     EXPECT_TRUE(wakelock.enabled());
 
-    // there must be at least one clearSysState call, but is not necessarily the second call
-    // should the dbus response be slow enough, it may be the third call. Is hard to reliably
-    // reproduce the racey condition for all platforms.
-    bool found = false;
-    for (int i=0; i<wakelockDBusMethodSpy.count(); i++) {
-        const QVariantList &call(wakelockDBusMethodSpy.at(i));
-
-        if (call.at(0).toString() == "clearSysState") {
-            found = true;
-        }
-    }
-    EXPECT_TRUE(found);
+    // the release is cancelled by the acquire that follows it within the hold-off window,
+    // so the wakelock is requested once and never cleared
+    ASSERT_EQ(1, wakelockDBusMethodSpy.count());
+    EXPECT_CALL(wakelockDBusMethodSpy, 0, "requestSysState",
+                QVariantList() << QString("active") << 1);
 }
 
 TEST_F(SharedWakelockTest, nullOwnerAcquireIgnored)
@@ -48,6 +48,7 @@ struct MirEvent {}; // otherwise won't compile otherwise due to incomplete type
 // mir
 #include <mir/scene/surface_creation_parameters.h>
 #include <mir/version.h>
+#include <mir_toolkit/event.h>
 
 // miral
 #include <miral/window.h>
@@ -67,6 +68,7 @@ struct MockSurface : public StubSurface
     MOCK_CONST_METHOD0(visible, bool());
     MOCK_CONST_METHOD0(state, MirWindowState());
     MOCK_CONST_METHOD1(generate_renderables,mir::graphics::RenderableList(mir::compositor::CompositorID id));
+    MOCK_CONST_METHOD0(confine_pointer_state, MirPointerConfinementState());
 };
 
 class MirSurfaceTest : public ::testing::Test
@@ -149,6 +151,7 @@ TEST_F(MirSurfaceTest, EnsureVisiblePropertyRecalculatedAfterFrameSwap)
 struct MockWindowModelController : public StubWindowModelController
 {
     MOCK_METHOD1(requestClose, void(const miral::Window &));
+    MOCK_METHOD2(deliverPointerEvent, void(const miral::Window &, const MirPointerEvent *));
 };
 
 TEST_F(MirSurfaceTest, failedSurfaceCloseEventuallyDestroysSurface)
@@ -189,3 +192,120 @@ TEST_F(MirSurfaceTest, failedSurfaceCloseEventuallyDestroysSurface)
     surface.setLive(false);
     surface.unregisterView(view);
 }
+
+/*
+ * Test that the client gets a single event out of a batch of pointer motion events,
+ * with the latest pointer position
+ */
+TEST_F(MirSurfaceTest, pointerMotionIsMergedUntilPendingEventsAreHandled)
+{
+    int argc = 0;
+    char* argv[0];
+    QCoreApplication qtApp(argc, argv); // app for the queued flush
+
+    auto mockSurface = std::make_shared<NiceMock<MockSurface>>();
+    miral::Window mockWindow(stubSession, mockSurface);
+    ms::SurfaceCreationParameters spec;
+    miral::WindowInfo mockWindowInfo(mockWindow, spec);
+    MockWindowModelController controller;
+
+    ON_CALL(*mockSurface, confine_pointer_state())
+        .WillByDefault(Return(mir_pointer_unconfined));
+
+    qtmir::MirSurface surface(mockWindowInfo, &controller);
+
+    float deliveredX = -1;
+    EXPECT_CALL(controller, deliverPointerEvent(_, _))
+        .Times(1)
+        .WillOnce(Invoke([&deliveredX](const miral::Window &, const MirPointerEvent *event) {
+            deliveredX = mir_pointer_event_axis_value(event, mir_pointer_axis_x);
+        }));
+
+    for (int x = 1; x <= 3; ++x) {
+        QHoverEvent event(QEvent::HoverMove, QPointF(x * 10, 10), QPointF(x * 10 - 10, 10));
+        surface.hoverMoveEvent(&event);
+    }
+
+    qtApp.processEvents();
+
+    EXPECT_EQ(30, deliveredX);
+}
+
+/*
+ * Test that a client that confines the pointer gets every single motion event
+ */
+TEST_F(MirSurfaceTest, confinedPointerMotionIsNotMerged)
+{
+    int argc = 0;
+    char* argv[0];
+    QCoreApplication qtApp(argc, argv); // app for the queued flush
+
+    auto mockSurface = std::make_shared<NiceMock<MockSurface>>();
+    miral::Window mockWindow(stubSession, mockSurface);
+    ms::SurfaceCreationParameters spec;
+    miral::WindowInfo mockWindowInfo(mockWindow, spec);
+    MockWindowModelController controller;
+
+    ON_CALL(*mockSurface, confine_pointer_state())
+        .WillByDefault(Return(mir_pointer_confined_to_window));
+
+    qtmir::MirSurface surface(mockWindowInfo, &controller);
+
+    EXPECT_CALL(controller, deliverPointerEvent(_, _))
+        .Times(3);
+
+    for (int x = 1; x <= 3; ++x) {
+        QHoverEvent event(QEvent::HoverMove, QPointF(x * 10, 10), QPointF(x * 10 - 10, 10));
+        surface.hoverMoveEvent(&event);
+    }
+
+    qtApp.processEvents();
+}
+
+/*
+ * Test that the window management policy learns where an actively focused view draws the surface one to one,
+ * so that input can skip the shell, and that it forgets it as soon as that stops being the case
+ */
+TEST_F(MirSurfaceTest, directInputAreaFollowsTheActivelyFocusedView)
+{
+    int argc = 0;
+    char* argv[0];
+    QCoreApplication qtApp(argc, argv);
+
+    miral::Window mockWindow(stubSession, stubSurface);
+    ms::SurfaceCreationParameters spec;
+    miral::WindowInfo mockWindowInfo(mockWindow, spec);
+    auto extraInfo = std::make_shared<ExtraWindowInfo>();
+    mockWindowInfo.userdata(extraInfo);
+    MockWindowModelController controller;
+
+    qtmir::MirSurface surface(mockWindowInfo, &controller);
+
+    qintptr view = (qintptr)1;
+    qintptr otherView = (qintptr)2;
+    surface.registerView(view);
+    surface.registerView(otherView);
+
+    surface.setViewInputArea(view, QRect(100, 0, 800, 600));
+    EXPECT_TRUE(extraInfo->directInputArea.isNull()); // not focused
+
+    surface.setViewActiveFocus(otherView, true);
+    EXPECT_TRUE(extraInfo->directInputArea.isNull()); // the focused view doesn't draw it one to one
+
+    surface.setViewActiveFocus(view, true);
+    EXPECT_EQ(QRect(100, 0, 800, 600), extraInfo->directInputArea);
+
+    surface.setViewInputArea(view, QRect(0, 0, 800, 600));
+    EXPECT_EQ(QRect(0, 0, 800, 600), extraInfo->directInputArea);
+
+    surface.setViewInputArea(view, QRect());
+    EXPECT_TRUE(extraInfo->directInputArea.isNull());
+
+    surface.setViewInputArea(view, QRect(0, 0, 800, 600));
+    surface.unregisterView(view);
+    EXPECT_TRUE(extraInfo->directInputArea.isNull());
+
+    // clean up
+    surface.setLive(false);
+    surface.unregisterView(otherView);
+}
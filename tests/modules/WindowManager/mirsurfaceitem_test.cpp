@@ -21,6 +21,8 @@ struct MirEvent {}; // otherwise won't compile otherwise due to incomplete type
 #include <gtest/gtest.h>
 
 #include <QLoggingCategory>
+#include <QQuickWindow>
+#include <QSignalSpy>
 #include <QTest>
 #include <private/qquickitem_p.h>
 
@@ -296,3 +298,69 @@ TEST_F(MirSurfaceItemTest, AggregateSurfaceActiveFocus)
     delete surface;
     delete fakeSession;
 }
+
+/*
+  Tests that a surface drawn much smaller than its size for a while stops being
+  exposed, and that it's exposed again as soon as it's drawn bigger.
+ */
+TEST_F(MirSurfaceItemTest, SmallItemStopsBeingExposedUntilItGrows)
+{
+    QQuickWindow window;
+    FakeMirSurface *fakeSurface = new FakeMirSurface;
+    fakeSurface->resize(800, 600);
+
+    MirSurfaceItem *surfaceItem = new MirSurfaceItem;
+    surfaceItem->setParentItem(window.contentItem());
+    surfaceItem->setSize(QSizeF(800, 600));
+    surfaceItem->setSurface(fakeSurface);
+    surfaceItem->setLowDetailThreshold(0.25);
+    ASSERT_TRUE(fakeSurface->visible());
+
+    QSignalSpy lowDetailSpy(surfaceItem, SIGNAL(lowDetailChanged(bool)));
+
+    surfaceItem->setSize(QSizeF(160, 120));
+    Q_EMIT window.afterAnimating(); // as on every frame
+
+    // Not right away
+    EXPECT_FALSE(surfaceItem->lowDetail());
+    EXPECT_TRUE(fakeSurface->visible());
+
+    ASSERT_TRUE(lowDetailSpy.wait(2000));
+    EXPECT_TRUE(surfaceItem->lowDetail());
+    EXPECT_FALSE(fakeSurface->visible());
+
+    surfaceItem->setSize(QSizeF(400, 300));
+    Q_EMIT window.afterAnimating();
+
+    EXPECT_FALSE(surfaceItem->lowDetail());
+    EXPECT_TRUE(fakeSurface->visible());
+
+    delete surfaceItem;
+    delete fakeSurface;
+}
+
+TEST_F(MirSurfaceItemTest, ItemGrowingBackInTimeStaysExposed)
+{
+    QQuickWindow window;
+    FakeMirSurface *fakeSurface = new FakeMirSurface;
+    fakeSurface->resize(800, 600);
+
+    MirSurfaceItem *surfaceItem = new MirSurfaceItem;
+    surfaceItem->setParentItem(window.contentItem());
+    surfaceItem->setSize(QSizeF(160, 120));
+    surfaceItem->setSurface(fakeSurface);
+    surfaceItem->setLowDetailThreshold(0.25);
+
+    QSignalSpy lowDetailSpy(surfaceItem, SIGNAL(lowDetailChanged(bool)));
+
+    // Only briefly drawn small, as during an animation
+    surfaceItem->setSize(QSizeF(800, 600));
+    Q_EMIT window.afterAnimating();
+
+    EXPECT_FALSE(lowDetailSpy.wait(1000));
+    EXPECT_FALSE(surfaceItem->lowDetail());
+    EXPECT_TRUE(fakeSurface->visible());
+
+    delete surfaceItem;
+    delete fakeSurface;
+}